@@ -0,0 +1,35 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+
+// Just enough for the programs in checks/: a failed CHECK prints the expression and where it
+// is, the program carries on, and checkResult() turns the failures into the exit status.
+// They read puzzles.txt and solutions.txt, so run them from the top of the repository.
+
+inline int& checkFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+// Variadic so a condition may hold unparenthesized commas, as in template arguments
+#define CHECK(...)                                                                            \
+    do {                                                                                      \
+        if (!(__VA_ARGS__)) {                                                                 \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #__VA_ARGS__ "\n"; \
+            checkFailures()++;                                                                \
+        }                                                                                     \
+    } while (0)
+
+inline int checkResult(const char* name)
+{
+    if (checkFailures() > 0) {
+        std::cout << name << ": " << checkFailures() << " check(s) failed\n";
+        return 1;
+    }
+    std::cout << name << ": ok\n";
+    return 0;
+}
+
+#endif
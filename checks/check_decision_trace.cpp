@@ -0,0 +1,146 @@
+#include "Check.h"
+#include "../include/DecisionTrace.h"
+#include "../include/PuzzleManager.h"
+#include "../include/PuzzleSolver.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+// A decision trace written to a file reads back with the same header and events, and a
+// solve started from that header makes the same decisions again, as replay.out --verify
+// relies on. Damaged files are refused rather than read.
+
+namespace {
+    std::string tracePath(const std::string& name)
+    {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    bool sameEvents(const std::vector<TraceEvent>& a, const std::vector<TraceEvent>& b, bool withTimes)
+    {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            if (!a[i].sameDecision(b[i])) return false;
+            if (withTimes && a[i].deltaNanos != b[i].deltaNanos) return false;
+        }
+        return true;
+    }
+
+    std::vector<TraceEvent> decisions(const DecisionTrace& trace)
+    {
+        std::vector<TraceEvent> events = trace.orderedEvents();
+        events.erase(std::remove_if(events.begin(), events.end(),
+                                    [](const TraceEvent& e) { return e.kind() == TraceEventKind::TIME; }),
+                     events.end());
+        return events;
+    }
+
+    void checkRoundTrip(const DecisionTrace& recorded, const std::string& path)
+    {
+        CHECK(recorded.save(path));
+        DecisionTrace loaded;
+        std::string error;
+        CHECK(loaded.load(path, error));
+
+        const TraceHeader& a = recorded.getHeader();
+        const TraceHeader& b = loaded.getHeader();
+        CHECK(a.puzzleNumber == b.puzzleNumber);
+        CHECK(a.gridSize == b.gridSize);
+        CHECK(a.probeBudgetPercent == b.probeBudgetPercent);
+        CHECK(a.probeBudget == b.probeBudget);
+        CHECK(a.strategy == b.strategy);
+        CHECK(a.speculative == b.speculative);
+        CHECK(a.droppedEvents == b.droppedEvents);
+        CHECK(a.parameters.toString() == b.parameters.toString());
+        CHECK(a.original == b.original);
+        CHECK(a.masked == b.masked);
+        CHECK(sameEvents(recorded.orderedEvents(), loaded.orderedEvents(), true));
+    }
+
+    // The same steps as replay.out --verify
+    void checkReplay(const DecisionTrace& recorded)
+    {
+        const TraceHeader& header = recorded.getHeader();
+        Graph board(std::make_shared<const PuzzleGrid>(header.original), header.masked);
+        PuzzleSolver solver(board);
+        solver.setProbeStrategy(static_cast<ProbeStrategy>(header.strategy), header.beliefSamples,
+                                header.beliefThreads, header.beliefSeed);
+        solver.setParameters(header.parameters);
+        DecisionTrace replay;
+        solver.setDecisionTrace(&replay);
+        solver.solvePuzzle(header.gridSize, header.probeBudgetPercent);
+        CHECK(sameEvents(decisions(recorded), decisions(replay), false));
+    }
+
+    void corrupt(const std::string& from, const std::string& to, size_t keepBytes, size_t patchAt,
+                 const std::string& patch)
+    {
+        std::ifstream in(from, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        bytes.resize(std::min(keepBytes, bytes.size()));
+        if (patchAt + patch.size() <= bytes.size()) bytes.replace(patchAt, patch.size(), patch);
+        std::ofstream(to, std::ios::binary) << bytes;
+    }
+}
+
+int main()
+{
+    auto corpus = PuzzleManager::loadCorpus("puzzles.txt", 5);
+    std::vector<Graph> boards;
+    PuzzleManager::maskCorpus(corpus, boards, 0.3, 12345u);
+    CHECK(!boards.empty());
+
+    SolverParameters parameters;
+    parameters.set(SolverParameters::findField("strict_threshold"), 5.0);
+
+    std::string path = tracePath("check_decision_trace.qtrace");
+    for (size_t i = 0; i < boards.size(); i++) {
+        Graph board = boards[i];
+        PuzzleSolver solver(board);
+        solver.setParameters(parameters);
+        DecisionTrace trace;
+        trace.setPuzzleNumber(i + 1);
+        solver.setDecisionTrace(&trace);
+        solver.solvePuzzle(board.getSize(), 0.5);
+
+        CHECK(trace.eventCount() > 0);
+        CHECK(trace.getHeader().parameters.strictThreshold == 5.0);
+        checkRoundTrip(trace, path);
+        checkReplay(trace);
+    }
+
+    // A ring trace keeps only the last events and says how many it dropped
+    {
+        Graph board = boards[0];
+        PuzzleSolver solver(board);
+        DecisionTrace ring(16);
+        solver.setDecisionTrace(&ring);
+        solver.solvePuzzle(board.getSize(), 0.5);
+        CHECK(ring.eventCount() == 16);
+        CHECK(ring.getHeader().droppedEvents > 0);
+        checkRoundTrip(ring, path);
+    }
+
+    // Cut short, or claiming more events than it holds, the file is refused
+    DecisionTrace loaded;
+    std::string error;
+    CHECK(loaded.load(path, error));
+    size_t fileBytes = std::filesystem::file_size(path);
+    size_t countAt = fileBytes - loaded.eventCount() * sizeof(TraceEvent) - sizeof(uint64_t);
+    std::string damaged = tracePath("check_decision_trace_damaged.qtrace");
+
+    corrupt(path, damaged, fileBytes - 3, 0, "");
+    CHECK(!loaded.load(damaged, error));
+    uint64_t hugeCount = 1ull << 60;
+    corrupt(path, damaged, fileBytes, countAt, std::string(reinterpret_cast<const char*>(&hugeCount), sizeof(hugeCount)));
+    CHECK(!loaded.load(damaged, error));
+    corrupt(path, damaged, fileBytes, 0, "QTRX");
+    CHECK(!loaded.load(damaged, error));
+    CHECK(!loaded.load(tracePath("check_decision_trace_missing.qtrace"), error));
+
+    std::remove(path.c_str());
+    std::remove(damaged.c_str());
+    return checkResult("check_decision_trace");
+}
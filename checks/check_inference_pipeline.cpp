@@ -0,0 +1,111 @@
+#include "Check.h"
+#include "../include/InferencePipeline.h"
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+// A vote stopped as soon as the remaining rules cannot change the winner has the winner of a
+// vote that runs every rule, whatever order the pipeline has put the rules in by then. The
+// weights are drawn off the 1/64 grid on purpose, so the pipeline's own rounding is what
+// keeps the sums exact.
+
+namespace {
+    uint32_t mixCell(int rule, int row, int col, uint32_t seed)
+    {
+        uint32_t h = seed ^ (uint32_t)rule * 0x9e3779b9u ^ (uint32_t)row * 0x85ebca6bu ^ (uint32_t)col * 0xc2b2ae35u;
+        h ^= h >> 16;
+        h *= 0x7feb352du;
+        h ^= h >> 15;
+        h *= 0x846ca68bu;
+        return h ^ (h >> 16);
+    }
+
+    bool refused(float weight)
+    {
+        InferencePipeline pipeline(1.0f);
+        try {
+            pipeline.addRule("rule", weight, 1.0, 0);
+        } catch (const std::invalid_argument&) {
+            return true;
+        }
+        return false;
+    }
+
+    // Rules abstain at different rates and name one of a few colours, so the yields that
+    // order them drift apart as evaluations go on and close votes are common
+    void checkAgainstFullVote(uint32_t seed, int& skipped)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> weights(0.0f, 4.0f);
+        int ruleCount = 2 + rng() % (InferencePipeline::maxRules - 1);
+
+        InferencePipeline pipeline(weights(rng) * 2);
+        std::vector<int> abstainPercent;
+        for (int rule = 0; rule < ruleCount; rule++) {
+            pipeline.addRule("rule" + std::to_string(rule), weights(rng), 1.0 + rng() % 100, 1 << (rule % 8));
+            abstainPercent.push_back(rng() % 90);
+        }
+
+        auto apply = [&](int rule, int row, int col) {
+            uint32_t h = mixCell(rule, row, col, seed);
+            if ((int)(h % 100) < abstainPercent[rule]) return -1;
+            return 1 + (int)(h / 100 % 3);
+        };
+
+        int evaluations = 0;
+        for (int row = 0; row < 120; row++) {
+            for (int col = 0; col < 40; col++) {
+                uint8_t someTags = 0, allTags = 0;
+                int early = pipeline.infer(row, col, false, someTags, apply);
+                int full = pipeline.infer(row, col, true, allTags, apply);
+                CHECK(early == full);
+                CHECK((someTags & ~allTags) == 0);
+                evaluations += 2;
+
+                // Partway through, the weights change and the rules are reordered at once
+                if (evaluations == 3 * InferencePipeline::reorderInterval) {
+                    pipeline.setWeight(rng() % ruleCount, weights(rng));
+                    pipeline.setThreshold(weights(rng) * 2);
+                }
+            }
+        }
+        CHECK(evaluations > 4 * InferencePipeline::reorderInterval);
+
+        for (const InferenceRuleStats& stats : pipeline.getStats()) {
+            skipped += stats.skipped;
+        }
+    }
+}
+
+int main()
+{
+    // Sums that depend on the order in floats add up the same once rounded to the grid
+    {
+        InferencePipeline pipeline(0.59375f);
+        pipeline.addRule("a", 0.1f, 1.0, 1);
+        pipeline.addRule("b", 0.2f, 1.0, 2);
+        pipeline.addRule("c", 0.3f, 1.0, 4);
+        uint8_t tags = 0;
+        auto allSay = [](int, int, int) { return 1; };
+        CHECK(pipeline.infer(0, 0, true, tags, allSay) == -1);   // 6 + 13 + 19 = 38 sixty-fourths
+        pipeline.setThreshold(0.58f);
+        CHECK(pipeline.infer(0, 0, true, tags, allSay) == 1);
+        CHECK(tags == 7);
+    }
+
+    CHECK(refused(-0.5f));
+    CHECK(refused(NAN));
+    CHECK(refused(INFINITY));
+    CHECK(refused(InferencePipeline::maxWeight * 2));
+    CHECK(!refused(0.0f));
+    CHECK(!refused(InferencePipeline::maxWeight));
+
+    int skipped = 0;
+    for (uint32_t seed = 1; seed <= 40; seed++) {
+        checkAgainstFullVote(seed, skipped);
+    }
+    // The comparison is only worth something if votes did stop early
+    CHECK(skipped > 0);
+
+    return checkResult("check_inference_pipeline");
+}
@@ -0,0 +1,231 @@
+#include "Check.h"
+#include "../include/ProbeQueue.h"
+#include "../include/PuzzleManager.h"
+#include "../include/PuzzleSolver.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <set>
+
+// ProbeQueue against a plain map of scores: the heap keeps the same order through inserts,
+// erases and updates, equal scores go to the lower cell, and an invalidated score is kept
+// until refresh() rescores it. Then findBestProbeSpots, which keeps one queue alive for a
+// whole solve, against scoring and sorting every candidate afresh as it once did.
+
+namespace {
+    // Best first, ties to the lower cell
+    std::vector<int> expectedOrder(const std::map<int, double>& scores)
+    {
+        std::vector<int> cells;
+        for (auto& [cell, score] : scores) cells.push_back(cell);
+        std::stable_sort(cells.begin(), cells.end(),
+                         [&](int a, int b) { return scores.at(a) > scores.at(b); });
+        return cells;
+    }
+
+    void checkQueueOperations()
+    {
+        ProbeQueue queue;
+        queue.reset(8);
+        CHECK(queue.size() == 0);
+        CHECK(queue.top(3).empty());
+
+        // Equal scores come out lowest cell first, whatever order they went in
+        for (int cell : {5, 2, 7, 0}) queue.insert(cell, 1.0);
+        queue.insert(3, 2.0);
+        CHECK(queue.top(5) == std::vector<int>({3, 0, 2, 5, 7}));
+        CHECK(queue.top(2) == std::vector<int>({3, 0}));
+        CHECK(queue.top(0).empty());
+        CHECK(queue.top(10).size() == 5);
+
+        queue.update(7, 3.0);
+        queue.update(3, 0.5);
+        queue.erase(0);
+        CHECK(!queue.contains(0));
+        CHECK(queue.top(4) == std::vector<int>({7, 2, 5, 3}));
+
+        // An invalidated cell keeps its old score and place until refresh() asks for a new one,
+        // once however often it was invalidated; cells not queued are marked but not rescored
+        queue.invalidate(5);
+        queue.invalidate(5);
+        queue.invalidate(0);
+        CHECK(queue.isStale(5));
+        CHECK(queue.isStale(0));
+        CHECK(!queue.isStale(2));
+        CHECK(queue.scoreOf(5) == 1.0);
+        CHECK(queue.top(4) == std::vector<int>({7, 2, 5, 3}));
+
+        std::vector<int> rescored;
+        queue.refresh([&](int cell) {
+            rescored.push_back(cell);
+            return 4.0;
+        });
+        CHECK(rescored == std::vector<int>({5}));
+        CHECK(!queue.isStale(5));
+        CHECK(queue.top(4) == std::vector<int>({5, 7, 2, 3}));
+
+        // A cell invalidated and then erased is not rescored
+        queue.invalidate(2);
+        queue.erase(2);
+        rescored.clear();
+        queue.refresh([&](int cell) {
+            rescored.push_back(cell);
+            return 0.0;
+        });
+        CHECK(rescored.empty());
+
+        queue.invalidateAll();
+        queue.refresh([](int cell) { return (double)(cell % 2); });
+        CHECK(queue.top(3) == std::vector<int>({3, 5, 7}));
+    }
+
+    // The same operations on the queue and on a map, in a random order
+    void checkAgainstMap(unsigned seed)
+    {
+        const int cells = 64;
+        std::mt19937 rng(seed);
+        ProbeQueue queue;
+        queue.reset(cells);
+        std::map<int, double> scores;
+        std::set<int> invalidated;
+
+        for (int step = 0; step < 2000; step++) {
+            int cell = rng() % cells;
+            // Few distinct scores, so ties are common
+            double score = (double)(rng() % 6) / 2;
+
+            switch (rng() % 5) {
+                case 0:
+                case 1:
+                    if (queue.contains(cell)) {
+                        queue.update(cell, score);
+                    } else {
+                        queue.insert(cell, score);
+                    }
+                    scores[cell] = score;
+                    invalidated.erase(cell);
+                    break;
+                case 2:
+                    if (queue.contains(cell)) {
+                        queue.erase(cell);
+                        scores.erase(cell);
+                        invalidated.erase(cell);
+                    }
+                    break;
+                case 3:
+                    queue.invalidate(cell);
+                    if (scores.count(cell)) invalidated.insert(cell);
+                    break;
+                default:
+                    // Rescores exactly the queued cells invalidated since the last refresh
+                    std::set<int> rescored;
+                    queue.refresh([&](int stale) {
+                        rescored.insert(stale);
+                        return scores[stale] + 1.0;
+                    });
+                    CHECK(rescored == invalidated);
+                    for (int stale : rescored) scores[stale] += 1.0;
+                    invalidated.clear();
+                    break;
+            }
+
+            std::vector<int> order = expectedOrder(scores);
+            CHECK(queue.size() == (int)scores.size());
+            CHECK(queue.top(cells) == order);
+            order.resize(std::min<size_t>(order.size(), 3));
+            CHECK(queue.top(3) == order);
+        }
+    }
+
+    // findBestProbeSpots as it was before the queue: score the unknown viable cells and their
+    // unknown neighbours, sort by score, best first. Candidates are taken in row-major order
+    // and sorted stably, the order the queue breaks ties in.
+    std::vector<std::pair<int, int>> fullSort(PuzzleSolver& solver, Graph& board, int k,
+                                              const std::vector<std::pair<int, int>>& viablePositions)
+    {
+        const int directions[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+        int n = board.getSize();
+        std::set<std::pair<int, int>> candidates;
+        for (auto [row, col] : viablePositions) {
+            if (board.getMasked()[row][col] == -1) candidates.insert({row, col});
+            for (auto& d : directions) {
+                int nr = row + d[0], nc = col + d[1];
+                if (nr >= 0 && nr < n && nc >= 0 && nc < n && board.getMasked()[nr][nc] == -1) {
+                    candidates.insert({nr, nc});
+                }
+            }
+        }
+
+        std::vector<std::pair<double, std::pair<int, int>>> scored;
+        for (auto [row, col] : candidates) {
+            scored.push_back({solver.calculateExpectedInformationGain(row, col, n), {row, col}});
+        }
+        std::stable_sort(scored.begin(), scored.end(),
+                         [](const auto& a, const auto& b) { return a.first > b.first; });
+
+        std::vector<std::pair<int, int>> result;
+        for (int i = 0; i < std::min(k, (int)scored.size()); i++) {
+            result.push_back(scored[i].second);
+        }
+        return result;
+    }
+
+    // Every row of the board in turn, both its viable cells and all of its cells
+    void compareSpots(PuzzleSolver& solver, Graph& board)
+    {
+        int n = board.getSize();
+        for (int row = 0; row < n; row++) {
+            std::vector<std::pair<int, int>> wholeRow;
+            for (int col = 0; col < n; col++) wholeRow.push_back({row, col});
+
+            for (auto positions : {solver.findViableQueenPositions(row, n), wholeRow}) {
+                for (int k : {2, n * n}) {
+                    std::vector<std::pair<int, int>> expected = fullSort(solver, board, k, positions);
+                    CHECK(solver.findBestProbeSpots(k, positions) == expected);
+                }
+            }
+        }
+    }
+}
+
+int main()
+{
+    checkQueueOperations();
+    for (unsigned seed = 1; seed <= 3; seed++) {
+        checkAgainstMap(seed);
+    }
+
+    auto corpus = PuzzleManager::loadCorpus("puzzles.txt", 10);
+    std::vector<Graph> boards;
+    PuzzleManager::maskCorpus(corpus, boards, 0.5, 2024u);
+    CHECK(!boards.empty());
+
+    std::mt19937 rng(7);
+    for (Graph& board : boards) {
+        int n = board.getSize();
+        PuzzleSolver solver(board);
+        compareSpots(solver, board);
+
+        // Cells revealed one by one, so cached scores go stale around each of them
+        std::vector<std::pair<int, int>> hidden;
+        for (int row = 0; row < n; row++) {
+            for (int col = 0; col < n; col++) {
+                if (board.getMasked()[row][col] == -1) hidden.push_back({row, col});
+            }
+        }
+        std::shuffle(hidden.begin(), hidden.end(), rng);
+        hidden.resize(std::min<size_t>(hidden.size(), 4));
+        for (auto [row, col] : hidden) {
+            solver.observeCell(row, col, board.getOriginal()[row][col]);
+            compareSpots(solver, board);
+        }
+
+        // After a solve, with its queens and probes on the board, and back on the loaded board
+        solver.solvePuzzle(n, 0.3);
+        compareSpots(solver, board);
+        solver.resetToPristine();
+        compareSpots(solver, board);
+    }
+
+    return checkResult("check_probe_queue");
+}
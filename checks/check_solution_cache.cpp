@@ -0,0 +1,166 @@
+#include "Check.h"
+#include "../include/PuzzleManager.h"
+#include "../include/PuzzleSolver.h"
+#include "../include/SolutionCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+
+// Every rotation, reflection and recolouring of a board has the same canonical form, and a
+// solution cached for one of them comes back placed correctly on all the others, before and
+// after the cache is written to a file and mapped back in.
+
+namespace {
+    // Written apart from SolutionCache's own, so the two are checked against each other:
+    // quarter turns for t & 3, then a mirror of the rows when bit 2 is set
+    std::pair<int, int> symmetry(int t, int n, int row, int col)
+    {
+        for (int k = 0; k < (t & 3); k++) {
+            int turned = col;
+            col = n - 1 - row;
+            row = turned;
+        }
+        if (t & 4) row = n - 1 - row;
+        return {row, col};
+    }
+
+    PuzzleGrid transformBoard(const PuzzleGrid& board, int t)
+    {
+        int n = board.size();
+        PuzzleGrid out(n, std::vector<int>(n));
+        for (int r = 0; r < n; r++) {
+            for (int c = 0; c < n; c++) {
+                auto [row, col] = symmetry(t, n, r, c);
+                out[row][col] = board[r][c];
+            }
+        }
+        return out;
+    }
+
+    // Colour k becomes n + 1 - k
+    PuzzleGrid recolour(PuzzleGrid board)
+    {
+        int n = board.size();
+        for (auto& row : board) {
+            for (int& colour : row) colour = n + 1 - colour;
+        }
+        return board;
+    }
+
+    std::set<std::pair<int, int>> transformQueens(const std::vector<std::pair<int, int>>& queens, int t, int n)
+    {
+        std::set<std::pair<int, int>> out;
+        for (auto [row, col] : queens) out.insert(symmetry(t, n, row, col));
+        return out;
+    }
+
+    void checkCanonicalForm(const PuzzleGrid& board)
+    {
+        int n = board.size();
+        CanonicalBoard base = CanonicalBoard::of(board);
+        CHECK(base.size == n);
+        CHECK((int)base.cells.size() == n * n);
+
+        // Canonical colours are numbered in first-seen order, so the first cell is colour 1
+        // and the relabelling is one to one
+        CHECK(base.cells[0] == 1);
+        std::map<int, int> toCanonicalColour;
+        for (int r = 0; r < n; r++) {
+            for (int c = 0; c < n; c++) {
+                auto [row, col] = base.toOriginal(r, c);
+                CHECK(base.toCanonical(row, col) == std::make_pair(r, c));
+                auto [it, inserted] = toCanonicalColour.insert({board[row][col], base.cells[r * n + c]});
+                CHECK(it->second == base.cells[r * n + c]);
+            }
+        }
+        std::set<int> canonicalColours;
+        for (auto [colour, canonical] : toCanonicalColour) canonicalColours.insert(canonical);
+        CHECK(canonicalColours.size() == toCanonicalColour.size());
+
+        for (int t = 0; t < CanonicalBoard::transformCount; t++) {
+            for (const PuzzleGrid& variant : {transformBoard(board, t), recolour(transformBoard(board, t))}) {
+                CanonicalBoard other = CanonicalBoard::of(variant);
+                CHECK(other.cells == base.cells);
+                CHECK(other.hash == base.hash);
+            }
+        }
+    }
+
+    void checkLookups(SolutionCache& cache, const PuzzleGrid& board, const std::vector<std::pair<int, int>>& solution)
+    {
+        int n = board.size();
+        for (int t = 0; t < CanonicalBoard::transformCount; t++) {
+            PuzzleGrid variant = recolour(transformBoard(board, t));
+            bool solved = false;
+            std::vector<std::pair<int, int>> queens;
+            CHECK(cache.lookup(variant, solved, queens));
+            CHECK(solved);
+            CHECK(std::set<std::pair<int, int>>(queens.begin(), queens.end()) == transformQueens(solution, t, n));
+        }
+    }
+}
+
+int main()
+{
+    auto corpus = PuzzleManager::loadCorpus("puzzles.txt", 20);
+    auto solutions = PuzzleSolver::loadSolutions("solutions.txt");
+    CHECK(!corpus.empty());
+
+    SolutionCache cache;
+    std::vector<int> cached;
+    for (size_t i = 0; i < corpus.size(); i++) {
+        const PuzzleGrid& board = *corpus[i];
+        checkCanonicalForm(board);
+
+        auto it = solutions.find(i + 1);
+        if (it == solutions.end() || (int)it->second.size() != (int)board.size()) continue;
+        cache.insert(board, true, it->second);
+        checkLookups(cache, board, it->second);
+        cached.push_back(i);
+    }
+    CHECK(!cached.empty());
+
+    // A board with no solution is remembered as such
+    PuzzleGrid unsolvable(4, std::vector<int>(4, 1));
+    cache.insert(unsolvable, false, {});
+    bool solved = true;
+    std::vector<std::pair<int, int>> queens = {{0, 0}};
+    CHECK(cache.lookup(unsolvable, solved, queens));
+    CHECK(!solved);
+    CHECK(queens.empty());
+
+    PuzzleGrid unseen(4, std::vector<int>(4, 2));
+    unseen[0][0] = 1;
+    CHECK(!cache.lookup(unseen, solved, queens));
+
+    // Written out and mapped back in, the same lookups hit the file
+    std::string path = (std::filesystem::temp_directory_path() / "check_solution_cache.qsol").string();
+    std::string error;
+    CHECK(cache.save(path, error));
+    SolutionCache reopened;
+    CHECK(reopened.open(path, error));
+    CHECK(reopened.size() == cache.size());
+    for (int i : cached) {
+        checkLookups(reopened, *corpus[i], solutions[i + 1]);
+    }
+    CHECK(reopened.lookup(unsolvable, solved, queens) && !solved);
+    CHECK(reopened.getStats().misses == 0);
+    std::remove(path.c_str());
+
+    // A missing file is an empty cache, anything else that is not a cache is refused
+    SolutionCache missing;
+    CHECK(missing.open(path, error));
+    CHECK(missing.size() == 0);
+    {
+        std::ofstream out(path);
+        out << "not a cache, but long enough to hold a header\n";
+    }
+    SolutionCache wrong;
+    CHECK(!wrong.open(path, error));
+    std::remove(path.c_str());
+
+    return checkResult("check_solution_cache");
+}
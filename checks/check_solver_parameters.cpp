@@ -0,0 +1,82 @@
+#include "Check.h"
+#include "../include/SolverParameters.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+// Parameter files: what is read, what is clamped and rounded, what is refused, and that a
+// saved file loads back to the same values.
+
+namespace {
+    std::string path = (std::filesystem::temp_directory_path() / "check_solver_parameters.txt").string();
+
+    bool loadText(SolverParameters& parameters, const std::string& text, std::string& error)
+    {
+        std::ofstream(path) << text;
+        return parameters.load(path, error);
+    }
+}
+
+int main()
+{
+    const SolverParameters defaults;
+    std::string error;
+
+    // Every field is found by its name and keeps a value inside its range
+    for (int i = 0; i < SolverParameters::fieldCount; i++) {
+        CHECK(SolverParameters::findField(SolverParameters::fields[i].name) == i);
+        SolverParameters changed;
+        changed.set(i, SolverParameters::fields[i].min);
+        CHECK(changed.get(i) == SolverParameters::fields[i].min);
+    }
+    CHECK(SolverParameters::findField("no_such_field") == -1);
+
+    // Comments, blank lines and spacing are skipped; fields left out keep their defaults
+    SolverParameters loaded;
+    CHECK(loadText(loaded,
+                   "# written by hand\n"
+                   "\n"
+                   "  strict_threshold = 5.25   # a comment after the value\n"
+                   "probe_corner=3\n",
+                   error));
+    CHECK(loaded.strictThreshold == 5.25);
+    CHECK(loaded.cornerBonus == 3.0);
+    CHECK(loaded.edgeBonus == defaults.edgeBonus);
+    CHECK(loaded.strictWeights[0] == defaults.strictWeights[0]);
+
+    // Values are clamped to the range and rounded to the step
+    CHECK(loadText(loaded, "strict_threshold = 4.51\nprobes_per_round = 2.6\nprobe_edge = 100\nweak_accept = -1\n", error));
+    CHECK(loaded.strictThreshold == 289.0 / 64);
+    CHECK(loaded.probesPerRound == 3);
+    CHECK(loaded.edgeBonus == SolverParameters::fields[SolverParameters::findField("probe_edge")].max);
+    CHECK(loaded.weakAccept == 0.0);
+
+    // A bad line is reported with its place, and leaves the parameters as they were
+    SolverParameters before = loaded;
+    CHECK(!loadText(loaded, "probe_corner = 2\nno_such_field = 1\n", error));
+    CHECK(error.find(":2:") != std::string::npos);
+    CHECK(!loadText(loaded, "probe_corner = many\n", error));
+    CHECK(error.find("needs a number") != std::string::npos);
+    CHECK(!loadText(loaded, "probe_corner = 1 2\n", error));
+    CHECK(!loadText(loaded, "probe_corner\n", error));
+    CHECK(loaded.toString() == before.toString());
+    std::remove(path.c_str());
+    CHECK(!loaded.load(path, error));
+
+    // Saved with a comment, the file loads back to identical values
+    SolverParameters tuned;
+    for (int i = 0; i < SolverParameters::fieldCount; i++) {
+        const SolverParameters::Field& field = SolverParameters::fields[i];
+        tuned.set(i, field.min + (field.max - field.min) * (i + 1) / (SolverParameters::fieldCount + 1));
+    }
+    CHECK(tuned.save(path, "two lines\nof comment"));
+    SolverParameters reloaded;
+    CHECK(reloaded.load(path, error));
+    CHECK(reloaded.toString() == tuned.toString());
+    for (int i = 0; i < SolverParameters::fieldCount; i++) {
+        CHECK(reloaded.get(i) == tuned.get(i));
+    }
+    std::remove(path.c_str());
+
+    return checkResult("check_solver_parameters");
+}
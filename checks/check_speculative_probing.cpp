@@ -0,0 +1,63 @@
+#include "Check.h"
+#include "../include/PuzzleManager.h"
+#include "../include/PuzzleSolver.h"
+#include <chrono>
+
+// A speculative solve searches on guessed colours while a probe is in flight, then unwinds
+// whatever it did on a wrong guess. Puzzle by puzzle it has to end where a solve that waits
+// for every probe ends: the same probes spent, the same inferences, the same queens.
+
+namespace {
+    struct Outcome
+    {
+        bool solved = false;
+        PuzzleStatistics stats;
+        std::vector<int> queens;
+    };
+
+    Outcome solve(Graph board, bool speculative, int& guesses, int& mispredicted)
+    {
+        PuzzleSolver solver(board);
+        // Long enough that no answer is ready when it is asked for
+        solver.setProbeLatency(std::chrono::microseconds(200));
+        solver.setSpeculativeProbing(speculative);
+
+        Outcome outcome;
+        outcome.solved = solver.solvePuzzle(board.getSize(), 0.3);
+        outcome.stats = solver.collectStatistics(0, outcome.solved, {});
+        for (int row = 0; row < board.getSize(); row++) {
+            outcome.queens.push_back(board.queenColumn(row));
+        }
+        guesses += solver.speculativeProbes;
+        mispredicted += solver.mispredictedProbes;
+        return outcome;
+    }
+}
+
+int main()
+{
+    auto corpus = PuzzleManager::loadCorpus("puzzles.txt", 12);
+    std::vector<Graph> boards;
+    PuzzleManager::maskCorpus(corpus, boards, 0.4, 91u);
+    CHECK(!boards.empty());
+
+    int guesses = 0, mispredicted = 0, unused = 0;
+    for (const Graph& board : boards) {
+        Outcome blocking = solve(board, false, unused, unused);
+        Outcome speculative = solve(board, true, guesses, mispredicted);
+
+        CHECK(speculative.solved == blocking.solved);
+        CHECK(speculative.queens == blocking.queens);
+        CHECK(speculative.stats.probesUsed == blocking.stats.probesUsed);
+        CHECK(speculative.stats.probesDiscarded == 0);
+        CHECK(speculative.stats.inferences == blocking.stats.inferences);
+        CHECK(speculative.stats.backtracks == blocking.stats.backtracks);
+        CHECK(speculative.stats.queensPlaced == blocking.stats.queensPlaced);
+    }
+
+    // Both the confirmed and the rolled back path have been through the comparison
+    CHECK(guesses > mispredicted);
+    CHECK(mispredicted > 0);
+
+    return checkResult("check_speculative_probing");
+}
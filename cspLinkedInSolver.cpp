@@ -1,110 +1,35 @@
 #include "include/PuzzleManager.h"
-#include "include/graph.h"
+#include "include/CSPLinkedInSolver.h"
+#include "include/SolutionCache.h"
 #include <iostream>
 #include <fstream>
 #include <vector>
-#include <set>
 
-// Pure CSP solver without any masking or active sensing
-// Solves LinkedIn Queens puzzle with complete information
+// Generates solutions.txt from puzzles.txt with the complete-information CSP solver.
+// --cache=<file> answers puzzles already in a solution cache (cache.out) without solving,
+// including rotated, reflected or recoloured copies, and adds the ones it solves.
 
-class CSPLinkedInSolver {
-private:
-    Graph& puzzle;
-    int n;
-    std::vector<std::vector<int>> board;  // Working board state
-    std::vector<std::pair<int, int>> solution;  // Queen positions
-
-    bool isValid(int row, int col) {
-        int cellColour = puzzle.getOriginal()[row][col];
-
-        // Check if another queen already placed in same column
-        for (int r = 0; r < n; r++) {
-            if (r != row && board[r][col] == 1) {
-                return false;
-            }
-        }
-
-        // Check diagonal adjacency (LinkedIn rule: only diagonal touching forbidden)
-        for (int r = 0; r < n; r++) {
-            for (int c = 0; c < n; c++) {
-                if (board[r][c] == 1) {
-                    // Check if diagonally adjacent
-                    if (abs(row - r) == 1 && abs(col - c) == 1) {
-                        return false;
-                    }
-                }
-            }
-        }
-
-        // Check colour constraint: no other queen in same colour region
-        for (int r = 0; r < n; r++) {
-            for (int c = 0; c < n; c++) {
-                if (board[r][c] == 1) {
-                    if (puzzle.getOriginal()[r][c] == cellColour) {
-                        return false;  // Another queen in same colour
-                    }
-                }
-            }
-        }
-
-        return true;
-    }
-
-    bool solveBacktrack(int row) {
-        if (row == n) {
-            return true;  // All queens placed
-        }
+int main(int argc, char* argv[]) {
+    std::string filename = "puzzles.txt";
+    int numPuzzles = 100;
+    std::vector<Graph> puzzles;
 
-        // Try each column in this row
-        for (int col = 0; col < n; col++) {
-            if (isValid(row, col)) {
-                // Place queen
-                board[row][col] = 1;
-                solution.push_back({row, col});
-
-                // Recurse
-                if (solveBacktrack(row + 1)) {
-                    return true;
-                }
-
-                // Backtrack
-                board[row][col] = 0;
-                solution.pop_back();
-            }
+    std::string cachePath;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--cache=", 0) == 0) {
+            cachePath = arg.substr(8);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--cache=<file>]" << std::endl;
+            return 1;
         }
-
-        return false;  // No solution from this state
     }
-
-public:
-    CSPLinkedInSolver(Graph& g) : puzzle(g), n(g.getSize()) {
-        // Initialize empty board
-        board.resize(n, std::vector<int>(n, 0));
-    }
-
-    bool solve() {
-        solution.clear();
-        return solveBacktrack(0);
-    }
-
-    std::vector<std::pair<int, int>> getSolution() const {
-        return solution;
-    }
-
-    void printSolution() const {
-        std::cout << "Solution (row,col): ";
-        for (const auto& [r, c] : solution) {
-            std::cout << "(" << r << "," << c << ") ";
-        }
-        std::cout << std::endl;
+    SolutionCache cache;
+    std::string cacheError;
+    if (!cachePath.empty() && !cache.open(cachePath, cacheError)) {
+        std::cerr << "Error: " << cacheError << std::endl;
+        return 1;
     }
-};
-
-int main() {
-    std::string filename = "puzzles.txt";
-    int numPuzzles = 100;
-    std::vector<Graph> puzzles;
 
     PuzzleManager::loadFromFile(filename, numPuzzles, puzzles);
 
@@ -125,8 +50,16 @@ int main() {
 
         std::cout << "Puzzle " << (idx + 1) << " (" << n << "x" << n << ")... ";
 
-        CSPLinkedInSolver solver(puzzle);
-        bool solved = solver.solve();
+        bool solved = false;
+        std::vector<std::pair<int, int>> solution;
+        if (!cachePath.empty() && cache.lookup(puzzle.getOriginal(), solved, solution)) {
+            std::cout << "(cached) ";
+        } else {
+            CSPLinkedInSolver solver(puzzle);
+            solved = solver.solve();
+            if (solved) solution = solver.getSolution();
+            if (!cachePath.empty()) cache.insert(puzzle.getOriginal(), solved, solution);
+        }
 
         if (solved) {
             std::cout << "✅ SOLVED" << std::endl;
@@ -136,7 +69,6 @@ int main() {
             outFile << "PUZZLE " << (idx + 1) << " SOLVED" << std::endl;
             outFile << "SIZE " << n << std::endl;
 
-            auto solution = solver.getSolution();
             for (const auto& [r, c] : solution) {
                 outFile << r << " " << c << std::endl;
             }
@@ -154,10 +86,20 @@ int main() {
 
     outFile.close();
 
+    if (!cachePath.empty() && !cache.save(cachePath, cacheError)) {
+        std::cerr << "Error: " << cacheError << std::endl;
+        return 1;
+    }
+
     std::cout << "\n=== RESULTS ===" << std::endl;
     std::cout << "Solved: " << solvedCount << "/" << puzzles.size() << std::endl;
     std::cout << "Success rate: " << (double)solvedCount / puzzles.size() * 100 << "%" << std::endl;
     std::cout << "\nGround truth solutions saved to solutions.txt" << std::endl;
+    if (!cachePath.empty()) {
+        const SolutionCache::Stats& stats = cache.getStats();
+        std::cout << "Cache: " << stats.hits << " hits, " << stats.misses << " misses, " << cache.size()
+                  << " entries in " << cachePath << std::endl;
+    }
 
     return 0;
 }
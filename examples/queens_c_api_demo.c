@@ -0,0 +1,90 @@
+/* Solves one board with libqueens from plain C, on several threads at once with one
+ * handle each, under a deadline.
+ *
+ *     make lib
+ *     gcc examples/queens_c_api_demo.c -Iinclude -Lbin -lqueens -lpthread -o bin/queens_demo
+ *     LD_LIBRARY_PATH=bin ./bin/queens_demo
+ */
+
+#include "queens.h"
+#include <pthread.h>
+#include <stdio.h>
+
+#define N 8
+#define THREADS 4
+
+static const int board[N * N] = {
+    1, 1, 2, 2, 2, 3, 3, 3,
+    1, 4, 2, 4, 2, 5, 3, 3,
+    1, 4, 2, 4, 2, 3, 3, 3,
+    1, 4, 4, 4, 2, 6, 7, 3,
+    1, 4, 4, 4, 2, 6, 7, 7,
+    1, 4, 8, 4, 2, 6, 7, 7,
+    8, 4, 8, 4, 2, 6, 6, 7,
+    8, 8, 8, 8, 7, 7, 7, 7,
+};
+
+struct job
+{
+    unsigned int seed;
+    int result;
+    int columns[N];
+    queens_stats stats;
+};
+
+static void* solve(void* argument)
+{
+    struct job* job = argument;
+    queens_solver* solver = queens_create();
+    if (!solver) {
+        job->result = QUEENS_ERR_INTERNAL;
+        return NULL;
+    }
+
+    queens_load_board(solver, board, N);
+    queens_set_masking(solver, 0.3, job->seed);
+    queens_set_probe_budget(solver, 0.5);
+    queens_set_deadline_ms(solver, 2000.0);
+
+    job->result = queens_solve(solver);
+    if (job->result < 0) {
+        fprintf(stderr, "seed %u: %s\n", job->seed, queens_last_error(solver));
+    } else {
+        queens_get_queens(solver, job->columns, N);
+        queens_get_stats(solver, &job->stats, sizeof(job->stats));
+    }
+    queens_destroy(solver);
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t threads[THREADS];
+    struct job jobs[THREADS];
+
+    if (queens_abi_version() != QUEENS_ABI_VERSION) {
+        fprintf(stderr, "libqueens ABI %d, built against %d\n", queens_abi_version(), QUEENS_ABI_VERSION);
+        return 1;
+    }
+
+    for (int t = 0; t < THREADS; t++) {
+        jobs[t].seed = 100 + t;
+        pthread_create(&threads[t], NULL, solve, &jobs[t]);
+    }
+    for (int t = 0; t < THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    for (int t = 0; t < THREADS; t++) {
+        const struct job* job = &jobs[t];
+        if (job->result < 0) continue;
+        printf("seed %u: %s%s, queens", job->seed, job->result ? "solved" : "not solved",
+               job->stats.timed_out ? " (deadline)" : "");
+        for (int row = 0; row < N; row++) {
+            printf(" %d", job->columns[row]);
+        }
+        printf(", %d probes, %d backtracks, %.2f ms\n", job->stats.probes_used, job->stats.backtracks,
+               job->stats.solve_ms);
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Heap activity attributed to what the thread was doing. The counting itself is done by
+// replacement operator new/delete in AllocationHooks.cpp, which is only linked into a
+// binary built with make ALLOC_TRACK=1; without it the scopes below still run but every
+// counter stays zero.
+
+enum class AllocPhase
+{
+    LOADING,           // reading puzzles and setting up solvers
+    MASKING,           // building masked boards
+    SEARCH,            // the solver phases, following SolvePhase
+    INFERENCE,
+    PROBE_SELECTION,
+    PROBE_WAIT,
+    REPORTING,         // statistics, console output and result records
+    OTHER,
+    COUNT
+};
+
+enum class AllocComponent
+{
+    SOLVER,            // PuzzleSolver
+    GRAPH,             // Graph
+    MANAGER,           // PuzzleManager
+    OTHER,
+    COUNT
+};
+
+// Peak live bytes is the highest live heap of the whole block seen while the phase or
+// component was active; live heap counts usable block sizes, so it is slightly above the
+// requested bytes.
+struct AllocationStats
+{
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    uint64_t bytes = 0;          // requested
+    int64_t peakLiveBytes = 0;
+
+    void merge(const AllocationStats& other);
+};
+
+// One block per unit of work (a puzzle, a run). Blocks are only written by the thread
+// they are attached to; merging sums the counts and keeps the highest peaks.
+struct AllocationCounters
+{
+    static const int phaseCount = (int)AllocPhase::COUNT;
+    static const int componentCount = (int)AllocComponent::COUNT;
+
+    AllocationStats byPhase[phaseCount];
+    AllocationStats byComponent[componentCount];
+    int64_t liveBytes = 0;       // relative to when the block was attached, may go negative
+    int64_t peakLiveBytes = 0;
+
+    void merge(const AllocationCounters& other);
+    AllocationStats total() const;
+
+    static const char* phaseName(AllocPhase phase);
+    static const char* componentName(AllocComponent component);
+};
+
+class AllocationTracker
+{
+public:
+    // What the calling thread charges its allocations to; allocations made without a
+    // block are not counted
+    struct Context
+    {
+        AllocationCounters* counters = nullptr;
+        AllocPhase phase = AllocPhase::OTHER;
+        AllocComponent component = AllocComponent::OTHER;
+    };
+
+    // True when the operator new/delete hooks are linked into this binary
+    static bool installed();
+    static void markInstalled();
+
+    static Context current();
+    static void enter(const Context& context);
+
+    // Called by the hooks
+    static void recordAllocation(size_t requested, size_t usable);
+    static void recordFree(size_t usable);
+
+    // Switches phase and component, and optionally the block, until the end of the scope
+    class Scope
+    {
+    private:
+        Context previous;
+
+    public:
+        Scope(AllocPhase phase, AllocComponent component);
+        Scope(AllocationCounters& counters, AllocPhase phase, AllocComponent component);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef BELIEF_ENGINE_H
+#define BELIEF_ENGINE_H
+
+#include <vector>
+#include <utility>
+#include <random>
+
+// Monte Carlo belief over the hidden board. Samples full colourings that agree with
+// every observed cell and admit a legal queen placement, then scores probe candidates
+// by how much their colour tells us about the placement (mutual information).
+class BeliefEngine
+{
+private:
+    struct Sample
+    {
+        std::vector<int> colours;     // row-major colouring, n * n
+        std::vector<int> queenCols;   // queen column per row
+    };
+
+    int numSamples;
+    int numThreads;
+    unsigned int seed;
+
+    // Helper threads shared by every engine in the process, started at the first parallel
+    // update and kept, so a search node does not pay for creating threads and a batch of
+    // solvers does not hold a set of idle threads each
+    struct WorkerPool;
+    static WorkerPool& sharedPool();
+
+    int n = 0;
+    int numColours = 0;
+    std::vector<Sample> samples;
+    std::vector<int> solutionIds;                 // sample -> distinct placement id
+    std::vector<std::vector<int>> colourCounts;   // cell -> colour -> samples
+
+    bool sampleColouring(const std::vector<std::vector<int>>& masked, std::mt19937& gen,
+                         std::vector<int>& colours);
+    bool sampleQueens(const std::vector<int>& colours, std::mt19937& gen,
+                      std::vector<int>& queenCols);
+    void drawSamples(const std::vector<std::vector<int>>& masked, int count,
+                     unsigned int workerSeed, std::vector<Sample>& out);
+
+public:
+    BeliefEngine(int samples = 256, int threads = 0, unsigned int seed = 5489u);
+    BeliefEngine(BeliefEngine&& other) noexcept;
+    BeliefEngine& operator=(BeliefEngine&& other) noexcept;
+    ~BeliefEngine();
+
+    // Below this many samples, or while the shared helpers are busy with another engine's
+    // update, an update draws every batch on the calling thread; the batches and their
+    // seeds are the same either way, so the belief does not change
+    static const int parallelSampleThreshold = 64;
+
+    // Resample the belief from the current observations (-1 = unknown)
+    void update(const std::vector<std::vector<int>>& masked);
+
+    int acceptedSamples() const;
+
+    // Settings and the seed the next update will use, enough to rebuild an identical engine
+    int sampleCount() const;
+    int threadCount() const;
+    unsigned int nextSeed() const;
+    double colourProbability(int row, int col, int colour) const;
+    double colourEntropy(int row, int col) const;
+    double expectedInformationGain(int row, int col) const;
+
+    // Best k candidates by expected information gain about the queen placement
+    std::vector<std::pair<int, int>> rankProbes(const std::vector<std::pair<int, int>>& candidates, int k) const;
+};
+
+#endif
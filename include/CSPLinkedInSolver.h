@@ -0,0 +1,28 @@
+#ifndef CSP_LINKEDIN_SOLVER_H
+#define CSP_LINKEDIN_SOLVER_H
+
+#include "graph.h"
+#include <iostream>
+#include <vector>
+
+// Pure CSP solver without any masking or active sensing
+// Solves LinkedIn Queens puzzle with complete information
+class CSPLinkedInSolver {
+private:
+    Graph& puzzle;
+    int n;
+    std::vector<std::vector<int>> board;  // Working board state
+    std::vector<std::pair<int, int>> solution;  // Queen positions
+
+    bool isValid(int row, int col);
+    bool solveBacktrack(int row);
+
+public:
+    CSPLinkedInSolver(Graph& g);
+
+    bool solve();
+    std::vector<std::pair<int, int>> getSolution() const;
+    void printSolution() const;
+};
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef DECISION_TRACE_H
+#define DECISION_TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SolverParameters.h"
+
+// Every decision of one solve, recorded compactly enough to leave on for whole batches.
+// The header holds the board exactly as the solve started, so bin/replay.out can re-run it
+// and summarize where the time and the backtracks went.
+
+enum class TraceEventKind : uint8_t
+{
+    PROBE,    // value: colour returned (or predicted, for a speculative probe)
+    INFER,    // value: colour; flags: the rules that agreed on it (TraceRule bits)
+    PLACE,    // queen placed at (row, col)
+    UNDO,     // queen at (row, col) taken back
+    PRUNE,    // col -1: no viable cell in row; otherwise the candidate was rejected (TracePrune)
+    REVERT,   // trail rollback: (row, col) back to value; TRACE_REVERT_QUEEN for queen entries
+    END,      // value: 1 when solved
+    TIME,     // padding for a gap too long for one event's delta
+    COUNT
+};
+
+// Inference rules, as flags on INFER events
+enum TraceRule : uint8_t
+{
+    TRACE_RULE_NEIGHBOURS = 1,
+    TRACE_RULE_UNIFORMITY = 2,
+    TRACE_RULE_DOMAINS = 4,
+    TRACE_RULE_CONTIGUITY = 8,
+    TRACE_RULE_PATTERN = 16,
+};
+const int traceRuleCount = 5;
+
+// Flags on the other events
+enum TraceFlag : uint8_t
+{
+    TRACE_PROBE_SPECULATIVE = 1,   // predicted colour written before the oracle answered
+    TRACE_PROBE_CORRECTION = 2,    // actual colour written after a misprediction
+    TRACE_PROBE_EXTERNAL = 4,      // observeCell
+    TRACE_REVERT_QUEEN = 1,
+};
+
+// Why a candidate was rejected (flags on PRUNE events)
+enum TracePrune : uint8_t
+{
+    TRACE_PRUNE_EMPTY_ROW = 0,
+    TRACE_PRUNE_UNKNOWN_COLOUR = 1,
+    TRACE_PRUNE_COLOUR_TAKEN = 2,
+    TRACE_PRUNE_ATTACKED = 3,
+    TRACE_PRUNE_KNOWN_FAILURE = 4,   // node state already failed in this solve (row only)
+};
+
+const int tracePruneCount = 5;
+
+// 8 bytes: nanoseconds since the previous event, kind in the low 3 bits of kindFlags and
+// flags in the high 5, then the cell and a value; -1 is stored as 255
+struct TraceEvent
+{
+    uint32_t deltaNanos;
+    uint8_t kindFlags;
+    uint8_t row;
+    uint8_t col;
+    uint8_t value;
+
+    TraceEventKind kind() const { return static_cast<TraceEventKind>(kindFlags & 7); }
+    int flags() const { return kindFlags >> 3; }
+    int rowIndex() const { return row == 255 ? -1 : row; }
+    int colIndex() const { return col == 255 ? -1 : col; }
+    int valueIndex() const { return value == 255 ? -1 : value; }
+
+    // Same decision, ignoring time
+    bool sameDecision(const TraceEvent& other) const;
+
+    static const char* kindName(TraceEventKind kind);
+};
+
+// What a solve started from and how it was configured
+struct TraceHeader
+{
+    static const uint32_t magic = 0x43525451;   // "QTRC"
+    static const uint16_t version = 2;   // 1 had no parameters: the defaults applied
+
+    int puzzleNumber = 0;
+    int gridSize = 0;
+    double probeBudgetPercent = 0.0;
+    int probeBudget = 0;
+    int strategy = 0;                 // ProbeStrategy
+    int beliefSamples = 0;
+    int beliefThreads = 0;
+    unsigned int beliefSeed = 0;
+    bool speculative = false;         // probe results may arrive in a different order on replay
+    bool pooledBudget = false;        // budget depended on the rest of the batch
+    bool concurrent = false;          // deltas include time other solves ran on the thread
+    uint64_t droppedEvents = 0;       // ring buffer overflow: the oldest events are gone
+    SolverParameters parameters;
+    std::vector<std::vector<int>> original;
+    std::vector<std::vector<int>> masked;
+};
+
+class DecisionTrace
+{
+private:
+    TraceHeader header;
+    std::vector<TraceEvent> events;
+    size_t ringCapacity;               // 0 keeps every event
+    size_t ringStart = 0;
+    bool recording = false;
+    std::chrono::steady_clock::time_point lastEvent;
+
+    void append(const TraceEvent& event);
+
+public:
+    // With a capacity the trace is a ring buffer that keeps the last ringEvents events
+    explicit DecisionTrace(size_t ringEvents = 0);
+
+    void begin(const TraceHeader& start);
+    void end(bool solved);
+    bool isRecording() const { return recording; }
+
+    void record(TraceEventKind kind, int row, int col, int value, int flags = 0)
+    {
+        if (!recording) return;
+        auto now = std::chrono::steady_clock::now();
+        uint64_t delta = std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastEvent).count();
+        lastEvent = now;
+        while (delta > UINT32_MAX) {
+            append({UINT32_MAX, (uint8_t)TraceEventKind::TIME, 255, 255, 255});
+            delta -= UINT32_MAX;
+        }
+        append({(uint32_t)delta, (uint8_t)((uint8_t)kind | (flags << 3)), (uint8_t)row, (uint8_t)col, (uint8_t)value});
+    }
+
+    const TraceHeader& getHeader() const;
+    void setPuzzleNumber(int puzzleNumber);
+
+    // Oldest first
+    std::vector<TraceEvent> orderedEvents() const;
+    size_t eventCount() const;
+
+    // Binary file: header, both boards, then the events
+    bool save(const std::string& path) const;
+    bool load(const std::string& path, std::string& error);
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef INFERENCE_PIPELINE_H
+#define INFERENCE_PIPELINE_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One rule's share of the evaluations since the stats were last reset
+struct InferenceRuleStats
+{
+    std::string name;
+    uint64_t calls = 0;      // times the rule ran
+    uint64_t yields = 0;     // ... and named a colour
+    uint64_t agreed = 0;     // ... which was the colour inferred
+    uint64_t skipped = 0;    // evaluations settled before the rule's turn came
+    double millis = 0.0;     // estimated from the timed calls
+
+    void merge(const InferenceRuleStats& other);
+};
+
+// A weighted vote of inference rules on one cell's colour. Each rule names a colour or
+// abstains, the colour it names gains the rule's weight, and the colour with the largest
+// total wins if that total is above the threshold (the lower colour on a tie).
+//
+// Rules run in order of weight times observed yield over declared cost, re-sorted every
+// reorderInterval evaluations. An evaluation stops as soon as the rules still to run can
+// no longer change the winner (nothing can reach the threshold, or the leader can no
+// longer be caught), so the order changes the time taken but never the answer.
+//
+// That needs every sum of weights to come out the same whatever order it is added in, so
+// weights and the threshold are rounded to multiples of weightStep and limited to maxWeight:
+// float sums of such values are exact. Negative or non-finite values are refused.
+class InferencePipeline
+{
+public:
+    static const int maxRules = 8;
+    static constexpr float weightStep = 1.0f / 64;
+    static constexpr float maxWeight = 4096.0f;
+    static const int reorderInterval = 1024;
+    static const int timingStride = 64;   // every 64th call of a rule is timed
+
+private:
+    struct Rule
+    {
+        float weight = 0.0f;
+        double cost = 1.0;      // declared, relative to the other rules
+        uint8_t tag = 0;        // reported back when the rule agrees with the answer
+        InferenceRuleStats stats;
+        uint64_t timedCalls = 0;
+        uint64_t timedNanos = 0;
+        uint64_t lifetimeCalls = 0;    // kept across resetStats, for the ordering
+        uint64_t lifetimeYields = 0;
+    };
+
+    std::vector<Rule> rules;
+    float threshold;
+    int order[maxRules];            // rule numbers, next to run first
+    float weightFrom[maxRules + 1]; // total weight of order[i..]
+    uint64_t evaluations = 0;
+
+    // The vote in progress: at most one entry per rule
+    int voteColours[maxRules];
+    float voteWeights[maxRules];
+    int voteCount = 0;
+
+    static float onGrid(float value);
+    void vote(int rule, int colour);
+    bool settled(int position) const;
+    int finishVote(int ranUpTo, uint8_t& tags, const int* named);
+    void reorder();
+
+public:
+    explicit InferencePipeline(float voteThreshold);
+
+    // Rules are numbered in the order they are added; at most maxRules
+    int addRule(const std::string& name, float weight, double cost, uint8_t tag);
+    int ruleCount() const;
+    void setWeight(int rule, float weight);
+    void setThreshold(float voteThreshold);
+
+    // apply(rule, row, col) runs one rule and returns the colour it names, or -1. With
+    // runAll every rule runs (and tags covers every rule that named the answer); otherwise
+    // tags only covers the rules that ran.
+    template <typename ApplyFn>
+    int infer(int row, int col, bool runAll, uint8_t& tags, ApplyFn apply)
+    {
+        int named[maxRules];
+        voteCount = 0;
+        int position = 0;
+        int count = (int)rules.size();
+        for (; position < count; position++) {
+            if (!runAll && settled(position)) break;
+
+            int rule = order[position];
+            Rule& entry = rules[rule];
+            int colour;
+            if (entry.stats.calls % timingStride == 0) {
+                auto start = std::chrono::steady_clock::now();
+                colour = apply(rule, row, col);
+                entry.timedNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                entry.timedCalls++;
+            } else {
+                colour = apply(rule, row, col);
+            }
+            named[position] = colour;
+            vote(rule, colour);
+        }
+        return finishVote(position, tags, named);
+    }
+
+    std::vector<InferenceRuleStats> getStats() const;
+    void resetStats();
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+// Hot-path counters and timers for PuzzleSolver, compiled in with -DQUEENS_INSTRUMENT
+// (make INSTRUMENT=1). Without it every QUEENS_* macro expands to nothing and the
+// counters stay zero.
+
+enum class InstrumentSite
+{
+    INFER_STRICT,
+    RULE_NEIGHBOURS,      // inferStrict's rules
+    RULE_UNIFORMITY,
+    RULE_DOMAINS,
+    RULE_CONTIGUITY,
+    RULE_PATTERN,
+    INFER_WEAK,
+    WEAK_NEIGHBOURS,      // the same rules run by inferWeak, counted apart
+    WEAK_UNIFORMITY,
+    WEAK_DOMAINS,
+    WEAK_CONTIGUITY,
+    WEAK_PATTERN,
+    IS_VALID,
+    FIND_VIABLE,
+    INFERENCE_CASCADE,
+    COUNT
+};
+
+// One counter block per solver. A solver is only ever driven by one thread at a time,
+// so updates are plain increments; blocks are merged once the solves are done.
+struct InstrumentationCounters
+{
+#ifdef QUEENS_INSTRUMENT
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+    static const int siteCount = (int)InstrumentSite::COUNT;
+    static const int maxDepth = 32;   // deeper search nodes share the last slot
+
+    uint64_t calls[siteCount] = {};
+    uint64_t hits[siteCount] = {};    // inference sites: calls that produced a colour
+    uint64_t nanos[siteCount] = {};   // timed sites: inclusive time
+    uint64_t nodesAtDepth[maxDepth] = {};
+
+    void merge(const InstrumentationCounters& other);
+    uint64_t totalNodes() const;
+
+    static const char* siteName(InstrumentSite site);
+    static bool countsHits(InstrumentSite site);
+    static bool isTimed(InstrumentSite site);
+};
+
+// Adds the lifetime of the scope to a nanosecond counter
+class ScopedTimer
+{
+private:
+    uint64_t& target;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit ScopedTimer(uint64_t& counter) : target(counter), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer()
+    {
+        target += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+#ifdef QUEENS_INSTRUMENT
+#define QUEENS_CONCAT_(a, b) a##b
+#define QUEENS_CONCAT(a, b) QUEENS_CONCAT_(a, b)
+#define QUEENS_COUNT(block, site) (++(block).calls[(int)(site)])
+#define QUEENS_RESULT(block, site, hit) \
+    (++(block).calls[(int)(site)], (block).hits[(int)(site)] += (hit) ? 1 : 0)
+#define QUEENS_TIME(block, site) \
+    QUEENS_COUNT(block, site); ScopedTimer QUEENS_CONCAT(queensTimer, __LINE__)((block).nanos[(int)(site)])
+#define QUEENS_NODE(block, depth) \
+    (++(block).nodesAtDepth[std::min((int)(depth), InstrumentationCounters::maxDepth - 1)])
+#else
+#define QUEENS_COUNT(block, site) ((void)0)
+#define QUEENS_RESULT(block, site, hit) ((void)0)
+#define QUEENS_TIME(block, site) ((void)0)
+#define QUEENS_NODE(block, depth) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef JSON_VALUE_H
+#define JSON_VALUE_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal JSON reader for the files the tools exchange (benchmark results, JSONL records).
+// Objects keep their members in file order; lookups are linear, which is fine for records
+// of a few dozen fields.
+class JsonValue
+{
+public:
+    enum class Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+private:
+    Type kind = Type::NUL;
+    bool boolean = false;
+    double number = 0.0;
+    std::string text;
+    std::vector<JsonValue> elements;
+    std::vector<std::pair<std::string, JsonValue>> fields;
+
+    friend class JsonParser;
+
+public:
+    // Throws std::runtime_error with the offset of the first malformed character
+    static JsonValue parse(const std::string& source);
+
+    Type type() const { return kind; }
+    bool isNull() const { return kind == Type::NUL; }
+    bool isNumber() const { return kind == Type::NUMBER; }
+    bool isString() const { return kind == Type::STRING; }
+    bool isArray() const { return kind == Type::ARRAY; }
+    bool isObject() const { return kind == Type::OBJECT; }
+
+    double asNumber(double fallback = 0.0) const;
+    bool asBool(bool fallback = false) const;
+    std::string asString(const std::string& fallback = "") const;
+
+    const std::vector<JsonValue>& items() const { return elements; }
+    const std::vector<std::pair<std::string, JsonValue>>& members() const { return fields; }
+
+    bool has(const std::string& key) const;
+    // Missing keys (or a non-object) give a null value
+    const JsonValue& operator[](const std::string& key) const;
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <cstdint>
+#include <vector>
+
+// HDR-style latency histogram. Values are kept in microseconds in log-linear buckets:
+// exact below 128 us, then 64 sub-buckets per power of two, so any reported percentile
+// is within about 1.6% of the true value. Recording is a couple of shifts and an
+// increment; memory grows only with the largest value seen.
+class LatencyHistogram
+{
+private:
+    static const int subBucketBits = 6;
+    static const int subBucketCount = 1 << subBucketBits;
+    static const int linearLimit = 2 * subBucketCount;
+
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t maxMicros = 0;
+    double sumMicros = 0.0;
+
+    static int indexOf(uint64_t micros);
+    static uint64_t highestEquivalent(int index);
+
+public:
+    void record(double millis);
+    void merge(const LatencyHistogram& other);
+
+    uint64_t count() const;
+    double percentile(double percent) const;    // in ms, percent in [0, 100]
+    double max() const;
+    double mean() const;
+};
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef METRICS_REGISTRY_H
+#define METRICS_REGISTRY_H
+
+#include "ResultSink.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Live counters, gauges and histograms for long batch runs, rendered as OpenMetrics text so
+// a Prometheus scrape or the node-exporter textfile collector can follow a run while it is
+// still going. Updates take a mutex; they happen once per finished solve, not per node.
+
+// (name, value) pairs, written in this order
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+using MetricId = int;
+
+enum class MetricType { COUNTER, GAUGE, HISTOGRAM };
+
+class MetricsRegistry
+{
+private:
+    struct Series
+    {
+        MetricLabels labels;
+        double value = 0.0;              // counter or gauge
+        std::vector<uint64_t> buckets;   // histogram, per bound (not cumulative)
+        uint64_t count = 0;
+        double sum = 0.0;
+    };
+
+    struct Family
+    {
+        std::string name;
+        std::string help;
+        std::string unit;
+        MetricType type;
+        std::vector<double> bounds;      // histogram upper bounds, ascending, +Inf implied
+        std::vector<Series> series;
+    };
+
+    mutable std::mutex mutex;
+    std::vector<Family> families;
+
+    MetricId add(const std::string& name, const std::string& help, const std::string& unit, MetricType type,
+                 std::vector<double> bounds);
+    Series& seriesFor(MetricId id, const MetricLabels& labels);
+
+public:
+    // Names follow OpenMetrics: counters get _total on their samples, and a unit, when
+    // given, must end the name
+    MetricId addCounter(const std::string& name, const std::string& help);
+    MetricId addGauge(const std::string& name, const std::string& help, const std::string& unit = "");
+    MetricId addHistogram(const std::string& name, const std::string& help, const std::string& unit,
+                          std::vector<double> bounds);
+
+    void increment(MetricId id, const MetricLabels& labels, double amount = 1.0);
+    void set(MetricId id, const MetricLabels& labels, double value);
+    void observe(MetricId id, const MetricLabels& labels, double value);
+
+    // The whole exposition, ending in "# EOF"
+    std::string render() const;
+};
+
+// The batch runner's metrics: outcomes, work done and latency per configuration, plus how
+// many solves are waiting and running
+class SolveMetrics
+{
+private:
+    MetricsRegistry registry;
+    MetricId puzzles;
+    MetricId probes;
+    MetricId inferences;
+    MetricId backtracks;
+    MetricId nodes = -1;       // only with INSTRUMENT=1, the node count lives in the hot-path counters
+    MetricId solveSeconds;
+    MetricId phaseSeconds;
+    MetricId queued;
+    MetricId inFlight;
+    MetricId lastSolve;
+
+public:
+    SolveMetrics();
+
+    void record(const PuzzleStatistics& stats, const ResultContext& context);
+    void setQueueDepth(int waiting, int running);
+
+    const MetricsRegistry& getRegistry() const;
+};
+
+// Rewrites a metrics file every interval from a background thread, and once more on
+// destruction. Each write goes to <path>.tmp and is renamed over the file, so a scraper
+// never sees a partial exposition.
+class MetricsTextfile
+{
+private:
+    const MetricsRegistry& registry;
+    std::string path;
+    std::chrono::milliseconds interval;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread writer;
+
+public:
+    MetricsTextfile(const MetricsRegistry& registry, const std::string& path, double intervalSeconds);
+    ~MetricsTextfile();
+
+    MetricsTextfile(const MetricsTextfile&) = delete;
+    MetricsTextfile& operator=(const MetricsTextfile&) = delete;
+
+    bool writeNow();
+};
+
+#endif
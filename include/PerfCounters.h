@@ -0,0 +1,58 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <string>
+
+// Hardware events read through Linux perf_event_open
+enum class PerfEvent
+{
+    CYCLES,
+    INSTRUCTIONS,
+    L1D_MISSES,      // L1 data cache read misses
+    LLC_MISSES,      // last-level cache misses
+    BRANCH_MISSES,
+    COUNT
+};
+
+// Event counts over some interval. Events the kernel or hardware could not provide are
+// left out of availableMask and read as zero.
+struct PerfCounts
+{
+    static const int eventCount = (int)PerfEvent::COUNT;
+
+    long long values[eventCount] = {};
+    unsigned availableMask = 0;
+
+    bool captured() const { return availableMask != 0; }
+    bool has(PerfEvent event) const { return availableMask & (1u << (int)event); }
+    long long get(PerfEvent event) const { return values[(int)event]; }
+
+    void add(const PerfCounts& other);
+    PerfCounts operator-(const PerfCounts& earlier) const;
+
+    static const char* eventName(PerfEvent event);
+};
+
+// Counters for the thread that creates the group (user space only). Each event is opened
+// on its own, so one missing event does not cost the others; on kernels without
+// perf_event_open, or in containers that block it, the group is simply unavailable.
+class PerfCounterGroup
+{
+private:
+    int fds[PerfCounts::eventCount];
+    std::string failure;
+
+public:
+    PerfCounterGroup();
+    ~PerfCounterGroup();
+    PerfCounterGroup(const PerfCounterGroup&) = delete;
+    PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+    bool available() const;
+    const std::string& unavailableReason() const;
+
+    // Totals since the group was opened, scaled up when the kernel had to multiplex
+    PerfCounts read() const;
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef PROBE_BUDGET_POOL_H
+#define PROBE_BUDGET_POOL_H
+
+#include <coroutine>
+#include <cstddef>
+#include <vector>
+
+class SolveScheduler;
+
+// Probe budget shared by a batch of puzzles. Each puzzle enrols with its fair share and
+// keeps part of it as a guaranteed base; the rest, plus whatever finished puzzles leave
+// unspent, forms a reserve handed out one probe at a time. Solves running on a
+// SolveScheduler compete for the reserve by marginal value. Sequential solves each draw
+// at most their own part of it: what they put in, plus a share of what earlier puzzles
+// left, split by fair share with the puzzles announced through expect().
+class ProbeBudgetPool
+{
+public:
+    // Awaitable for one extra probe; resumes with the number of probes granted (0 or 1)
+    class GrantWait
+    {
+    private:
+        ProbeBudgetPool& pool;
+        SolveScheduler& scheduler;
+        int member;
+        double value;
+        int granted = 0;
+
+        friend class ProbeBudgetPool;
+
+    public:
+        GrantWait(ProbeBudgetPool& owner, SolveScheduler& scheduler, int member, double value)
+            : pool(owner), scheduler(scheduler), member(member), value(value) {}
+
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> solve);
+        int await_resume() const { return granted; }
+    };
+
+private:
+    struct Member
+    {
+        int share = 0;
+        int base = 0;
+        int granted = 0;
+        int allowance = 0;   // reserve probes tryGrant may hand this member
+        bool active = false;
+    };
+
+    struct PendingGrant
+    {
+        GrantWait* request;
+        std::coroutine_handle<> solve;
+    };
+
+    double reserveFraction;
+    std::vector<Member> members;
+    std::vector<PendingGrant> pending;
+    SolveScheduler* attachedScheduler = nullptr;
+
+    int reserve = 0;
+    int activeMembers = 0;
+    int totalShares = 0;
+    int expectedShares = 0;   // announced by expect() and not yet enrolled
+    int totalGranted = 0;
+    int totalReturned = 0;
+    int totalDenied = 0;
+
+    double priority(const PendingGrant& grant) const;
+    void resume(size_t index, int granted);
+    bool arbitrate();
+
+public:
+    explicit ProbeBudgetPool(double reserveFraction = 0.5);
+
+    // Announces a puzzle that will enrol later, so sequential allowances leave it its share
+    void expect(int fairShare);
+    int enrol(int fairShare);
+    int baseAllocation(int member) const;
+    void release(int member, int unused);
+
+    bool tryGrant(int member);
+    GrantWait request(int member, double value, SolveScheduler& scheduler);
+
+    // A solve over its budget went without a probe it needed
+    void countDenial();
+
+    int shares() const;
+    int reserveRemaining() const;
+    int grantedCount() const;
+    int returnedCount() const;
+    int deniedCount() const;
+};
+
+#endif
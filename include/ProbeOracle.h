@@ -0,0 +1,99 @@
+#ifndef PROBE_ORACLE_H
+#define PROBE_ORACLE_H
+
+#include <vector>
+#include <utility>
+#include <future>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+
+// Source of truth for probes. Every call is one round trip to the sensing backend;
+// colours come back in the same order as the requested cells.
+class ProbeOracle
+{
+public:
+    virtual ~ProbeOracle() = default;
+
+    virtual std::future<std::vector<int>> probeBatch(const std::vector<std::pair<int, int>>& cells) = 0;
+
+    int probe(int row, int col)
+    {
+        return probeBatch({{row, col}}).get()[0];
+    }
+
+    // True when every future is ready as probeBatch returns, so waiting costs nothing and
+    // batching requests buys nothing
+    virtual bool answersImmediately() const { return false; }
+
+    // Called on whichever thread completes a request, once its future is ready, so a
+    // scheduler can sleep until a result arrives. Oracles that answer on another thread
+    // must call it; a future that is ready when probeBatch returns needs no call.
+    void setCompletionListener(std::function<void()> listener)
+    {
+        completionListener = std::move(listener);
+    }
+
+protected:
+    std::function<void()> completionListener;
+};
+
+// Completes promises once their deadline has passed. One thread serves every request
+// scheduled on it, so many simulators can share a single instance.
+class DelayedDelivery
+{
+private:
+    struct PendingRequest
+    {
+        std::promise<std::vector<int>> promise;
+        std::vector<int> colours;
+        std::function<void()> onDelivered;
+    };
+
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::multimap<std::chrono::steady_clock::time_point, PendingRequest> pending;
+    std::thread deliveryThread;
+    bool stopping = false;
+
+    void deliverLoop();
+
+public:
+    ~DelayedDelivery();
+
+    // onDelivered runs on the delivery thread after the promise is fulfilled
+    void schedule(std::chrono::steady_clock::time_point deadline,
+                  std::promise<std::vector<int>> promise, std::vector<int> colours,
+                  std::function<void()> onDelivered = {});
+};
+
+// In-process oracle backed by the original grid. Each request (single cell or batch)
+// completes after a fixed latency; with zero latency results are ready immediately.
+class SimulatedProbeOracle : public ProbeOracle
+{
+private:
+    const std::vector<std::vector<int>>& grid;
+    std::chrono::microseconds latency;
+    DelayedDelivery ownDelivery;
+    DelayedDelivery* delivery;
+
+    int requests = 0;
+    int cellsProbed = 0;
+
+public:
+    SimulatedProbeOracle(const std::vector<std::vector<int>>& original,
+                         std::chrono::microseconds latency = std::chrono::microseconds(0),
+                         DelayedDelivery* sharedDelivery = nullptr);
+
+    std::future<std::vector<int>> probeBatch(const std::vector<std::pair<int, int>>& cells) override;
+    bool answersImmediately() const override;
+
+    void setLatency(std::chrono::microseconds newLatency);
+    int requestCount() const;
+    int cellCount() const;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef PROBE_QUEUE_H
+#define PROBE_QUEUE_H
+
+#include <vector>
+
+// Indexed binary max-heap of probe candidates, keyed by cell index (row * n + col).
+// Scores are cached per cell and only recomputed once a cell has been invalidated,
+// so the solver can keep the heap alive across search nodes.
+class ProbeQueue
+{
+private:
+    std::vector<int> heap;          // heap slot -> cell
+    std::vector<int> slotOf;        // cell -> heap slot, -1 when not queued
+    std::vector<double> scores;     // cached score per cell
+    std::vector<char> stale;        // cell score needs recomputing
+    std::vector<int> staleMembers;  // queued cells invalidated since the last refresh
+
+    bool ranksAbove(int cellA, int cellB) const;
+    void swapSlots(int a, int b);
+    void siftUp(int slot);
+    void siftDown(int slot);
+
+public:
+    void reset(int cellCount);
+    int size() const;
+    bool contains(int cell) const;
+    bool isStale(int cell) const;
+    double scoreOf(int cell) const;
+
+    void insert(int cell, double score);
+    void erase(int cell);
+    void update(int cell, double score);
+
+    void invalidate(int cell);
+    void invalidateAll();
+
+    // Rescore every queued cell invalidated since the last refresh
+    template <typename ScoreFn>
+    void refresh(ScoreFn scoreFn)
+    {
+        for (int cell : staleMembers) {
+            if (stale[cell] && contains(cell)) {
+                update(cell, scoreFn(cell));
+            }
+        }
+        staleMembers.clear();
+    }
+
+    // Best k queued cells in descending score order, O(k log k) on top of the heap
+    std::vector<int> top(int k) const;
+};
+
+#endif
@@ -2,10 +2,18 @@
 #include "graph.h"
 #include <vector>
 #include <string>
+#include <memory>
 
 class PuzzleManager {
 public:
     // static std::vector<Graph> loadFromFile(const std::string& filename, int numPuzzles);
     static void loadFromFile(const std::string& filename, int numPuzzles, std::vector<Graph>& graphs);
     static void loadFromFile(const std::string& filename, int numPuzzles, std::vector<Graph>& graphs, double maskingPercentage);
-};
\ No newline at end of file
+
+    // Boards are read once and shared; every masking of the corpus only adds overlays
+    static std::vector<std::shared_ptr<const PuzzleGrid>> loadCorpus(const std::string& filename, int numPuzzles);
+    static void maskCorpus(const std::vector<std::shared_ptr<const PuzzleGrid>>& corpus, std::vector<Graph>& graphs,
+                           double maskingPercentage);
+    static void maskCorpus(const std::vector<std::shared_ptr<const PuzzleGrid>>& corpus, std::vector<Graph>& graphs,
+                           double maskingPercentage, unsigned int seed);
+};
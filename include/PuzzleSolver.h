@@ -7,10 +7,43 @@
 #include <vector>
 #include <fstream>
 #include "graph.h"
+#include "ProbeQueue.h"
+#include "BeliefEngine.h"
+#include "ProbeOracle.h"
+#include "Task.h"
+#include "ProbeBudgetPool.h"
+#include "Instrumentation.h"
+#include "PerfCounters.h"
+#include "AllocationTracker.h"
+#include "DecisionTrace.h"
+#include "TranspositionTable.h"
+#include "InferencePipeline.h"
+#include "SolverParameters.h"
 #include <set>
 #include <cfloat>
 #include <climits>
 #include <map>
+#include <memory>
+#include <deque>
+
+class SolveScheduler;
+
+// Solver state at a point in time. The grids themselves are not copied: the snapshot
+// holds a position in the solver's trail of cell writes, which the solver keeps for as
+// long as the snapshot is held.
+struct SolverSnapshot
+{
+    size_t trailMark = 0;
+    int probeCount = 0;
+    int queensPlaced = 0;
+    int totalQueensPlaced = 0;
+    int backtrackCount = 0;
+    int inferredCount = 0;
+    bool budgetExhausted = false;
+    int maxQueensPlaced = 0;
+    std::vector<std::pair<int, int>> bestPartialSolution;
+    uint32_t searchNodes = 0;
+};
 
 struct ColourDomain
 {
@@ -24,6 +57,26 @@ struct ColourDomain
     }
 };
 
+// How findBestProbeSpots ranks candidate cells
+enum class ProbeStrategy
+{
+    LOCAL_HEURISTIC,   // neighbourhood scores from calculateExpectedInformationGain
+    MONTE_CARLO        // information gain over sampled consistent boards (BeliefEngine)
+};
+
+// Where a solve spends its wall time. Each moment is charged to exactly one phase: the
+// innermost one active at the time, with everything else counted as search.
+enum class SolvePhase
+{
+    SEARCH,            // backtracking, queen placement and bookkeeping
+    INFERENCE,         // constraint propagation
+    PROBE_SELECTION,   // ranking probe candidates and waiting on the budget pool
+    PROBE_WAIT,        // blocked or suspended on oracle results
+    COUNT
+};
+
+const char* solvePhaseName(SolvePhase phase);
+
 // Structure to collect per-puzzle statistics for experiments
 struct PuzzleStatistics
 {
@@ -35,15 +88,33 @@ struct PuzzleStatistics
     int correctQueens = 0;          // For failed puzzles only
     int probesUsed = 0;
     int probeBudget = 0;
+    int probesCharged = 0;          // oracle answers billed to the budget: probesUsed + probesDiscarded
+    int probesDiscarded = 0;        // answered, then thrown away by a speculative rollback
     int inferences = 0;
     int backtracks = 0;
     int initialMaskedCells = 0;
     int cellsRevealed = 0;          // probes + inferences
     int gridSize = 0;
+    double solveMillis = 0.0;       // wall time of the last solve
+    double maskingMillis = 0.0;     // building the masked board
+    double inferenceMillis = 0.0;   // per-phase split of solveMillis
+    double probeSelectionMillis = 0.0;
+    double probeWaitMillis = 0.0;
+    double searchMillis = 0.0;
+    bool timedOut = false;          // stopped by the solver's deadline
+    long long transpositionLookups = 0;   // nodes checked against known dead-end states
+    long long transpositionHits = 0;      // ... and skipped as one
+    std::vector<InferenceRuleStats> inferenceRules;   // inferStrict's rules, in strictRules order
+    InstrumentationCounters instrumentation;   // zero unless built with QUEENS_INSTRUMENT
+    PerfCounts perf;                           // hardware counters, when enabled and available
+    PerfCounts perfByPhase[(int)SolvePhase::COUNT];
+    AllocationCounters allocations;            // heap activity, when the tracker is linked in
 };
 
 class PuzzleSolver
 {
+    // The benchmark harness times the individual inference rules
+    friend class SolverBench;
 
 private:
     Graph &puzzle;
@@ -54,6 +125,206 @@ private:
     int inferRowColumnUniformity(int row, int col);
     int inferPatternCompletion(int row, int col);
 
+    // Weights, thresholds, scores and bonuses used below
+    SolverParameters parameters;
+
+    // inferStrict's vote, weighted by parameters.strictWeights in this order; costs are
+    // relative ns per call
+    struct StrictRule
+    {
+        const char* name;
+        double cost;
+        uint8_t traceRule;
+        InstrumentSite site;
+        int (PuzzleSolver::*apply)(int row, int col);
+    };
+    static const StrictRule strictRules[];
+    static const int strictRuleCount = 5;
+    InferencePipeline strictInference{0.0f};   // threshold set from parameters
+
+    // Persistent probe candidate heap, rescored only around changed cells
+    ProbeQueue probeQueue;
+    std::vector<int> candidateStamp;
+    std::vector<int> queuedCandidates;
+    int candidateGeneration = 0;
+
+    // Probes go through the oracle; the local simulator is used unless one is supplied
+    std::unique_ptr<SimulatedProbeOracle> localOracle;
+    ProbeOracle* oracle = nullptr;
+
+    // Batch-wide budget; when set, probeBudget starts at the pool's base allocation and
+    // grows with every probe the pool grants
+    ProbeBudgetPool* budgetPool = nullptr;
+    int poolMember = -1;
+
+    struct PendingProbe
+    {
+        int token = 0;
+        std::vector<std::pair<int, int>> cells;
+        std::vector<int> predicted;
+        std::vector<int> actual;
+        std::future<std::vector<int>> result;
+        SolverSnapshot snapshot;
+        size_t transpositionMark = 0;
+    };
+
+    // Speculative probing: the outstanding request, and the mispredicted one whose issuing
+    // frame still has to roll back. Only one request is ever outstanding, so no probe is
+    // made on the strength of an unconfirmed guess and the probes match a blocking solve
+    bool speculativeProbing = false;
+    std::deque<PendingProbe> pendingProbes;
+    PendingProbe rollback;
+    int speculationCounter = 0;
+    int rollbackToken = 0;
+
+    int predictColour(int row, int col);
+    int issueProbes(const std::vector<std::pair<int, int>>& cells);
+    bool settlePendingProbe(size_t index, bool wait);
+    bool settleSpeculation(bool wait);
+    bool confirmSpeculation(int token);
+    void takeSnapshot(SolverSnapshot& snapshot);
+    void restoreSnapshot(const SolverSnapshot& snapshot);
+    bool tryPlaceQueen(int row, int col, int cellColour, int n, std::vector<std::pair<int, int>>& queenPositions);
+
+    // One search node as mainSolver and mainSolverAsync see it. Both drivers run the same
+    // steps below and differ only in how they wait for probes and recurse
+    struct SearchNode
+    {
+        int row = 0;
+        std::vector<std::pair<int, int>> viablePositions;
+        uint64_t stateKey = 0;        // transposition key, when the table is active
+        uint32_t nodesAtEntry = 0;    // searchNodes when the node was opened
+    };
+    bool openNode(SearchNode& node, int row, int n, const std::vector<std::pair<int, int>>& queenPositions);
+    std::vector<std::pair<int, int>> nodeCandidates(SearchNode& node, int n);
+    int knownColour(int row, int col);
+    void closeNode(const SearchNode& node, bool found);
+    bool expandNode(SearchNode& node, int n, std::vector<std::pair<int, int>>& queenPositions);
+
+    // Search steps shared by mainSolver and mainSolverAsync
+    std::vector<std::pair<int, int>> selectProbeRequests(std::vector<std::pair<int, int>>& viablePositions);
+    std::vector<std::pair<int, int>> rankViablePositions(std::vector<std::pair<int, int>>& viablePositions, int n);
+    int weakColour(int row, int col);
+    bool canPlaceQueen(int row, int col, int cellColour);
+    void commitQueen(int row, int col, std::vector<std::pair<int, int>>& queenPositions);
+    void retractQueen(int row, int col, std::vector<std::pair<int, int>>& queenPositions);
+    std::vector<std::pair<int, int>> unknownQueenCells(const std::vector<std::pair<int, int>>& queenPositions);
+    bool queensHaveDistinctColours(const std::vector<std::pair<int, int>>& queenPositions);
+    void prepareSolve(int n, double probeBudgetPercent, bool concurrent, bool resumed = false);
+    void liftQueen(int row);
+    void finishSolve(bool solved);
+    void applyInference(int row, int col, int colour);
+    void pruneRow(int row);
+
+    // Decision trace of the running solve, if one is attached
+    DecisionTrace* trace = nullptr;
+    uint8_t lastInferenceRules = 0;   // rules that agreed with inferStrict's last answer
+    void traceEvent(TraceEventKind kind, int row, int col, int value, int flags = 0)
+    {
+        if (trace) trace->record(kind, row, col, value, flags);
+    }
+
+    Task<bool> mainSolverAsync(int row, int n, std::vector<std::pair<int, int>>& queenPositions,
+                               SolveScheduler& scheduler);
+    Task<void> probeBatchAsync(std::vector<std::pair<int, int>> cells, SolveScheduler& scheduler);
+    Task<bool> canProbeAsync(int row, int n, SolveScheduler& scheduler);
+    double marginalProbeValue(int row, int n);
+
+    std::chrono::steady_clock::time_point solveStart;
+
+    // Optional wall-clock limit; the search unwinds once it passes and the solve reports
+    // the best partial placement, as for any failed solve
+    bool hasDeadline = false;
+    std::chrono::steady_clock::time_point deadline;
+    bool deadlineHit = false;
+    unsigned int deadlineCheck = 0;
+    uint32_t nodeLimit = 0;   // search nodes per solve, 0 = none; stops every run at the same node
+    bool pastDeadline();
+
+    // Dead-end states of the running solve, allocated at the first solve that uses them.
+    // colourHash covers the known colours and follows every trail write; the queens and
+    // probes left are mixed in when a node is looked up.
+    TranspositionTable transpositions;
+    size_t transpositionEntries = defaultTranspositionEntries;
+    bool transpositionsActive = false;
+    uint64_t colourHash = 0;
+    uint32_t searchNodes = 0;
+    void hashCell(int row, int col, int from, int to);
+    uint64_t computeColourHash();
+    uint64_t transpositionKey(const std::vector<std::pair<int, int>>& queenPositions);
+    void rememberFailure(uint64_t key, uint32_t nodesAtEntry);
+
+    // Phase clock: time since phaseStart belongs to activePhase
+    SolvePhase activePhase = SolvePhase::SEARCH;
+    std::chrono::steady_clock::time_point phaseStart;
+    SolvePhase enterPhase(SolvePhase phase);
+
+    // Hardware counters follow the phase clock: each switch charges the events since the
+    // last one to the phase that was running
+    PerfCounterGroup* perfCounters = nullptr;
+    PerfCounts perfSolveStart;
+    PerfCounts perfPhaseStart;
+
+    // Around a scheduler suspension: whatever other solves run on the thread meanwhile is
+    // left out of both the solve and the phase counts
+    PerfCounts perfSuspendedAt;
+    void suspendPerf();
+    void resumePerf();
+
+    // Allocations follow it too: while a solve runs, the thread charges the solver's block
+    // under the active phase, and gets back whatever it was charging before when it ends
+    bool solveActive = false;
+    AllocationTracker::Context allocationContextOutside;
+
+    class PhaseScope
+    {
+    private:
+        PuzzleSolver& solver;
+        SolvePhase previous;
+
+    public:
+        PhaseScope(PuzzleSolver& owner, SolvePhase phase)
+            : solver(owner), previous(owner.enterPhase(phase)) {}
+        ~PhaseScope() { solver.enterPhase(previous); }
+        PhaseScope(const PhaseScope&) = delete;
+        PhaseScope& operator=(const PhaseScope&) = delete;
+    };
+
+    ProbeStrategy probeStrategy = ProbeStrategy::LOCAL_HEURISTIC;
+    BeliefEngine beliefEngine;
+    int maskedVersion = 0;
+    int beliefVersion = -1;
+
+    // While a checkpoint or a speculative probe holds a mark, every write to the masked
+    // grid or the queen overlay is recorded with the value it replaced, so the board can be
+    // rolled back to the mark. With no mark held nothing is recorded, and the first write
+    // drops what is left, so the trail stays as long as the oldest live mark needs.
+    struct TrailEntry
+    {
+        bool masked;
+        int row;
+        int col;
+        int previous;
+    };
+    std::vector<TrailEntry> trail;
+    int checkpointsHeld = 0;
+    bool trailHeld() const { return checkpointsHeld > 0 || !pendingProbes.empty() || rollbackToken != 0; }
+    void recordTrail(const TrailEntry& entry);
+
+    // The board as the solver was given it, for resetToPristine
+    std::vector<std::vector<int>> pristineMasked;
+    std::vector<int> pristineQueens;
+
+    void writeCell(int row, int col, int colour);
+    void writeQueen(int row, int col);
+    void rollbackTrail(size_t mark);
+
+    void revealCell(int row, int col, int colour);
+    void placeQueen(int row, int col);
+    void resetProbeQueue(int n);
+    void invalidateProbeScoresAround(int row, int col);
+    void invalidateProbeScoresInRow(int row);
+
 public:
     static const int directions[4][2];
 
@@ -62,10 +333,23 @@ public:
     int probeCount = 0;
     int inferredCount = 0;
     int totalQueensPlaced = 0;
+    int speculativeProbes = 0;
+    int mispredictedProbes = 0;
+    int wastedProbes = 0;
+
+    // Every probe the oracle has answered, including those a rollback discarded. The
+    // budget is charged for these, since the discarded ones were real oracle calls
+    int probesSpent() const { return probeCount + wastedProbes; }
 
     int probeBudget = 0;
     int initialUnknownCells = 0;
     bool budgetExhausted = false;
+    double solveMillis = 0.0;
+    double phaseMillis[(int)SolvePhase::COUNT] = {};
+    InstrumentationCounters instrumentation;
+    PerfCounts solvePerf;
+    PerfCounts phasePerf[(int)SolvePhase::COUNT];
+    AllocationCounters allocations;
 
     std::vector<std::pair<int, int>> bestPartialSolution;
     int maxQueensPlaced = 0;
@@ -74,6 +358,50 @@ public:
 
     int inferNeighbours(int row, int col);
     void probe(int row, int col);
+    void observeCell(int row, int col, int colour);
+    void probeBatch(const std::vector<std::pair<int, int>>& cells);
+    void setProbeOracle(ProbeOracle* probeOracle);
+    void setProbeLatency(std::chrono::microseconds latency);
+    void setSpeculativeProbing(bool enabled);
+    void setProbeBudgetPool(ProbeBudgetPool* pool);
+
+    // The group must belong to the thread that runs the solve. In concurrent mode only the
+    // slices this solve runs between suspensions are counted.
+    void setPerfCounters(PerfCounterGroup* group);
+
+    // Records every probe, inference, placement, undo and prune of the following solves;
+    // the trace restarts at each solve
+    void setDecisionTrace(DecisionTrace* decisionTrace);
+
+    // Applies to every following solve until cleared
+    void setDeadline(std::chrono::steady_clock::time_point limit);
+    void clearDeadline();
+    // Same, counted in search nodes rather than time, so the outcome does not depend on
+    // the machine or its load; 0 removes it. Running out shows as timedOut()
+    void setNodeLimit(uint32_t nodes);
+    bool timedOut() const;
+
+    // Size of the table of dead-end states, 0 to turn it off. A node that leaves the rows
+    // below it the same columns, colours, known cells and probes as one that failed earlier
+    // in the solve fails at once.
+    // Only used where the search from a state depends on nothing else: not with Monte
+    // Carlo probe selection or a pooled budget. Under speculative probing, states stored
+    // on a guess that turns out wrong are taken back out.
+    static const size_t defaultTranspositionEntries = 1 << 13;
+    void setTranspositionTable(size_t entries);
+
+    // Replaces the solver's constants, e.g. with a file written by tune.out; takes effect
+    // from the next solve
+    void setParameters(const SolverParameters& values);
+    const SolverParameters& getParameters() const;
+
+    // Cheap replays of one board: restoreCheckpoint brings back the grids and counters of
+    // a checkpoint, resetToPristine returns to the board as it was loaded. The trail is
+    // kept from a checkpoint on until it is released.
+    SolverSnapshot checkpoint();
+    void restoreCheckpoint(const SolverSnapshot& snapshot);
+    void releaseCheckpoint(const SolverSnapshot& snapshot);
+    void resetToPristine();
     bool isValid(int row, int col);
     std::vector<std::pair<int, int>> findViableQueenPositions(int row, int n);
     void undoQueenPlacement(int row, int col);
@@ -88,12 +416,23 @@ public:
 
     bool solvePuzzle(int n);
     bool solvePuzzle(int n, double probeBudgetPercent);
+    Task<bool> solvePuzzleAsync(int n, double probeBudgetPercent, SolveScheduler& scheduler);
+
+    // Re-solve after new observations: keeps the first keepQueens of queenPositions and
+    // searches the rows below them, then from an empty board if that prefix cannot be
+    // completed, setting keepQueens to 0. Taking back the caller's queens is not counted as
+    // backtracking. The probe budget carries over from earlier solves; probeBudgetPercent
+    // is only recorded.
+    bool resumeSolve(int n, double probeBudgetPercent, std::vector<std::pair<int, int>>& queenPositions,
+                     int& keepQueens);
     bool mainSolver(int row, int n, std::vector<std::pair<int, int>>& queenPositions);
     std::vector<std::pair<int, int>> findBestProbeSpots(int k, std::vector<std::pair<int, int>>& viablePositions);
     double calculateExpectedInformationGain(int row, int col, int n);
     void propagateConstraints(int n);
 
     void setProbeBudget(int n, double budgetPercent = 0.15);
+    int fairProbeShare(double budgetPercent) const;   // the budget a solve would enrol in a pool with
+    void setProbeStrategy(ProbeStrategy strategy, int samples = 256, int threads = 0, unsigned int seed = 5489u);
     bool canProbe();
     int inferWeak(int row, int col, double& confidence);
 
@@ -0,0 +1,97 @@
+#ifndef RESULT_SINK_H
+#define RESULT_SINK_H
+
+#include "PuzzleSolver.h"
+#include "LatencyHistogram.h"
+#include <fstream>
+#include <string>
+
+enum class ResultFormat { JSONL, CSV };
+
+// How much the binaries print per puzzle; board rendering is opt-in
+enum class Verbosity { QUIET = 0, PROGRESS = 1, BOARDS = 2 };
+
+// Run settings stored alongside each puzzle's statistics
+struct ResultContext
+{
+    double maskingPercent = 0.0;
+    double probeBudgetPercent = 0.0;
+    std::string strategy = "heuristic";
+    long long maskSeed = -1;   // puzzle i was masked with maskSeed + i - 1; -1 = not recorded
+};
+
+// Latency distribution of a group of solves, whole solve and each phase
+struct SolveLatency
+{
+    LatencyHistogram solve;
+    LatencyHistogram masking;
+    LatencyHistogram inference;
+    LatencyHistogram probeSelection;
+    LatencyHistogram probeWait;
+    LatencyHistogram search;
+
+    void record(const PuzzleStatistics& stats);
+
+    // (name, histogram) pairs in report order
+    std::vector<std::pair<const char*, const LatencyHistogram*>> phases() const;
+};
+
+// Options shared by main.out and experiments.out
+struct OutputOptions
+{
+    std::string resultsPath;
+    Verbosity verbosity = Verbosity::PROGRESS;
+    bool perfCounters = false;   // --perf: hardware counters per puzzle and phase
+    std::string traceDir;        // --trace=<dir>: one decision trace file per puzzle
+    size_t traceRingEvents = 0;  // --trace-ring=<events>: keep only each solve's last events
+    std::string metricsPath;     // --metrics=<file>: OpenMetrics text, rewritten during the run
+    double metricsIntervalSeconds = 10.0;   // --metrics-interval=<seconds>
+    std::string parametersPath;  // --params=<file>: solver constants, e.g. as written by tune.out
+    unsigned int maskSeed = 0;   // --mask-seed=<n>: masking seed; drawn once at random when not given
+    bool maskSeedGiven = false;
+};
+
+// Removes --results=<path>, --verbosity=<0|1|2>, --perf, --trace=<dir>,
+// --trace-ring=<events>, --metrics=<file>, --metrics-interval=<seconds>, --params=<file>
+// and --mask-seed=<n> from argv, leaving the positional arguments in place
+OutputOptions extractOutputOptions(int& argc, char* argv[]);
+
+// One machine-readable record per puzzle (every PuzzleStatistics field plus the run
+// settings), collected in memory and written in large blocks. JSON Lines records carry a
+// "record" field, "puzzle" or "latency", so summaries can share the file.
+class ResultSink
+{
+private:
+    std::ofstream out;
+    std::string path;
+    ResultFormat format;
+    std::string buffer;
+    size_t capacity;
+    bool headerWritten = false;
+    bool csvPerfColumns = false;   // fixed by the first record, so every row matches the header
+
+    // CSV keeps latency summaries out of the per-puzzle table, in <name>_latency.csv
+    std::ofstream latencyOut;
+
+    void appendJson(const PuzzleStatistics& stats, const ResultContext& context);
+    void appendCsv(const PuzzleStatistics& stats, const ResultContext& context);
+    void appendInferenceRulesJson(const std::vector<InferenceRuleStats>& rules);
+    void appendInstrumentationJson(const InstrumentationCounters& counters);
+    void appendPerfJson(const PuzzleStatistics& stats);
+    void appendAllocationJson(const AllocationCounters& counters);
+
+public:
+    // The format follows the extension: .csv writes CSV, anything else JSON Lines
+    explicit ResultSink(const std::string& path, size_t bufferBytes = 1 << 16);
+    ResultSink(const std::string& path, ResultFormat format, size_t bufferBytes = 1 << 16);
+    ~ResultSink();
+
+    bool isOpen() const;
+    void write(const PuzzleStatistics& stats, const ResultContext& context);
+
+    // Percentile summary of one configuration; gridSize 0 covers every grid size
+    void writeLatency(const SolveLatency& latency, const ResultContext& context, int gridSize);
+    void flush();
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef SOLUTION_CACHE_H
+#define SOLUTION_CACHE_H
+
+#include "graph.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Key: {Queen = 0, Masked = -1, Colour Square = 1 to N-Colours}
+
+// A board's region layout with the symmetry taken out: the smallest, in row-major order,
+// of its 8 rotations and reflections after each is relabelled with colours numbered in
+// first-seen order. Boards that are rotations, reflections or recolourings of each other
+// share it.
+struct CanonicalBoard
+{
+    int size = 0;
+    std::vector<uint8_t> cells;   // relabelled colours, row-major
+    uint64_t hash = 0;
+    int transform = 0;            // which of the 8 produced it, from the original board
+
+    // Cell (row, col) of the canonical board sits at the returned cell of the original
+    std::pair<int, int> toOriginal(int row, int col) const;
+    std::pair<int, int> toCanonical(int row, int col) const;
+
+    static CanonicalBoard of(const PuzzleGrid& board);
+    static const int transformCount = 8;
+};
+
+// Solutions keyed by canonical board, kept in a file that is mapped into memory rather than
+// read: a sorted index of (hash, offset) pairs and the records behind it, so a lookup is a
+// canonicalization plus a binary search. Solutions added since the file was opened live in
+// memory until save() rewrites the file with everything.
+//
+// File layout, little-endian: header {magic "QSOL", version, entry count, index offset, data
+// offset}; index of {hash, record offset} sorted by hash; records {size, solved, reserved,
+// size*size canonical cells, one queen column per canonical row (255 = none)}.
+class SolutionCache
+{
+public:
+    struct Stats
+    {
+        long long hits = 0;
+        long long misses = 0;
+    };
+
+private:
+    struct Entry
+    {
+        bool solved = false;
+        std::vector<uint8_t> queenCols;   // per canonical row
+    };
+
+    // Mapped file, if any
+    const uint8_t* mapped = nullptr;
+    size_t mappedBytes = 0;
+    uint64_t mappedEntries = 0;
+
+    // Added since open(), by hash; a bucket holds every canonical board with that hash
+    std::unordered_map<uint64_t, std::vector<std::pair<std::vector<uint8_t>, Entry>>> added;
+    size_t addedCount = 0;
+    Stats stats;
+
+    bool findMapped(const CanonicalBoard& canonical, Entry& entry) const;
+    bool findAdded(const CanonicalBoard& canonical, Entry& entry) const;
+    void unmap();
+
+public:
+    static const uint32_t magic = 0x4c4f5351;   // "QSOL"
+    static const uint32_t version = 1;
+
+    SolutionCache() = default;
+    ~SolutionCache();
+    SolutionCache(const SolutionCache&) = delete;
+    SolutionCache& operator=(const SolutionCache&) = delete;
+
+    // A missing file is an empty cache; a file that is not a cache is an error
+    bool open(const std::string& path, std::string& error);
+
+    // On a hit, fills solved and the queen positions on this board (empty when the board
+    // is known to have no solution)
+    bool lookup(const PuzzleGrid& board, bool& solved, std::vector<std::pair<int, int>>& queens);
+
+    // Positions on this board; solved = false records that it has no solution
+    void insert(const PuzzleGrid& board, bool solved, const std::vector<std::pair<int, int>>& queens);
+
+    // Writes every entry to <path>.tmp and renames it over path, which may be the open file
+    bool save(const std::string& path, std::string& error);
+
+    size_t size() const;
+    const Stats& getStats() const;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef SOLVE_SCHEDULER_H
+#define SOLVE_SCHEDULER_H
+
+#include "Task.h"
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <vector>
+
+// Single-threaded scheduler for many concurrent solves. A solve suspends whenever it waits
+// on a probe result and is resumed once the oracle has answered, so one thread keeps
+// hundreds of puzzles in flight while the sensing backend works.
+class SolveScheduler
+{
+public:
+    // Awaitable for an oracle result; suspends the solve until the future is ready
+    class ProbeWait
+    {
+    private:
+        SolveScheduler& scheduler;
+        std::future<std::vector<int>> result;
+
+    public:
+        ProbeWait(SolveScheduler& owner, std::future<std::vector<int>> future)
+            : scheduler(owner), result(std::move(future)) {}
+
+        bool await_ready() const
+        {
+            return result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+
+        void await_suspend(std::coroutine_handle<> solve)
+        {
+            scheduler.waiting.push_back({&result, solve});
+            scheduler.suspensions++;
+        }
+
+        std::vector<int> await_resume() { return result.get(); }
+    };
+
+private:
+    struct WaitingSolve
+    {
+        std::future<std::vector<int>>* result;
+        std::coroutine_handle<> solve;
+    };
+
+    int maxInFlight;
+    std::deque<Task<void>> queued;
+    std::vector<Task<void>> running;
+    std::deque<std::coroutine_handle<>> ready;
+    std::vector<WaitingSolve> waiting;
+    std::vector<std::function<bool()>> idleHandlers;
+
+    // Completions reported by notifyCompletion, so a blocked run() sleeps until one arrives
+    std::mutex completionMutex;
+    std::condition_variable completionArrived;
+    unsigned long long completions = 0;
+
+    int completed = 0;
+    int peakInFlight = 0;
+    long long suspensions = 0;
+
+    void startQueued();
+    void collectFinished();
+    void wakeReady(bool block);
+    void runIdleHandlers();
+
+public:
+    explicit SolveScheduler(int maxInFlight = 256);
+
+    void spawn(Task<void> solve);
+    void run();
+
+    ProbeWait wait(std::future<std::vector<int>> result);
+
+    // Wakes run() when a waited-on result has become ready; safe from any thread. Every
+    // future passed to wait() must be ready immediately or be followed by this call
+    void notifyCompletion();
+
+    // Hooks for other resources solves can wait on: a handler runs whenever no solve is
+    // ready, and hands suspended solves back through schedule()
+    void addIdleHandler(std::function<bool()> handler);
+    void schedule(std::coroutine_handle<> solve);
+
+    int completedCount() const;
+    int queuedCount() const;
+    int runningCount() const;   // started and not yet collected, including the caller
+    int peakConcurrency() const;
+    long long suspensionCount() const;
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef SOLVE_SERVER_H
+#define SOLVE_SERVER_H
+
+#include "PuzzleSolver.h"
+#include "LatencyHistogram.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Key: {Queen = 0, Masked = -1, Colour Square = 1 to N-Colours}
+
+struct ServerOptions
+{
+    int workers = 0;                   // 0 = one per hardware thread
+    int queueLimit = 0;                // requests accepted ahead of the workers; 0 = 2 per worker
+    double maskingPercent = 0.3;       // applied to fully coloured boards
+    double probeBudgetPercent = 0.5;
+    ProbeStrategy strategy = ProbeStrategy::LOCAL_HEURISTIC;
+    unsigned int seed = 12345u;        // masking seed of request <id> is seed + id
+};
+
+// Long-running solver. Requests are boards in the puzzles.txt format (the size, then the
+// rows), read from any number of connections; workers solve them and stream one JSON line
+// per board back to the connection it came from, in completion order, tagged with the
+// request's id. A fully coloured board is masked here and its colours answer the probes;
+// a board that already has -1 cells is solved from what it shows, without probes.
+// The word STATS instead of a board returns the server's counters straight away.
+//
+// When the queue is full the reading connection stops reading, so a fast client is held
+// back by its own socket or pipe buffer instead of by server memory.
+class SolveServer
+{
+private:
+    struct Connection;
+
+    struct Request
+    {
+        std::shared_ptr<Connection> connection;
+        long long id = 0;
+        std::shared_ptr<const PuzzleGrid> board;
+        bool premasked = false;
+        std::chrono::steady_clock::time_point received;
+    };
+
+    ServerOptions options;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<Request> queue;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    // Guarded by mutex
+    long long nextId = 1;
+    long long completed = 0;
+    long long solvedCount = 0;
+    long long rejected = 0;
+    int busy = 0;
+    LatencyHistogram latency;          // request received to response written
+
+    void workerLoop();
+    std::string solve(const Request& request);
+    std::string statsLine();
+    void reject(const std::shared_ptr<Connection>& connection, const std::string& reason);
+
+public:
+    static const int maxGridSize = 64;
+
+    explicit SolveServer(const ServerOptions& options);
+    ~SolveServer();
+
+    SolveServer(const SolveServer&) = delete;
+    SolveServer& operator=(const SolveServer&) = delete;
+
+    // Reads requests from inFd until end of input and returns once every one of them has
+    // been answered on outFd
+    void serve(int inFd, int outFd);
+
+    // Accepts connections on a Unix domain socket, each served on its own thread, until
+    // the process is stopped. Returns false if the socket cannot be set up or accepting fails.
+    bool listenUnix(const std::string& path);
+
+    int workerCount() const;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef SOLVE_SESSION_H
+#define SOLVE_SESSION_H
+
+#include "graph.h"
+#include "PuzzleSolver.h"
+#include <vector>
+#include <utility>
+
+// Key: {Queen = 0, Masked = -1, Colour Square = 1 to N-Colours}
+
+struct CellObservation
+{
+    int row = 0;
+    int col = 0;
+    int colour = -1;
+};
+
+// Long-lived solve over one puzzle whose colours keep arriving (partial screenshots,
+// out-of-band reveals). New observations are written into the masked grid and propagated;
+// queens that are still consistent stay on the board and the search resumes below them.
+class SolveSession
+{
+private:
+    Graph& puzzle;
+    PuzzleSolver solver;
+    double probeBudgetPercent;
+
+    std::vector<std::pair<int, int>> queenPositions;
+    bool started = false;
+    bool solved = false;
+    int keptQueens = 0;
+
+    std::vector<std::pair<int, int>> queensOnBoard();
+    int consistentPrefixLength();
+    bool resolve();
+
+public:
+    SolveSession(Graph& graph, double probeBudgetPercent = 0.5);
+
+    // Cold solve over everything known so far
+    bool solve();
+
+    // Adds observations and re-solves incrementally; before solve() they are only recorded
+    bool observe(int row, int col, int colour);
+    bool observe(const std::vector<CellObservation>& observations);
+
+    bool isSolved() const;
+    const std::vector<std::pair<int, int>>& getQueens() const;
+    int lastKeptQueens() const;
+    PuzzleSolver& getSolver();
+};
+
+#endif
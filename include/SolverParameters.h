@@ -0,0 +1,58 @@
+#ifndef SOLVER_PARAMETERS_H
+#define SOLVER_PARAMETERS_H
+
+#include <string>
+
+// The constants behind the solver's choices, with the values it has always used as the
+// defaults. A file holds one "name = value" line per field ('#' starts a comment); fields
+// it leaves out keep their defaults.
+//
+// Every field has a range and a step, and set() clamps and rounds to them. inferStrict's
+// weights and threshold step in 1/64ths, so its votes add up exactly in any order.
+struct SolverParameters
+{
+    static const int ruleCount = 5;   // neighbours, uniformity, domains, contiguity, pattern
+
+    // inferStrict: a colour is inferred when its rules' weights add up to more than the threshold
+    double strictWeights[ruleCount] = {3.0, 2.5, 2.0, 2.0, 1.5};
+    double strictThreshold = 4.5;
+
+    // inferWeak: guesses a colour once the budget is spent, if its weight reaches weakAccept
+    double weakWeights[ruleCount] = {2.0, 1.5, 1.0, 1.5, 1.5};
+    double weakAccept = 2.0;
+
+    // calculateProbeValue
+    double unknownNeighbourValue = 2.0;   // per unknown neighbour
+    double cornerBonus = 1.5;
+    double edgeBonus = 1.0;
+    double boundaryColourValue = 1.5;     // per neighbouring colour, when there are two or more
+    double openRowBonus = 2.0;            // no queen in the row yet
+
+    // rankViablePositions: cells of known and inferable colour go before the probe values
+    double knownColourScore = 1000.0;
+    double inferredColourScore = 500.0;
+
+    // selectProbeRequests: probe spots considered per search node
+    int probesPerRound = 2;
+
+    struct Field
+    {
+        const char* name;
+        double min;
+        double max;
+        double step;   // 0 = continuous
+    };
+    static const int fieldCount = 2 * ruleCount + 10;
+    static const Field fields[fieldCount];
+
+    // Fields by number, in the order of fields[]
+    double get(int field) const;
+    void set(int field, double value);
+    static int findField(const std::string& name);
+
+    bool load(const std::string& path, std::string& error);
+    bool save(const std::string& path, const std::string& comment = "") const;
+    std::string toString() const;   // the file contents, without a comment
+};
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+// Lazily started coroutine. Awaiting a Task runs it and resumes the awaiter when it
+// finishes (symmetric transfer, so deep chains of awaits do not grow the stack).
+template <typename T>
+class Task;
+
+namespace detail {
+    struct TaskFinalAwaiter
+    {
+        bool await_ready() noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> finished) noexcept
+        {
+            auto continuation = finished.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    struct TaskPromiseBase
+    {
+        std::coroutine_handle<> continuation;
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        TaskFinalAwaiter final_suspend() noexcept { return {}; }
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    template <typename T>
+    struct TaskPromise : TaskPromiseBase
+    {
+        T value{};
+
+        Task<T> get_return_object();
+        void return_value(T result) { value = std::move(result); }
+    };
+
+    template <>
+    struct TaskPromise<void> : TaskPromiseBase
+    {
+        Task<void> get_return_object();
+        void return_void() {}
+    };
+}
+
+template <typename T = void>
+class Task
+{
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+private:
+    std::coroutine_handle<promise_type> handle;
+
+public:
+    explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task()
+    {
+        if (handle) handle.destroy();
+    }
+
+    std::coroutine_handle<> coroutine() const { return handle; }
+    bool done() const { return !handle || handle.done(); }
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept
+    {
+        handle.promise().continuation = awaiter;
+        return handle;
+    }
+
+    T await_resume()
+    {
+        if constexpr (!std::is_void_v<T>) {
+            return std::move(handle.promise().value);
+        }
+    }
+};
+
+namespace detail {
+    template <typename T>
+    Task<T> TaskPromise<T>::get_return_object()
+    {
+        return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+    }
+
+    inline Task<void> TaskPromise<void>::get_return_object()
+    {
+        return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+    }
+}
+
+#endif
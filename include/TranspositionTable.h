@@ -0,0 +1,81 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Search states one solve has already searched to a dead end, keyed by Zobrist hash: the
+// XOR of a key per feature of the state. Feature keys come from a fixed mixing function
+// rather than a stored random table, so nothing has to be sized per board.
+//
+// Memory is fixed when the table is sized. Entries sit in buckets of two: the first slot
+// keeps whichever failure cost the larger subtree, the second takes every other newcomer.
+// A new solve starts a new generation instead of clearing the slots.
+//
+// While journaling, each store first saves the bucket it is about to change, so the table
+// can be rolled back to an earlier journal position, as speculative search needs when it
+// turns out to have run on a wrong colour.
+class TranspositionTable
+{
+public:
+    struct Stats
+    {
+        long long lookups = 0;
+        long long hits = 0;
+        long long stores = 0;
+        long long evictions = 0;   // stores that overwrote a state from the same solve
+    };
+
+private:
+    struct Entry
+    {
+        uint64_t key = 0;
+        uint32_t generation = 0;   // 0 = never written
+        uint32_t subtreeNodes = 0;
+    };
+
+    std::vector<Entry> entries;   // bucket b is entries[2b] and entries[2b + 1]
+    size_t bucketMask = 0;
+    uint32_t generation = 0;
+    Stats stats;
+
+    struct JournalEntry
+    {
+        size_t bucket;
+        Entry kept;
+        Entry recent;
+    };
+    std::vector<JournalEntry> journal;
+    bool journaling = false;
+
+    static uint64_t mix(uint64_t value);
+
+public:
+    // Rounded down to a power of two; 0 turns the table off
+    void resize(size_t entryCount);
+    size_t capacity() const;
+    bool enabled() const;
+
+    // Forgets every state and resets the stats
+    void newSolve();
+
+    bool knownFailing(uint64_t key);
+    void recordFailure(uint64_t key, uint32_t subtreeNodes);
+    const Stats& getStats() const;
+
+    // Turning the journal off drops it. Stats are not rolled back: they count the work done
+    void setJournaling(bool enabled);
+    size_t journalPosition() const;
+    void rollBack(size_t position);
+
+    // Zobrist feature keys; cell is row * n + col
+    static uint64_t colourKey(int cell, int colour);   // colour known on a cell, 0 for -1
+    static uint64_t budgetKey(int probesLeft);
+    static uint64_t columnKey(int col);                // column holding a queen
+    static uint64_t takenColourKey(int colour);        // colour holding a queen
+    static uint64_t lastColumnKey(int col);            // queen column in the row above
+    static uint64_t queenKey(int cell);                // queen on a cell of unknown colour
+};
+
+#endif
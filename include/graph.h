@@ -8,9 +8,13 @@
 #include <fstream>
 #include <random>
 #include <iostream>
+#include <memory>
+#include "AllocationTracker.h"
 
 // Key: {Queen = 0, Masked = -1, Colour Square = 1 to N-Colours}
 
+using PuzzleGrid = std::vector<std::vector<int>>;
+
 class Graph {
 
     public: 
@@ -22,11 +26,16 @@ class Graph {
         };
 
     private:
-        const std::vector<std::vector<int>> original;
+        // The solution colours are immutable and shared by every Graph made from the same
+        // board; each Graph only owns its masked view and the column of the queen per row
+        std::shared_ptr<const PuzzleGrid> original;
+        double maskingMillis = 0.0;   // declared before masked: set while it is built
+        AllocationStats maskingAllocations;
         std::vector<std::vector<int>> masked;
-        std::vector<std::vector<int>> currentState;
+        std::vector<int> queenCols;
 
         std::vector<std::vector<int>> createMaskedMatrix(const std::vector<std::vector<int>>& original, double mask_prob);
+        std::vector<std::vector<int>> createMaskedMatrix(const std::vector<std::vector<int>>& original, double mask_prob, unsigned int seed);
         std::vector<std::vector<int>> createMaskedMatrix(std::string filename);
         std::vector<std::vector<int>> createSmartMaskedMatrix(const std::vector<std::vector<int>>& original, double mask_prob);
         
@@ -35,13 +44,23 @@ class Graph {
         Graph();
         Graph(const std::vector<std::vector<int>>& data);
         Graph(const std::vector<std::vector<int>>& data, double maskingPercentage);
+        Graph(std::shared_ptr<const PuzzleGrid> data, double maskingPercentage);
+        Graph(std::shared_ptr<const PuzzleGrid> data, double maskingPercentage, unsigned int seed);
+        Graph(std::shared_ptr<const PuzzleGrid> data, const PuzzleGrid& maskedBoard);
 
         // const void printGraph();    
         void printGraph(PrintMode mode = ORIGINAL) const;
-        const std::vector<std::vector<int>> &getOriginal();
+        const std::vector<std::vector<int>> &getOriginal() const;
+        std::shared_ptr<const PuzzleGrid> getSharedOriginal() const;
         std::vector<std::vector<int>> &getMasked();
-        std::vector<std::vector<int>> &getCurrentState();
         int getSize() const;
+        double getMaskingMillis() const;
+        const AllocationStats& getMaskingAllocations() const;
+
+        bool hasQueen(int row, int col) const;
+        int queenColumn(int row) const;
+        void setQueen(int row, int col);
+        void clearQueen(int row);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,111 @@
+#ifndef QUEENS_H
+#define QUEENS_H
+
+/* C interface to the solver, built as bin/libqueens.so (make lib).
+ *
+ * Each queens_solver handle owns its board, settings and last result, and shares nothing
+ * with other handles: any number can solve at once on different threads. Calls on one
+ * handle are serialized by the handle, so a getter issued during a solve waits for it.
+ * Masking is always seeded, so the same board and settings give the same solve.
+ *
+ * Boards are row-major n*n arrays of colours 1..n, with -1 for a cell whose colour is
+ * unknown. A fully coloured board is masked with the handle's masking fraction and its
+ * hidden colours answer the solver's probes; a board that already has -1 cells is solved
+ * from what it shows, without probes.
+ *
+ * Functions return QUEENS_OK (0) or a negative queens_status unless stated otherwise;
+ * queens_last_error describes the most recent failure on a handle. Fields are only ever
+ * appended to queens_stats, and queens_get_stats fills as much as the caller's size holds. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#if defined(__GNUC__)
+#define QUEENS_API __attribute__((visibility("default")))
+#else
+#define QUEENS_API
+#endif
+
+#define QUEENS_ABI_VERSION 1
+
+typedef struct queens_solver queens_solver;
+
+typedef enum
+{
+    QUEENS_OK = 0,
+    QUEENS_ERR_ARGUMENT = -1,   /* null handle, bad size, colour out of range */
+    QUEENS_ERR_NO_BOARD = -2,   /* solve before any board was loaded */
+    QUEENS_ERR_NO_RESULT = -3,  /* result requested before any solve */
+    QUEENS_ERR_INTERNAL = -4    /* the solver failed (out of memory and the like) */
+} queens_status;
+
+typedef enum
+{
+    QUEENS_STRATEGY_HEURISTIC = 0,
+    QUEENS_STRATEGY_MONTE_CARLO = 1
+} queens_strategy;
+
+typedef struct
+{
+    int solved;
+    int timed_out;
+    int grid_size;
+    int queens_placed;
+    int probes_used;
+    int probe_budget;
+    int inferences;
+    int backtracks;
+    int initial_masked_cells;
+    int cells_revealed;
+    double solve_ms;
+    double masking_ms;
+    double inference_ms;
+    double probe_selection_ms;
+    double probe_wait_ms;
+    double search_ms;
+} queens_stats;
+
+/* QUEENS_ABI_VERSION of the library actually loaded */
+QUEENS_API int queens_abi_version(void);
+
+/* NULL only when out of memory */
+QUEENS_API queens_solver* queens_create(void);
+QUEENS_API void queens_destroy(queens_solver* solver);
+
+/* Copies the board; the caller's array can be reused straight away */
+QUEENS_API int queens_load_board(queens_solver* solver, const int* colours, int n);
+
+/* Fraction of cells hidden from a fully coloured board before solving (default 0) */
+QUEENS_API int queens_set_masking(queens_solver* solver, double fraction, unsigned int seed);
+
+/* Probes allowed, as a fraction of the masked cells (default 0.5) */
+QUEENS_API int queens_set_probe_budget(queens_solver* solver, double fraction);
+
+QUEENS_API int queens_set_strategy(queens_solver* solver, queens_strategy strategy, unsigned int seed);
+
+/* Wall-clock limit per solve; 0 or less removes it. A solve that runs out reports
+ * timed_out and keeps its best partial placement. */
+QUEENS_API int queens_set_deadline_ms(queens_solver* solver, double milliseconds);
+
+/* 1 when solved, 0 when not (including a timeout), or a negative queens_status */
+QUEENS_API int queens_solve(queens_solver* solver);
+
+/* Writes the queen's column for each of the first n rows, -1 where there is none, and
+ * returns the number of queens placed (or a negative queens_status) */
+QUEENS_API int queens_get_queens(queens_solver* solver, int* columns, int n);
+
+/* Pass sizeof(queens_stats) as size */
+QUEENS_API int queens_get_stats(queens_solver* solver, queens_stats* stats, size_t size);
+
+/* Never NULL; empty when the last call on the handle succeeded. Valid until the next call
+ * on the same handle. */
+QUEENS_API const char* queens_last_error(queens_solver* solver);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
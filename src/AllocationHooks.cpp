@@ -0,0 +1,83 @@
+#include "../include/AllocationTracker.h"
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+// Replacement global operator new/delete that report every block to AllocationTracker.
+// Linking this file into a binary is what turns allocation tracking on (make ALLOC_TRACK=1).
+// Over-aligned allocations keep the library versions and are not counted.
+
+namespace
+{
+    void* allocate(size_t size)
+    {
+        void* block = std::malloc(size ? size : 1);
+        if (block) {
+            AllocationTracker::recordAllocation(size, malloc_usable_size(block));
+        }
+        return block;
+    }
+
+    void release(void* block)
+    {
+        if (!block) return;
+        AllocationTracker::recordFree(malloc_usable_size(block));
+        std::free(block);
+    }
+
+    const bool registered = (AllocationTracker::markInstalled(), true);
+}
+
+void* operator new(size_t size)
+{
+    void* block = allocate(size);
+    if (!block) throw std::bad_alloc();
+    return block;
+}
+
+void* operator new[](size_t size)
+{
+    void* block = allocate(size);
+    if (!block) throw std::bad_alloc();
+    return block;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void* block) noexcept
+{
+    release(block);
+}
+
+void operator delete[](void* block) noexcept
+{
+    release(block);
+}
+
+void operator delete(void* block, size_t) noexcept
+{
+    release(block);
+}
+
+void operator delete[](void* block, size_t) noexcept
+{
+    release(block);
+}
+
+void operator delete(void* block, const std::nothrow_t&) noexcept
+{
+    release(block);
+}
+
+void operator delete[](void* block, const std::nothrow_t&) noexcept
+{
+    release(block);
+}
@@ -0,0 +1,134 @@
+#include "../include/AllocationTracker.h"
+#include <algorithm>
+
+namespace
+{
+    bool hooksInstalled = false;
+
+    // Plain data with a constant initializer, so the hooks can reach it before any
+    // thread-local constructor has run
+    thread_local AllocationTracker::Context threadContext;
+}
+
+void AllocationStats::merge(const AllocationStats& other)
+{
+    allocations += other.allocations;
+    frees += other.frees;
+    bytes += other.bytes;
+    peakLiveBytes = std::max(peakLiveBytes, other.peakLiveBytes);
+}
+
+void AllocationCounters::merge(const AllocationCounters& other)
+{
+    for (int p = 0; p < phaseCount; p++) {
+        byPhase[p].merge(other.byPhase[p]);
+    }
+    for (int c = 0; c < componentCount; c++) {
+        byComponent[c].merge(other.byComponent[c]);
+    }
+    peakLiveBytes = std::max(peakLiveBytes, other.peakLiveBytes);
+}
+
+AllocationStats AllocationCounters::total() const
+{
+    AllocationStats sum;
+    for (int p = 0; p < phaseCount; p++) {
+        sum.merge(byPhase[p]);
+    }
+    sum.peakLiveBytes = peakLiveBytes;
+    return sum;
+}
+
+const char* AllocationCounters::phaseName(AllocPhase phase)
+{
+    switch (phase) {
+        case AllocPhase::LOADING:         return "loading";
+        case AllocPhase::MASKING:         return "masking";
+        case AllocPhase::SEARCH:          return "search";
+        case AllocPhase::INFERENCE:       return "inference";
+        case AllocPhase::PROBE_SELECTION: return "probe_selection";
+        case AllocPhase::PROBE_WAIT:      return "probe_wait";
+        case AllocPhase::REPORTING:       return "reporting";
+        case AllocPhase::OTHER:           return "other";
+        default:                          return "unknown";
+    }
+}
+
+const char* AllocationCounters::componentName(AllocComponent component)
+{
+    switch (component) {
+        case AllocComponent::SOLVER:  return "solver";
+        case AllocComponent::GRAPH:   return "graph";
+        case AllocComponent::MANAGER: return "manager";
+        case AllocComponent::OTHER:   return "other";
+        default:                      return "unknown";
+    }
+}
+
+bool AllocationTracker::installed()
+{
+    return hooksInstalled;
+}
+
+void AllocationTracker::markInstalled()
+{
+    hooksInstalled = true;
+}
+
+AllocationTracker::Context AllocationTracker::current()
+{
+    return threadContext;
+}
+
+void AllocationTracker::enter(const Context& context)
+{
+    threadContext = context;
+}
+
+void AllocationTracker::recordAllocation(size_t requested, size_t usable)
+{
+    AllocationCounters* counters = threadContext.counters;
+    if (!counters) return;
+
+    counters->liveBytes += (int64_t)usable;
+    counters->peakLiveBytes = std::max(counters->peakLiveBytes, counters->liveBytes);
+
+    AllocationStats& phase = counters->byPhase[(int)threadContext.phase];
+    AllocationStats& component = counters->byComponent[(int)threadContext.component];
+    phase.allocations++;
+    phase.bytes += requested;
+    phase.peakLiveBytes = std::max(phase.peakLiveBytes, counters->liveBytes);
+    component.allocations++;
+    component.bytes += requested;
+    component.peakLiveBytes = std::max(component.peakLiveBytes, counters->liveBytes);
+}
+
+void AllocationTracker::recordFree(size_t usable)
+{
+    AllocationCounters* counters = threadContext.counters;
+    if (!counters) return;
+
+    counters->liveBytes -= (int64_t)usable;
+    counters->byPhase[(int)threadContext.phase].frees++;
+    counters->byComponent[(int)threadContext.component].frees++;
+}
+
+AllocationTracker::Scope::Scope(AllocPhase phase, AllocComponent component)
+    : previous(threadContext)
+{
+    threadContext.phase = phase;
+    threadContext.component = component;
+}
+
+AllocationTracker::Scope::Scope(AllocationCounters& counters, AllocPhase phase, AllocComponent component)
+    : previous(threadContext)
+{
+    threadContext.counters = &counters;
+    threadContext.phase = phase;
+    threadContext.component = component;
+}
+
+AllocationTracker::Scope::~Scope()
+{
+    threadContext = previous;
+}
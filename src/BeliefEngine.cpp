@@ -0,0 +1,380 @@
+#include "../include/BeliefEngine.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace {
+    const int directions[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+    // Colourings with no legal placement are rejected; cap the placement search so a
+    // hopeless colouring cannot stall a worker
+    const int maxPlacementNodes = 20000;
+    const int maxAttemptsPerSample = 8;
+
+    double entropy(const std::map<int, int>& counts, int total)
+    {
+        double h = 0.0;
+        for (auto& [key, count] : counts) {
+            double p = (double)count / total;
+            h -= p * std::log2(p);
+        }
+        return h;
+    }
+}
+
+// Runs tasks 0..count-1 on the helpers and the calling thread. A round ends only once every
+// helper has left it, so no helper can pick up a task of the next round with the old function.
+// One engine's update uses it at a time, holding owner.
+struct BeliefEngine::WorkerPool
+{
+    std::mutex owner;
+    std::vector<std::thread> helpers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::function<void(int)> task;
+    int taskCount = 0;
+    std::atomic<int> nextTask{0};
+    int unfinishedTasks = 0;
+    int busyHelpers = 0;
+    unsigned long round = 0;
+    bool stopping = false;
+
+    explicit WorkerPool(int helperCount)
+    {
+        for (int i = 0; i < helperCount; i++) {
+            helpers.emplace_back([this]() { work(); });
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& helper : helpers) helper.join();
+    }
+
+    void run(int count, std::function<void(int)> function)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = std::move(function);
+            taskCount = count;
+            nextTask = 0;
+            unfinishedTasks = count;
+            round++;
+        }
+        wake.notify_all();
+        drain();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this]() { return unfinishedTasks == 0 && busyHelpers == 0; });
+        task = nullptr;
+    }
+
+private:
+    void drain()
+    {
+        for (int t = nextTask++; t < taskCount; t = nextTask++) {
+            task(t);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--unfinishedTasks == 0) finished.notify_all();
+        }
+    }
+
+    void work()
+    {
+        unsigned long seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&]() { return stopping || round != seen; });
+            if (stopping) return;
+            seen = round;
+            busyHelpers++;
+            lock.unlock();
+            drain();
+            lock.lock();
+            if (--busyHelpers == 0) finished.notify_all();
+        }
+    }
+};
+
+BeliefEngine::BeliefEngine(int samples, int threads, unsigned int seed)
+    : numSamples(samples), numThreads(threads), seed(seed)
+{
+    if (numThreads <= 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+BeliefEngine::WorkerPool& BeliefEngine::sharedPool()
+{
+    static WorkerPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+BeliefEngine::BeliefEngine(BeliefEngine&& other) noexcept = default;
+BeliefEngine& BeliefEngine::operator=(BeliefEngine&& other) noexcept = default;
+BeliefEngine::~BeliefEngine() = default;
+
+// Grow colours outwards from the observed cells in random order. Colours that have not
+// been observed anywhere get a random unknown seed cell first, so every sample uses all
+// n colours.
+bool BeliefEngine::sampleColouring(const std::vector<std::vector<int>>& masked, std::mt19937& gen,
+                                   std::vector<int>& colours)
+{
+    colours.assign(n * n, -1);
+    std::vector<char> observed(numColours + 1, 0);
+    std::vector<int> unknown;
+
+    for (int row = 0; row < n; row++) {
+        for (int col = 0; col < n; col++) {
+            int colour = masked[row][col];
+            colours[row * n + col] = colour;
+            if (colour == -1) {
+                unknown.push_back(row * n + col);
+            } else {
+                observed[colour] = 1;
+            }
+        }
+    }
+
+    std::shuffle(unknown.begin(), unknown.end(), gen);
+    size_t nextSeed = 0;
+    for (int colour = 1; colour <= numColours; colour++) {
+        if (observed[colour]) continue;
+        if (nextSeed == unknown.size()) return false;
+        colours[unknown[nextSeed++]] = colour;
+    }
+
+    std::vector<int> frontier;
+    std::vector<char> inFrontier(n * n, 0);
+    auto pushNeighbours = [&](int cell) {
+        int row = cell / n, col = cell % n;
+        for (int i = 0; i < 4; i++) {
+            int nr = row + directions[i][0];
+            int nc = col + directions[i][1];
+            if (nr >= 0 && nr < n && nc >= 0 && nc < n) {
+                int next = nr * n + nc;
+                if (colours[next] == -1 && !inFrontier[next]) {
+                    inFrontier[next] = 1;
+                    frontier.push_back(next);
+                }
+            }
+        }
+    };
+
+    for (int cell = 0; cell < n * n; cell++) {
+        if (colours[cell] != -1) pushNeighbours(cell);
+    }
+
+    while (!frontier.empty()) {
+        std::uniform_int_distribution<size_t> pick(0, frontier.size() - 1);
+        size_t idx = pick(gen);
+        int cell = frontier[idx];
+        frontier[idx] = frontier.back();
+        frontier.pop_back();
+
+        int row = cell / n, col = cell % n;
+        int options[4];
+        int numOptions = 0;
+        for (int i = 0; i < 4; i++) {
+            int nr = row + directions[i][0];
+            int nc = col + directions[i][1];
+            if (nr >= 0 && nr < n && nc >= 0 && nc < n && colours[nr * n + nc] != -1) {
+                options[numOptions++] = colours[nr * n + nc];
+            }
+        }
+        std::uniform_int_distribution<int> choose(0, numOptions - 1);
+        colours[cell] = options[choose(gen)];
+        pushNeighbours(cell);
+    }
+
+    return true;
+}
+
+// Random-order backtracking: one queen per row, column and colour, no diagonal touching
+bool BeliefEngine::sampleQueens(const std::vector<int>& colours, std::mt19937& gen,
+                                std::vector<int>& queenCols)
+{
+    std::vector<std::vector<int>> order(n);
+    for (int row = 0; row < n; row++) {
+        order[row].resize(n);
+        for (int col = 0; col < n; col++) order[row][col] = col;
+        std::shuffle(order[row].begin(), order[row].end(), gen);
+    }
+
+    queenCols.assign(n, -1);
+    std::vector<char> colUsed(n, 0);
+    std::vector<char> colourUsed(numColours + 1, 0);
+    int nodes = 0;
+
+    auto place = [&](auto& self, int row) -> bool {
+        if (row == n) return true;
+        if (++nodes > maxPlacementNodes) return false;
+
+        for (int col : order[row]) {
+            int colour = colours[row * n + col];
+            if (colUsed[col] || colourUsed[colour]) continue;
+            if (row > 0 && std::abs(queenCols[row - 1] - col) == 1) continue;
+
+            colUsed[col] = 1;
+            colourUsed[colour] = 1;
+            queenCols[row] = col;
+            if (self(self, row + 1)) return true;
+            colUsed[col] = 0;
+            colourUsed[colour] = 0;
+            queenCols[row] = -1;
+        }
+        return false;
+    };
+
+    return place(place, 0);
+}
+
+void BeliefEngine::drawSamples(const std::vector<std::vector<int>>& masked, int count,
+                               unsigned int workerSeed, std::vector<Sample>& out)
+{
+    std::mt19937 gen(workerSeed);
+    Sample sample;
+
+    for (int attempt = 0; attempt < count * maxAttemptsPerSample && (int)out.size() < count; attempt++) {
+        if (!sampleColouring(masked, gen, sample.colours)) continue;
+        if (!sampleQueens(sample.colours, gen, sample.queenCols)) continue;
+        out.push_back(sample);
+    }
+}
+
+void BeliefEngine::update(const std::vector<std::vector<int>>& masked)
+{
+    n = masked.size();
+    numColours = n;
+    for (auto& row : masked) {
+        for (int colour : row) numColours = std::max(numColours, colour);
+    }
+
+    // Every batch gets a fixed seed, so a given thread count reproduces the same belief
+    // whichever thread draws each batch
+    std::vector<std::vector<Sample>> perWorker(numThreads);
+    auto drawBatch = [this, &masked, &perWorker](int w) {
+        int count = numSamples / numThreads + (w < numSamples % numThreads ? 1 : 0);
+        drawSamples(masked, count, seed + 7919u * w, perWorker[w]);
+    };
+    std::unique_lock<std::mutex> helpers;
+    if (numThreads > 1 && numSamples >= parallelSampleThreshold) {
+        helpers = std::unique_lock<std::mutex>(sharedPool().owner, std::try_to_lock);
+    }
+    if (helpers.owns_lock()) {
+        sharedPool().run(numThreads, drawBatch);
+    } else {
+        for (int w = 0; w < numThreads; w++) drawBatch(w);
+    }
+    seed += 104729u;
+
+    samples.clear();
+    for (auto& batch : perWorker) {
+        for (auto& sample : batch) samples.push_back(std::move(sample));
+    }
+
+    std::map<std::vector<int>, int> placementIds;
+    solutionIds.clear();
+    for (auto& sample : samples) {
+        auto it = placementIds.emplace(sample.queenCols, placementIds.size()).first;
+        solutionIds.push_back(it->second);
+    }
+
+    colourCounts.assign(n * n, std::vector<int>(numColours + 1, 0));
+    for (auto& sample : samples) {
+        for (int cell = 0; cell < n * n; cell++) {
+            colourCounts[cell][sample.colours[cell]]++;
+        }
+    }
+}
+
+int BeliefEngine::acceptedSamples() const
+{
+    return samples.size();
+}
+
+int BeliefEngine::sampleCount() const
+{
+    return numSamples;
+}
+
+int BeliefEngine::threadCount() const
+{
+    return numThreads;
+}
+
+unsigned int BeliefEngine::nextSeed() const
+{
+    return seed;
+}
+
+double BeliefEngine::colourProbability(int row, int col, int colour) const
+{
+    if (samples.empty() || colour < 0 || colour > numColours) return 0.0;
+    return (double)colourCounts[row * n + col][colour] / samples.size();
+}
+
+double BeliefEngine::colourEntropy(int row, int col) const
+{
+    if (samples.empty()) return 0.0;
+
+    std::map<int, int> counts;
+    for (int colour = 1; colour <= numColours; colour++) {
+        int count = colourCounts[row * n + col][colour];
+        if (count > 0) counts[colour] = count;
+    }
+    return entropy(counts, samples.size());
+}
+
+// I(X; Q) = H(Q) - sum_x p(x) H(Q | X = x), with Q the sampled queen placement
+double BeliefEngine::expectedInformationGain(int row, int col) const
+{
+    int total = samples.size();
+    if (total == 0) return 0.0;
+
+    int cell = row * n + col;
+    std::map<int, int> placementCounts;
+    std::map<int, std::map<int, int>> placementsByColour;
+    for (int s = 0; s < total; s++) {
+        placementCounts[solutionIds[s]]++;
+        placementsByColour[samples[s].colours[cell]][solutionIds[s]]++;
+    }
+
+    double conditional = 0.0;
+    for (auto& [colour, counts] : placementsByColour) {
+        int colourTotal = colourCounts[cell][colour];
+        conditional += (double)colourTotal / total * entropy(counts, colourTotal);
+    }
+
+    return entropy(placementCounts, total) - conditional;
+}
+
+std::vector<std::pair<int, int>> BeliefEngine::rankProbes(const std::vector<std::pair<int, int>>& candidates, int k) const
+{
+    // Colour entropy breaks ties once the sampled placements already agree
+    std::vector<std::pair<double, std::pair<int, int>>> scored;
+    for (auto [row, col] : candidates) {
+        double score = expectedInformationGain(row, col) + 0.1 * colourEntropy(row, col);
+        scored.push_back({score, {row, col}});
+    }
+
+    std::stable_sort(scored.begin(), scored.end(),
+                     [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    std::vector<std::pair<int, int>> result;
+    for (int i = 0; i < std::min(k, (int)scored.size()); i++) {
+        result.push_back(scored[i].second);
+    }
+    return result;
+}
@@ -0,0 +1,86 @@
+#include "../include/CSPLinkedInSolver.h"
+#include <cstdlib>
+
+bool CSPLinkedInSolver::isValid(int row, int col) {
+    int cellColour = puzzle.getOriginal()[row][col];
+
+    // Check if another queen already placed in same column
+    for (int r = 0; r < n; r++) {
+        if (r != row && board[r][col] == 1) {
+            return false;
+        }
+    }
+
+    // Check diagonal adjacency (LinkedIn rule: only diagonal touching forbidden)
+    for (int r = 0; r < n; r++) {
+        for (int c = 0; c < n; c++) {
+            if (board[r][c] == 1) {
+                // Check if diagonally adjacent
+                if (abs(row - r) == 1 && abs(col - c) == 1) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Check colour constraint: no other queen in same colour region
+    for (int r = 0; r < n; r++) {
+        for (int c = 0; c < n; c++) {
+            if (board[r][c] == 1) {
+                if (puzzle.getOriginal()[r][c] == cellColour) {
+                    return false;  // Another queen in same colour
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+bool CSPLinkedInSolver::solveBacktrack(int row) {
+    if (row == n) {
+        return true;  // All queens placed
+    }
+
+    // Try each column in this row
+    for (int col = 0; col < n; col++) {
+        if (isValid(row, col)) {
+            // Place queen
+            board[row][col] = 1;
+            solution.push_back({row, col});
+
+            // Recurse
+            if (solveBacktrack(row + 1)) {
+                return true;
+            }
+
+            // Backtrack
+            board[row][col] = 0;
+            solution.pop_back();
+        }
+    }
+
+    return false;  // No solution from this state
+}
+
+CSPLinkedInSolver::CSPLinkedInSolver(Graph& g) : puzzle(g), n(g.getSize()) {
+    // Initialize empty board
+    board.resize(n, std::vector<int>(n, 0));
+}
+
+bool CSPLinkedInSolver::solve() {
+    solution.clear();
+    return solveBacktrack(0);
+}
+
+std::vector<std::pair<int, int>> CSPLinkedInSolver::getSolution() const {
+    return solution;
+}
+
+void CSPLinkedInSolver::printSolution() const {
+    std::cout << "Solution (row,col): ";
+    for (const auto& [r, c] : solution) {
+        std::cout << "(" << r << "," << c << ") ";
+    }
+    std::cout << std::endl;
+}
@@ -0,0 +1,231 @@
+#include "../include/DecisionTrace.h"
+#include <fstream>
+
+namespace
+{
+    template <typename T>
+    void put(std::ofstream& out, T value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template <typename T>
+    bool get(std::ifstream& in, T& value)
+    {
+        return (bool)in.read(reinterpret_cast<char*>(&value), sizeof(value));
+    }
+
+    void putBoard(std::ofstream& out, const std::vector<std::vector<int>>& board, int n)
+    {
+        for (int r = 0; r < n; r++) {
+            for (int c = 0; c < n; c++) {
+                put<uint8_t>(out, (uint8_t)board[r][c]);
+            }
+        }
+    }
+
+    bool getBoard(std::ifstream& in, std::vector<std::vector<int>>& board, int n)
+    {
+        board.assign(n, std::vector<int>(n));
+        for (int r = 0; r < n; r++) {
+            for (int c = 0; c < n; c++) {
+                uint8_t value;
+                if (!get(in, value)) return false;
+                board[r][c] = value == 255 ? -1 : value;
+            }
+        }
+        return true;
+    }
+
+    // Bytes between the read position and the end of the file
+    uint64_t remainingBytes(std::ifstream& in)
+    {
+        std::streampos position = in.tellg();
+        in.seekg(0, std::ios::end);
+        std::streampos end = in.tellg();
+        in.seekg(position);
+        return end > position ? (uint64_t)(end - position) : 0;
+    }
+}
+
+bool TraceEvent::sameDecision(const TraceEvent& other) const
+{
+    return kindFlags == other.kindFlags && row == other.row && col == other.col && value == other.value;
+}
+
+const char* TraceEvent::kindName(TraceEventKind kind)
+{
+    switch (kind) {
+        case TraceEventKind::PROBE:  return "probe";
+        case TraceEventKind::INFER:  return "infer";
+        case TraceEventKind::PLACE:  return "place";
+        case TraceEventKind::UNDO:   return "undo";
+        case TraceEventKind::PRUNE:  return "prune";
+        case TraceEventKind::REVERT: return "revert";
+        case TraceEventKind::END:    return "end";
+        case TraceEventKind::TIME:   return "time";
+        default:                     return "unknown";
+    }
+}
+
+DecisionTrace::DecisionTrace(size_t ringEvents) : ringCapacity(ringEvents)
+{
+    if (ringCapacity > 0) {
+        events.reserve(ringCapacity);
+    }
+}
+
+void DecisionTrace::begin(const TraceHeader& start)
+{
+    int puzzleNumber = header.puzzleNumber;
+    header = start;
+    if (header.puzzleNumber == 0) header.puzzleNumber = puzzleNumber;
+    events.clear();
+    ringStart = 0;
+    recording = true;
+    lastEvent = std::chrono::steady_clock::now();
+}
+
+void DecisionTrace::end(bool solved)
+{
+    record(TraceEventKind::END, -1, -1, solved ? 1 : 0);
+    recording = false;
+}
+
+// Once full, the ring overwrites its oldest event
+void DecisionTrace::append(const TraceEvent& event)
+{
+    if (ringCapacity == 0 || events.size() < ringCapacity) {
+        events.push_back(event);
+        return;
+    }
+    events[ringStart] = event;
+    ringStart = (ringStart + 1) % ringCapacity;
+    header.droppedEvents++;
+}
+
+const TraceHeader& DecisionTrace::getHeader() const
+{
+    return header;
+}
+
+void DecisionTrace::setPuzzleNumber(int puzzleNumber)
+{
+    header.puzzleNumber = puzzleNumber;
+}
+
+std::vector<TraceEvent> DecisionTrace::orderedEvents() const
+{
+    std::vector<TraceEvent> ordered(events.begin() + ringStart, events.end());
+    ordered.insert(ordered.end(), events.begin(), events.begin() + ringStart);
+    return ordered;
+}
+
+size_t DecisionTrace::eventCount() const
+{
+    return events.size();
+}
+
+bool DecisionTrace::save(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    put<uint32_t>(out, TraceHeader::magic);
+    put<uint16_t>(out, TraceHeader::version);
+    put<uint16_t>(out, (uint16_t)header.gridSize);
+    put<int32_t>(out, header.puzzleNumber);
+    put<double>(out, header.probeBudgetPercent);
+    put<int32_t>(out, header.probeBudget);
+    put<uint8_t>(out, (uint8_t)header.strategy);
+    put<uint8_t>(out, (uint8_t)(header.speculative | header.pooledBudget << 1 | header.concurrent << 2));
+    put<uint16_t>(out, 0);
+    put<int32_t>(out, header.beliefSamples);
+    put<int32_t>(out, header.beliefThreads);
+    put<uint32_t>(out, header.beliefSeed);
+    put<uint64_t>(out, header.droppedEvents);
+    put<uint16_t>(out, (uint16_t)SolverParameters::fieldCount);
+    for (int i = 0; i < SolverParameters::fieldCount; i++) {
+        put<double>(out, header.parameters.get(i));
+    }
+    putBoard(out, header.original, header.gridSize);
+    putBoard(out, header.masked, header.gridSize);
+
+    std::vector<TraceEvent> ordered = orderedEvents();
+    put<uint64_t>(out, ordered.size());
+    out.write(reinterpret_cast<const char*>(ordered.data()), ordered.size() * sizeof(TraceEvent));
+    return (bool)out;
+}
+
+bool DecisionTrace::load(const std::string& path, std::string& error)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    uint32_t magic = 0;
+    uint16_t version = 0, gridSize = 0, reserved = 0;
+    uint8_t strategy = 0, flags = 0;
+    if (!get(in, magic) || magic != TraceHeader::magic) {
+        error = path + " is not a decision trace";
+        return false;
+    }
+    if (!get(in, version) || version < 1 || version > TraceHeader::version) {
+        error = path + " has unsupported trace version " + std::to_string(version);
+        return false;
+    }
+
+    TraceHeader loaded;
+    bool ok = get(in, gridSize) && get(in, loaded.puzzleNumber) && get(in, loaded.probeBudgetPercent) &&
+              get(in, loaded.probeBudget) && get(in, strategy) && get(in, flags) && get(in, reserved) &&
+              get(in, loaded.beliefSamples) && get(in, loaded.beliefThreads) && get(in, loaded.beliefSeed) &&
+              get(in, loaded.droppedEvents);
+    loaded.gridSize = gridSize;
+    loaded.strategy = strategy;
+    loaded.speculative = flags & 1;
+    loaded.pooledBudget = flags & 2;
+    loaded.concurrent = flags & 4;
+
+    // Parameters are stored in field order; fields added since the trace was written keep
+    // their defaults
+    uint16_t parameterCount = 0;
+    if (version >= 2) {
+        ok = ok && get(in, parameterCount);
+        for (int i = 0; ok && i < parameterCount; i++) {
+            double value = 0.0;
+            ok = get(in, value);
+            if (ok && i < SolverParameters::fieldCount) loaded.parameters.set(i, value);
+        }
+    }
+    // Sizes read from the header are checked against the file before anything is allocated
+    // for them, so a damaged count is reported rather than tried
+    ok = ok && remainingBytes(in) >= 2ull * gridSize * gridSize;
+    ok = ok && getBoard(in, loaded.original, gridSize) && getBoard(in, loaded.masked, gridSize);
+
+    uint64_t count = 0;
+    ok = ok && get(in, count);
+    if (!ok) {
+        error = path + " is truncated";
+        return false;
+    }
+    if (count > remainingBytes(in) / sizeof(TraceEvent)) {
+        error = path + " claims " + std::to_string(count) + " events but holds fewer";
+        return false;
+    }
+
+    std::vector<TraceEvent> loadedEvents(count);
+    if (!in.read(reinterpret_cast<char*>(loadedEvents.data()), count * sizeof(TraceEvent))) {
+        error = path + " is truncated";
+        return false;
+    }
+
+    header = loaded;
+    events = std::move(loadedEvents);
+    ringStart = 0;
+    recording = false;
+    return true;
+}
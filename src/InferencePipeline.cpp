@@ -0,0 +1,186 @@
+#include "../include/InferencePipeline.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+void InferenceRuleStats::merge(const InferenceRuleStats& other)
+{
+    calls += other.calls;
+    yields += other.yields;
+    agreed += other.agreed;
+    skipped += other.skipped;
+    millis += other.millis;
+}
+
+InferencePipeline::InferencePipeline(float voteThreshold) : threshold(onGrid(voteThreshold))
+{
+    weightFrom[0] = 0.0f;
+}
+
+// maxWeight is 2^18 steps, so maxRules of them add up within a float's 24 bits
+float InferencePipeline::onGrid(float value)
+{
+    if (!std::isfinite(value) || value < 0.0f || value > maxWeight) {
+        throw std::invalid_argument("InferencePipeline weights and thresholds must lie in [0, " +
+                                    std::to_string((int)maxWeight) + "]");
+    }
+    return std::round(value / weightStep) * weightStep;
+}
+
+int InferencePipeline::addRule(const std::string& name, float weight, double cost, uint8_t tag)
+{
+    if ((int)rules.size() == maxRules) {
+        throw std::length_error("InferencePipeline holds at most " + std::to_string(maxRules) + " rules");
+    }
+    int number = rules.size();
+    Rule rule;
+    rule.weight = onGrid(weight);
+    rule.cost = std::max(cost, 1e-9);
+    rule.tag = tag;
+    rule.stats.name = name;
+    rules.push_back(rule);
+    reorder();
+    return number;
+}
+
+int InferencePipeline::ruleCount() const
+{
+    return rules.size();
+}
+
+void InferencePipeline::setWeight(int rule, float weight)
+{
+    rules[rule].weight = onGrid(weight);
+    reorder();
+}
+
+void InferencePipeline::setThreshold(float voteThreshold)
+{
+    threshold = onGrid(voteThreshold);
+}
+
+void InferencePipeline::vote(int rule, int colour)
+{
+    Rule& entry = rules[rule];
+    entry.stats.calls++;
+    entry.lifetimeCalls++;
+    if (colour == -1) return;
+    entry.stats.yields++;
+    entry.lifetimeYields++;
+
+    for (int i = 0; i < voteCount; i++) {
+        if (voteColours[i] == colour) {
+            voteWeights[i] += entry.weight;
+            return;
+        }
+    }
+    voteColours[voteCount] = colour;
+    voteWeights[voteCount] = entry.weight;
+    voteCount++;
+}
+
+// Whether the rules from this position on can still change the winner. A colour can end up
+// at most its weight so far plus everything left; one no rule has named yet, at most what
+// is left.
+bool InferencePipeline::settled(int position) const
+{
+    float left = weightFrom[position];
+    if (left == 0.0f) return true;
+
+    int leader = -1;
+    for (int i = 0; i < voteCount; i++) {
+        if (leader == -1 || voteWeights[i] > voteWeights[leader] ||
+            (voteWeights[i] == voteWeights[leader] && voteColours[i] < voteColours[leader])) {
+            leader = i;
+        }
+    }
+
+    // Nothing can get above the threshold any more
+    float best = leader == -1 ? 0.0f : voteWeights[leader];
+    if (best + left <= threshold) return true;
+
+    // The leader is through and out of reach: an unnamed colour could only tie it with
+    // everything left, and might win that tie
+    if (leader == -1 || best <= threshold || left >= best) return false;
+    for (int i = 0; i < voteCount; i++) {
+        if (i == leader) continue;
+        float reach = voteWeights[i] + left;
+        if (reach > best || (reach == best && voteColours[i] < voteColours[leader])) return false;
+    }
+    return true;
+}
+
+int InferencePipeline::finishVote(int ranUpTo, uint8_t& tags, const int* named)
+{
+    int count = rules.size();
+    for (int position = ranUpTo; position < count; position++) {
+        rules[order[position]].stats.skipped++;
+    }
+
+    int winner = -1;
+    float best = threshold;
+    for (int i = 0; i < voteCount; i++) {
+        if (voteWeights[i] > best || (winner != -1 && voteWeights[i] == best && voteColours[i] < winner)) {
+            best = voteWeights[i];
+            winner = voteColours[i];
+        }
+    }
+
+    tags = 0;
+    if (winner != -1) {
+        for (int position = 0; position < ranUpTo; position++) {
+            if (named[position] != winner) continue;
+            Rule& rule = rules[order[position]];
+            rule.stats.agreed++;
+            tags |= rule.tag;
+        }
+    }
+
+    if (++evaluations % reorderInterval == 0) {
+        reorder();
+    }
+    return winner;
+}
+
+// Expected weight added per unit of cost, with the yield starting from an even prior
+void InferencePipeline::reorder()
+{
+    int count = rules.size();
+    std::vector<double> value(count);
+    for (int i = 0; i < count; i++) {
+        const Rule& rule = rules[i];
+        double yield = (rule.lifetimeYields + 1.0) / (rule.lifetimeCalls + 2.0);
+        value[i] = rule.weight * yield / rule.cost;
+        order[i] = i;
+    }
+    std::stable_sort(order, order + count, [&](int a, int b) { return value[a] > value[b]; });
+
+    weightFrom[count] = 0.0f;
+    for (int i = count - 1; i >= 0; i--) {
+        weightFrom[i] = weightFrom[i + 1] + rules[order[i]].weight;
+    }
+}
+
+std::vector<InferenceRuleStats> InferencePipeline::getStats() const
+{
+    std::vector<InferenceRuleStats> result;
+    for (size_t i = 0; i < rules.size(); i++) {
+        InferenceRuleStats stats = rules[i].stats;
+        if (rules[i].timedCalls > 0) {
+            stats.millis = (double)rules[i].timedNanos / rules[i].timedCalls * stats.calls / 1e6;
+        }
+        result.push_back(stats);
+    }
+    return result;
+}
+
+void InferencePipeline::resetStats()
+{
+    for (Rule& rule : rules) {
+        std::string name = rule.stats.name;
+        rule.stats = InferenceRuleStats();
+        rule.stats.name = name;
+        rule.timedCalls = 0;
+        rule.timedNanos = 0;
+    }
+}
@@ -0,0 +1,54 @@
+#include "../include/Instrumentation.h"
+
+void InstrumentationCounters::merge(const InstrumentationCounters& other)
+{
+    for (int i = 0; i < siteCount; i++) {
+        calls[i] += other.calls[i];
+        hits[i] += other.hits[i];
+        nanos[i] += other.nanos[i];
+    }
+    for (int d = 0; d < maxDepth; d++) {
+        nodesAtDepth[d] += other.nodesAtDepth[d];
+    }
+}
+
+uint64_t InstrumentationCounters::totalNodes() const
+{
+    uint64_t total = 0;
+    for (int d = 0; d < maxDepth; d++) {
+        total += nodesAtDepth[d];
+    }
+    return total;
+}
+
+const char* InstrumentationCounters::siteName(InstrumentSite site)
+{
+    switch (site) {
+        case InstrumentSite::INFER_STRICT:      return "infer_strict";
+        case InstrumentSite::RULE_NEIGHBOURS:   return "rule_neighbours";
+        case InstrumentSite::RULE_UNIFORMITY:   return "rule_uniformity";
+        case InstrumentSite::RULE_DOMAINS:      return "rule_domains";
+        case InstrumentSite::RULE_CONTIGUITY:   return "rule_contiguity";
+        case InstrumentSite::RULE_PATTERN:      return "rule_pattern";
+        case InstrumentSite::INFER_WEAK:        return "infer_weak";
+        case InstrumentSite::WEAK_NEIGHBOURS:   return "weak_neighbours";
+        case InstrumentSite::WEAK_UNIFORMITY:   return "weak_uniformity";
+        case InstrumentSite::WEAK_DOMAINS:      return "weak_domains";
+        case InstrumentSite::WEAK_CONTIGUITY:   return "weak_contiguity";
+        case InstrumentSite::WEAK_PATTERN:      return "weak_pattern";
+        case InstrumentSite::IS_VALID:          return "is_valid";
+        case InstrumentSite::FIND_VIABLE:       return "find_viable";
+        case InstrumentSite::INFERENCE_CASCADE: return "inference_cascade";
+        default:                                return "unknown";
+    }
+}
+
+bool InstrumentationCounters::countsHits(InstrumentSite site)
+{
+    return site < InstrumentSite::IS_VALID;
+}
+
+bool InstrumentationCounters::isTimed(InstrumentSite site)
+{
+    return site >= InstrumentSite::IS_VALID && site < InstrumentSite::COUNT;
+}
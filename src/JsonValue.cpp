@@ -0,0 +1,204 @@
+#include "../include/JsonValue.h"
+#include <cstdlib>
+#include <stdexcept>
+
+class JsonParser
+{
+private:
+    const std::string& source;
+    size_t pos = 0;
+
+    [[noreturn]] void fail(const std::string& what)
+    {
+        throw std::runtime_error("JSON: " + what + " at offset " + std::to_string(pos));
+    }
+
+    void skipSpace()
+    {
+        while (pos < source.size() && (source[pos] == ' ' || source[pos] == '\t' ||
+                                       source[pos] == '\n' || source[pos] == '\r')) {
+            pos++;
+        }
+    }
+
+    void expect(char c)
+    {
+        skipSpace();
+        if (pos >= source.size() || source[pos] != c) fail(std::string("expected '") + c + "'");
+        pos++;
+    }
+
+    bool consume(const char* word)
+    {
+        size_t length = std::char_traits<char>::length(word);
+        if (source.compare(pos, length, word) != 0) return false;
+        pos += length;
+        return true;
+    }
+
+    std::string parseString()
+    {
+        expect('"');
+        std::string result;
+        while (pos < source.size() && source[pos] != '"') {
+            char c = source[pos++];
+            if (c != '\\') {
+                result += c;
+                continue;
+            }
+            if (pos >= source.size()) break;
+            char escaped = source[pos++];
+            switch (escaped) {
+                case 'n': result += '\n'; break;
+                case 't': result += '\t'; break;
+                case 'r': result += '\r'; break;
+                case 'b': result += '\b'; break;
+                case 'f': result += '\f'; break;
+                case 'u': {
+                    // Basic multilingual plane only, written out as UTF-8
+                    if (pos + 4 > source.size()) fail("truncated \\u escape");
+                    unsigned code = std::strtoul(source.substr(pos, 4).c_str(), nullptr, 16);
+                    pos += 4;
+                    if (code < 0x80) {
+                        result += (char)code;
+                    } else if (code < 0x800) {
+                        result += (char)(0xC0 | (code >> 6));
+                        result += (char)(0x80 | (code & 0x3F));
+                    } else {
+                        result += (char)(0xE0 | (code >> 12));
+                        result += (char)(0x80 | ((code >> 6) & 0x3F));
+                        result += (char)(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default: result += escaped; break;
+            }
+        }
+        if (pos >= source.size()) fail("unterminated string");
+        pos++;
+        return result;
+    }
+
+public:
+    explicit JsonParser(const std::string& text) : source(text) {}
+
+    JsonValue parseValue()
+    {
+        skipSpace();
+        if (pos >= source.size()) fail("unexpected end of input");
+
+        JsonValue value;
+        char c = source[pos];
+        if (c == '{') {
+            value.kind = JsonValue::Type::OBJECT;
+            pos++;
+            skipSpace();
+            if (pos < source.size() && source[pos] == '}') {
+                pos++;
+                return value;
+            }
+            while (true) {
+                std::string key = parseString();
+                expect(':');
+                value.fields.emplace_back(std::move(key), parseValue());
+                skipSpace();
+                if (pos < source.size() && source[pos] == ',') {
+                    pos++;
+                    continue;
+                }
+                expect('}');
+                return value;
+            }
+        }
+        if (c == '[') {
+            value.kind = JsonValue::Type::ARRAY;
+            pos++;
+            skipSpace();
+            if (pos < source.size() && source[pos] == ']') {
+                pos++;
+                return value;
+            }
+            while (true) {
+                value.elements.push_back(parseValue());
+                skipSpace();
+                if (pos < source.size() && source[pos] == ',') {
+                    pos++;
+                    continue;
+                }
+                expect(']');
+                return value;
+            }
+        }
+        if (c == '"') {
+            value.kind = JsonValue::Type::STRING;
+            value.text = parseString();
+            return value;
+        }
+        if (consume("true")) {
+            value.kind = JsonValue::Type::BOOL;
+            value.boolean = true;
+            return value;
+        }
+        if (consume("false")) {
+            value.kind = JsonValue::Type::BOOL;
+            return value;
+        }
+        if (consume("null")) {
+            return value;
+        }
+
+        const char* start = source.c_str() + pos;
+        char* end = nullptr;
+        value.number = std::strtod(start, &end);
+        if (end == start) fail("unexpected character");
+        value.kind = JsonValue::Type::NUMBER;
+        pos += end - start;
+        return value;
+    }
+
+    void finish()
+    {
+        skipSpace();
+        if (pos != source.size()) fail("trailing characters");
+    }
+};
+
+JsonValue JsonValue::parse(const std::string& source)
+{
+    JsonParser parser(source);
+    JsonValue value = parser.parseValue();
+    parser.finish();
+    return value;
+}
+
+double JsonValue::asNumber(double fallback) const
+{
+    return kind == Type::NUMBER ? number : fallback;
+}
+
+bool JsonValue::asBool(bool fallback) const
+{
+    return kind == Type::BOOL ? boolean : fallback;
+}
+
+std::string JsonValue::asString(const std::string& fallback) const
+{
+    return kind == Type::STRING ? text : fallback;
+}
+
+bool JsonValue::has(const std::string& key) const
+{
+    for (const auto& [name, value] : fields) {
+        if (name == key) return true;
+    }
+    return false;
+}
+
+const JsonValue& JsonValue::operator[](const std::string& key) const
+{
+    static const JsonValue missing;
+    for (const auto& [name, value] : fields) {
+        if (name == key) return value;
+    }
+    return missing;
+}
@@ -0,0 +1,87 @@
+#include "../include/LatencyHistogram.h"
+#include <algorithm>
+
+// Values below 128 us map to themselves. Above that, the value is shifted right until it
+// lies in [64, 128); each shift amount owns 64 consecutive buckets.
+int LatencyHistogram::indexOf(uint64_t micros)
+{
+    if (micros < (uint64_t)linearLimit) {
+        return micros;
+    }
+
+    int shift = 63 - __builtin_clzll(micros) - subBucketBits;
+    int subBucket = (micros >> shift) - subBucketCount;
+    return linearLimit + (shift - 1) * subBucketCount + subBucket;
+}
+
+uint64_t LatencyHistogram::highestEquivalent(int index)
+{
+    if (index < linearLimit) {
+        return index;
+    }
+
+    int shift = (index - linearLimit) / subBucketCount + 1;
+    uint64_t subBucket = (index - linearLimit) % subBucketCount + subBucketCount;
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(double millis)
+{
+    uint64_t micros = millis <= 0.0 ? 0 : (uint64_t)(millis * 1000.0 + 0.5);
+    int index = indexOf(micros);
+    if (index >= (int)counts.size()) {
+        counts.resize(index + 1, 0);
+    }
+
+    counts[index]++;
+    total++;
+    maxMicros = std::max(maxMicros, micros);
+    sumMicros += micros;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    if (other.counts.size() > counts.size()) {
+        counts.resize(other.counts.size(), 0);
+    }
+    for (size_t i = 0; i < other.counts.size(); i++) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+    maxMicros = std::max(maxMicros, other.maxMicros);
+    sumMicros += other.sumMicros;
+}
+
+uint64_t LatencyHistogram::count() const
+{
+    return total;
+}
+
+// Smallest bucket whose cumulative count reaches the requested rank, reported as the
+// highest value that bucket can hold (never above the recorded maximum)
+double LatencyHistogram::percentile(double percent) const
+{
+    if (total == 0) return 0.0;
+
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t)(percent / 100.0 * total + 0.5));
+    rank = std::min(rank, total);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(highestEquivalent(i), maxMicros) / 1000.0;
+        }
+    }
+    return maxMicros / 1000.0;
+}
+
+double LatencyHistogram::max() const
+{
+    return maxMicros / 1000.0;
+}
+
+double LatencyHistogram::mean() const
+{
+    return total == 0 ? 0.0 : sumMicros / total / 1000.0;
+}
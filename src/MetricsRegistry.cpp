@@ -0,0 +1,259 @@
+#include "../include/MetricsRegistry.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    std::string formatNumber(double value)
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.10g", value);
+        return text;
+    }
+
+    std::string escapeLabel(const std::string& value)
+    {
+        std::string result;
+        for (char c : value) {
+            if (c == '\\' || c == '"') {
+                result += '\\';
+                result += c;
+            } else if (c == '\n') {
+                result += "\\n";
+            } else {
+                result += c;
+            }
+        }
+        return result;
+    }
+
+    // {a="1",b="2"}, with an optional extra label appended (histogram le)
+    std::string labelSet(const MetricLabels& labels, const std::string& extraName = "",
+                         const std::string& extraValue = "")
+    {
+        if (labels.empty() && extraName.empty()) return "";
+        std::string result = "{";
+        for (size_t i = 0; i < labels.size(); i++) {
+            if (i > 0) result += ",";
+            result += labels[i].first + "=\"" + escapeLabel(labels[i].second) + "\"";
+        }
+        if (!extraName.empty()) {
+            if (!labels.empty()) result += ",";
+            result += extraName + "=\"" + extraValue + "\"";
+        }
+        return result + "}";
+    }
+
+    const char* typeName(MetricType type)
+    {
+        switch (type) {
+            case MetricType::COUNTER:   return "counter";
+            case MetricType::GAUGE:     return "gauge";
+            case MetricType::HISTOGRAM: return "histogram";
+            default:                    return "unknown";
+        }
+    }
+
+    double nowSeconds()
+    {
+        return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+}
+
+MetricId MetricsRegistry::add(const std::string& name, const std::string& help, const std::string& unit,
+                              MetricType type, std::vector<double> bounds)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::sort(bounds.begin(), bounds.end());
+    families.push_back({name, help, unit, type, std::move(bounds), {}});
+    return families.size() - 1;
+}
+
+MetricId MetricsRegistry::addCounter(const std::string& name, const std::string& help)
+{
+    return add(name, help, "", MetricType::COUNTER, {});
+}
+
+MetricId MetricsRegistry::addGauge(const std::string& name, const std::string& help, const std::string& unit)
+{
+    return add(name, help, unit, MetricType::GAUGE, {});
+}
+
+MetricId MetricsRegistry::addHistogram(const std::string& name, const std::string& help, const std::string& unit,
+                                       std::vector<double> bounds)
+{
+    return add(name, help, unit, MetricType::HISTOGRAM, std::move(bounds));
+}
+
+// Callers hold the mutex. A family has few label combinations, so a scan is enough.
+MetricsRegistry::Series& MetricsRegistry::seriesFor(MetricId id, const MetricLabels& labels)
+{
+    Family& family = families[id];
+    for (Series& series : family.series) {
+        if (series.labels == labels) return series;
+    }
+    family.series.push_back({labels, 0.0, std::vector<uint64_t>(family.bounds.size() + 1, 0), 0, 0.0});
+    return family.series.back();
+}
+
+void MetricsRegistry::increment(MetricId id, const MetricLabels& labels, double amount)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    seriesFor(id, labels).value += amount;
+}
+
+void MetricsRegistry::set(MetricId id, const MetricLabels& labels, double value)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    seriesFor(id, labels).value = value;
+}
+
+void MetricsRegistry::observe(MetricId id, const MetricLabels& labels, double value)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::vector<double>& bounds = families[id].bounds;
+    Series& series = seriesFor(id, labels);
+    size_t bucket = std::lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin();
+    series.buckets[bucket]++;
+    series.count++;
+    series.sum += value;
+}
+
+std::string MetricsRegistry::render() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string text;
+    for (const Family& family : families) {
+        text += "# TYPE " + family.name + " " + typeName(family.type) + "\n";
+        if (!family.unit.empty()) {
+            text += "# UNIT " + family.name + " " + family.unit + "\n";
+        }
+        text += "# HELP " + family.name + " " + family.help + "\n";
+
+        for (const Series& series : family.series) {
+            if (family.type == MetricType::COUNTER) {
+                text += family.name + "_total" + labelSet(series.labels) + " " + formatNumber(series.value) + "\n";
+            } else if (family.type == MetricType::GAUGE) {
+                text += family.name + labelSet(series.labels) + " " + formatNumber(series.value) + "\n";
+            } else {
+                // Buckets are exported cumulatively, the last one being +Inf
+                uint64_t cumulative = 0;
+                for (size_t b = 0; b < series.buckets.size(); b++) {
+                    cumulative += series.buckets[b];
+                    std::string bound = b < family.bounds.size() ? formatNumber(family.bounds[b]) : "+Inf";
+                    text += family.name + "_bucket" + labelSet(series.labels, "le", bound) + " " +
+                            std::to_string(cumulative) + "\n";
+                }
+                text += family.name + "_count" + labelSet(series.labels) + " " + std::to_string(series.count) + "\n";
+                text += family.name + "_sum" + labelSet(series.labels) + " " + formatNumber(series.sum) + "\n";
+            }
+        }
+    }
+    return text + "# EOF\n";
+}
+
+SolveMetrics::SolveMetrics()
+{
+    // 1 ms to 1 minute; larger boards run into the tail
+    std::vector<double> bounds = {0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60};
+
+    puzzles = registry.addCounter("queens_puzzles", "Puzzles finished, by result.");
+    probes = registry.addCounter("queens_probes", "Cells revealed by probing.");
+    inferences = registry.addCounter("queens_inferences", "Cells revealed by inference.");
+    backtracks = registry.addCounter("queens_backtracks", "Queen placements taken back.");
+    if (InstrumentationCounters::enabled) {
+        nodes = registry.addCounter("queens_search_nodes", "Search nodes visited.");
+    }
+    solveSeconds = registry.addHistogram("queens_solve_duration_seconds", "Wall time of one solve.",
+                                         "seconds", bounds);
+    phaseSeconds = registry.addHistogram("queens_phase_duration_seconds", "Time of one solve spent per phase.",
+                                         "seconds", bounds);
+    queued = registry.addGauge("queens_solves_queued", "Solves not started yet.");
+    inFlight = registry.addGauge("queens_solves_in_flight", "Solves started and not finished.");
+    lastSolve = registry.addGauge("queens_last_solve_timestamp_seconds",
+                                  "When the most recent solve finished, Unix time.", "seconds");
+}
+
+void SolveMetrics::record(const PuzzleStatistics& stats, const ResultContext& context)
+{
+    MetricLabels labels = {{"masking", formatNumber(context.maskingPercent)},
+                           {"budget", formatNumber(context.probeBudgetPercent)},
+                           {"strategy", context.strategy}};
+
+    MetricLabels outcome = labels;
+    outcome.push_back({"result", stats.solved ? "solved" : "failed"});
+    registry.increment(puzzles, outcome);
+    registry.increment(probes, labels, stats.probesUsed);
+    registry.increment(inferences, labels, stats.inferences);
+    registry.increment(backtracks, labels, stats.backtracks);
+    if (InstrumentationCounters::enabled) {
+        registry.increment(nodes, labels, stats.instrumentation.totalNodes());
+    }
+
+    registry.observe(solveSeconds, labels, stats.solveMillis / 1000.0);
+    std::pair<const char*, double> phases[] = {{"inference", stats.inferenceMillis},
+                                               {"probe_selection", stats.probeSelectionMillis},
+                                               {"probe_wait", stats.probeWaitMillis},
+                                               {"search", stats.searchMillis}};
+    for (const auto& [phase, millis] : phases) {
+        MetricLabels phaseLabels = labels;
+        phaseLabels.push_back({"phase", phase});
+        registry.observe(phaseSeconds, phaseLabels, millis / 1000.0);
+    }
+    registry.set(lastSolve, {}, nowSeconds());
+}
+
+void SolveMetrics::setQueueDepth(int waiting, int running)
+{
+    registry.set(queued, {}, waiting);
+    registry.set(inFlight, {}, running);
+}
+
+const MetricsRegistry& SolveMetrics::getRegistry() const
+{
+    return registry;
+}
+
+MetricsTextfile::MetricsTextfile(const MetricsRegistry& registry, const std::string& path, double intervalSeconds)
+    : registry(registry), path(path), interval((long long)(intervalSeconds * 1000))
+{
+    writeNow();
+    writer = std::thread([this]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!wake.wait_for(lock, interval, [this]() { return stopping; })) {
+            lock.unlock();
+            writeNow();
+            lock.lock();
+        }
+    });
+}
+
+MetricsTextfile::~MetricsTextfile()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    writer.join();
+    writeNow();
+}
+
+bool MetricsTextfile::writeNow()
+{
+    std::string text = registry.render();
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        if (!out.is_open() || !(out << text)) {
+            std::cerr << "Error: Could not write metrics to " << temporary << "\n";
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::cerr << "Error: Could not replace " << path << "\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,147 @@
+#include "../include/PerfCounters.h"
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+void PerfCounts::add(const PerfCounts& other)
+{
+    for (int i = 0; i < eventCount; i++) {
+        values[i] += other.values[i];
+    }
+    availableMask |= other.availableMask;
+}
+
+PerfCounts PerfCounts::operator-(const PerfCounts& earlier) const
+{
+    PerfCounts delta;
+    delta.availableMask = availableMask & earlier.availableMask;
+    for (int i = 0; i < eventCount; i++) {
+        delta.values[i] = values[i] - earlier.values[i];
+    }
+    return delta;
+}
+
+const char* PerfCounts::eventName(PerfEvent event)
+{
+    switch (event) {
+        case PerfEvent::CYCLES:        return "cycles";
+        case PerfEvent::INSTRUCTIONS:  return "instructions";
+        case PerfEvent::L1D_MISSES:    return "l1d_misses";
+        case PerfEvent::LLC_MISSES:    return "llc_misses";
+        case PerfEvent::BRANCH_MISSES: return "branch_misses";
+        default:                       return "unknown";
+    }
+}
+
+#ifdef __linux__
+
+namespace {
+    int openEvent(PerfEvent event)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        switch (event) {
+            case PerfEvent::CYCLES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case PerfEvent::INSTRUCTIONS:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case PerfEvent::L1D_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            case PerfEvent::LLC_MISSES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CACHE_MISSES;
+                break;
+            case PerfEvent::BRANCH_MISSES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            default:
+                return -1;
+        }
+
+        // This thread, any CPU, no group leader
+        return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+}
+
+PerfCounterGroup::PerfCounterGroup()
+{
+    for (int i = 0; i < PerfCounts::eventCount; i++) {
+        fds[i] = openEvent(static_cast<PerfEvent>(i));
+        if (fds[i] < 0 && failure.empty()) {
+            failure = std::string(PerfCounts::eventName(static_cast<PerfEvent>(i))) + ": " + std::strerror(errno);
+        }
+    }
+}
+
+PerfCounterGroup::~PerfCounterGroup()
+{
+    for (int fd : fds) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+PerfCounts PerfCounterGroup::read() const
+{
+    PerfCounts counts;
+    for (int i = 0; i < PerfCounts::eventCount; i++) {
+        if (fds[i] < 0) continue;
+
+        // value, time enabled, time running
+        unsigned long long data[3];
+        if (::read(fds[i], data, sizeof(data)) != sizeof(data)) continue;
+
+        double scale = data[2] > 0 && data[2] < data[1] ? (double)data[1] / data[2] : 1.0;
+        counts.values[i] = (long long)(data[0] * scale);
+        counts.availableMask |= 1u << i;
+    }
+    return counts;
+}
+
+#else
+
+PerfCounterGroup::PerfCounterGroup() : failure("perf_event_open is Linux only")
+{
+    for (int i = 0; i < PerfCounts::eventCount; i++) {
+        fds[i] = -1;
+    }
+}
+
+PerfCounterGroup::~PerfCounterGroup() {}
+
+PerfCounts PerfCounterGroup::read() const
+{
+    return PerfCounts();
+}
+
+#endif
+
+bool PerfCounterGroup::available() const
+{
+    for (int fd : fds) {
+        if (fd >= 0) return true;
+    }
+    return false;
+}
+
+const std::string& PerfCounterGroup::unavailableReason() const
+{
+    return failure;
+}
@@ -0,0 +1,146 @@
+#include "../include/ProbeBudgetPool.h"
+#include "../include/SolveScheduler.h"
+#include <algorithm>
+
+ProbeBudgetPool::ProbeBudgetPool(double reserveFraction)
+    : reserveFraction(std::clamp(reserveFraction, 0.0, 1.0)) {}
+
+void ProbeBudgetPool::expect(int fairShare)
+{
+    expectedShares += fairShare;
+}
+
+// The reserve at enrolment is what earlier puzzles left; a sequential member may take its
+// own contribution plus its share of that, against the puzzles still expected
+int ProbeBudgetPool::enrol(int fairShare)
+{
+    expectedShares = std::max(0, expectedShares - fairShare);
+
+    Member member;
+    member.share = fairShare;
+    member.base = static_cast<int>(fairShare * (1.0 - reserveFraction));
+    member.allowance = fairShare - member.base;
+    if (fairShare > 0) {
+        member.allowance += static_cast<int>((long long)reserve * fairShare / (fairShare + expectedShares));
+    }
+    member.active = true;
+    members.push_back(member);
+
+    reserve += fairShare - member.base;
+    totalShares += fairShare;
+    activeMembers++;
+    return members.size() - 1;
+}
+
+int ProbeBudgetPool::baseAllocation(int member) const
+{
+    return members[member].base;
+}
+
+void ProbeBudgetPool::release(int member, int unused)
+{
+    if (!members[member].active) return;
+
+    members[member].active = false;
+    activeMembers--;
+    reserve += unused;
+    totalReturned += unused;
+}
+
+bool ProbeBudgetPool::tryGrant(int member)
+{
+    if (reserve == 0 || members[member].granted >= members[member].allowance) {
+        return false;
+    }
+    reserve--;
+    members[member].granted++;
+    totalGranted++;
+    return true;
+}
+
+ProbeBudgetPool::GrantWait ProbeBudgetPool::request(int member, double value, SolveScheduler& scheduler)
+{
+    if (attachedScheduler != &scheduler) {
+        attachedScheduler = &scheduler;
+        scheduler.addIdleHandler([this]() { return arbitrate(); });
+    }
+    return GrantWait(*this, scheduler, member, value);
+}
+
+void ProbeBudgetPool::GrantWait::await_suspend(std::coroutine_handle<> solve)
+{
+    pool.pending.push_back({this, solve});
+}
+
+// Grants show diminishing returns, so a puzzle that already drew heavily yields to others
+double ProbeBudgetPool::priority(const PendingGrant& grant) const
+{
+    return grant.request->value / (1 + members[grant.request->member].granted);
+}
+
+void ProbeBudgetPool::resume(size_t index, int granted)
+{
+    PendingGrant grant = pending[index];
+    pending.erase(pending.begin() + index);
+
+    grant.request->granted = granted;
+    grant.request->scheduler.schedule(grant.solve);
+}
+
+// Called whenever the scheduler runs out of ready solves. The most valuable request gets
+// the next reserve probe; with the reserve empty, requests wait for running puzzles to
+// return leftovers and are only denied once every active puzzle is waiting here.
+bool ProbeBudgetPool::arbitrate()
+{
+    if (pending.empty()) return false;
+
+    if (reserve > 0) {
+        size_t best = 0;
+        for (size_t i = 1; i < pending.size(); i++) {
+            if (priority(pending[i]) > priority(pending[best])) best = i;
+        }
+
+        members[pending[best].request->member].granted++;
+        reserve--;
+        totalGranted++;
+        resume(best, 1);
+        return true;
+    }
+
+    if ((int)pending.size() < activeMembers) return false;
+
+    while (!pending.empty()) {
+        resume(0, 0);
+    }
+    return true;
+}
+
+void ProbeBudgetPool::countDenial()
+{
+    totalDenied++;
+}
+
+int ProbeBudgetPool::shares() const
+{
+    return totalShares;
+}
+
+int ProbeBudgetPool::reserveRemaining() const
+{
+    return reserve;
+}
+
+int ProbeBudgetPool::grantedCount() const
+{
+    return totalGranted;
+}
+
+int ProbeBudgetPool::returnedCount() const
+{
+    return totalReturned;
+}
+
+int ProbeBudgetPool::deniedCount() const
+{
+    return totalDenied;
+}
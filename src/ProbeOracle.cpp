@@ -0,0 +1,100 @@
+#include "../include/ProbeOracle.h"
+
+DelayedDelivery::~DelayedDelivery()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    if (deliveryThread.joinable()) {
+        deliveryThread.join();
+    }
+}
+
+void DelayedDelivery::schedule(std::chrono::steady_clock::time_point deadline,
+                               std::promise<std::vector<int>> promise, std::vector<int> colours,
+                               std::function<void()> onDelivered)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!deliveryThread.joinable()) {
+        deliveryThread = std::thread(&DelayedDelivery::deliverLoop, this);
+    }
+    pending.emplace(deadline, PendingRequest{std::move(promise), std::move(colours), std::move(onDelivered)});
+    wakeUp.notify_one();
+}
+
+void DelayedDelivery::deliverLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        if (pending.empty()) {
+            if (stopping) return;
+            wakeUp.wait(lock);
+            continue;
+        }
+
+        // On shutdown anything still in flight is delivered straight away
+        auto next = pending.begin();
+        if (!stopping && std::chrono::steady_clock::now() < next->first) {
+            wakeUp.wait_until(lock, next->first);
+            continue;
+        }
+
+        next->second.promise.set_value(std::move(next->second.colours));
+        std::function<void()> onDelivered = std::move(next->second.onDelivered);
+        pending.erase(next);
+
+        if (onDelivered) {
+            lock.unlock();
+            onDelivered();
+            lock.lock();
+        }
+    }
+}
+
+SimulatedProbeOracle::SimulatedProbeOracle(const std::vector<std::vector<int>>& original,
+                                           std::chrono::microseconds latency,
+                                           DelayedDelivery* sharedDelivery)
+    : grid(original), latency(latency), delivery(sharedDelivery ? sharedDelivery : &ownDelivery) {}
+
+std::future<std::vector<int>> SimulatedProbeOracle::probeBatch(const std::vector<std::pair<int, int>>& cells)
+{
+    std::vector<int> colours;
+    for (auto [row, col] : cells) {
+        colours.push_back(grid[row][col]);
+    }
+
+    std::promise<std::vector<int>> promise;
+    std::future<std::vector<int>> result = promise.get_future();
+    requests++;
+    cellsProbed += cells.size();
+
+    if (latency.count() == 0) {
+        promise.set_value(std::move(colours));
+    } else {
+        delivery->schedule(std::chrono::steady_clock::now() + latency, std::move(promise), std::move(colours),
+                           completionListener);
+    }
+    return result;
+}
+
+bool SimulatedProbeOracle::answersImmediately() const
+{
+    return latency.count() == 0;
+}
+
+void SimulatedProbeOracle::setLatency(std::chrono::microseconds newLatency)
+{
+    latency = newLatency;
+}
+
+int SimulatedProbeOracle::requestCount() const
+{
+    return requests;
+}
+
+int SimulatedProbeOracle::cellCount() const
+{
+    return cellsProbed;
+}
@@ -0,0 +1,147 @@
+#include "../include/ProbeQueue.h"
+#include <queue>
+#include <utility>
+
+void ProbeQueue::reset(int cellCount)
+{
+    heap.clear();
+    slotOf.assign(cellCount, -1);
+    scores.assign(cellCount, 0.0);
+    stale.assign(cellCount, 1);
+    staleMembers.clear();
+}
+
+int ProbeQueue::size() const
+{
+    return heap.size();
+}
+
+bool ProbeQueue::contains(int cell) const
+{
+    return slotOf[cell] != -1;
+}
+
+bool ProbeQueue::isStale(int cell) const
+{
+    return stale[cell];
+}
+
+double ProbeQueue::scoreOf(int cell) const
+{
+    return scores[cell];
+}
+
+// Higher score first, ties broken towards the lower cell index (row-major order)
+bool ProbeQueue::ranksAbove(int cellA, int cellB) const
+{
+    if (scores[cellA] != scores[cellB]) {
+        return scores[cellA] > scores[cellB];
+    }
+    return cellA < cellB;
+}
+
+void ProbeQueue::swapSlots(int a, int b)
+{
+    std::swap(heap[a], heap[b]);
+    slotOf[heap[a]] = a;
+    slotOf[heap[b]] = b;
+}
+
+void ProbeQueue::siftUp(int slot)
+{
+    while (slot > 0) {
+        int parent = (slot - 1) / 2;
+        if (!ranksAbove(heap[slot], heap[parent])) break;
+        swapSlots(slot, parent);
+        slot = parent;
+    }
+}
+
+void ProbeQueue::siftDown(int slot)
+{
+    int count = heap.size();
+    while (true) {
+        int best = slot;
+        int left = 2 * slot + 1;
+        int right = left + 1;
+        if (left < count && ranksAbove(heap[left], heap[best])) best = left;
+        if (right < count && ranksAbove(heap[right], heap[best])) best = right;
+        if (best == slot) break;
+        swapSlots(slot, best);
+        slot = best;
+    }
+}
+
+void ProbeQueue::insert(int cell, double score)
+{
+    scores[cell] = score;
+    stale[cell] = 0;
+    slotOf[cell] = heap.size();
+    heap.push_back(cell);
+    siftUp(slotOf[cell]);
+}
+
+void ProbeQueue::erase(int cell)
+{
+    int slot = slotOf[cell];
+    int last = heap.size() - 1;
+    if (slot != last) {
+        swapSlots(slot, last);
+    }
+    heap.pop_back();
+    slotOf[cell] = -1;
+
+    if (slot < (int)heap.size()) {
+        int moved = heap[slot];
+        siftUp(slot);
+        siftDown(slotOf[moved]);
+    }
+}
+
+void ProbeQueue::update(int cell, double score)
+{
+    scores[cell] = score;
+    stale[cell] = 0;
+    int slot = slotOf[cell];
+    siftUp(slot);
+    siftDown(slotOf[cell]);
+}
+
+void ProbeQueue::invalidate(int cell)
+{
+    if (stale[cell]) return;
+    stale[cell] = 1;
+    if (contains(cell)) {
+        staleMembers.push_back(cell);
+    }
+}
+
+void ProbeQueue::invalidateAll()
+{
+    for (int cell = 0; cell < (int)stale.size(); cell++) {
+        invalidate(cell);
+    }
+}
+
+std::vector<int> ProbeQueue::top(int k) const
+{
+    std::vector<int> result;
+    if (heap.empty() || k <= 0) return result;
+
+    // Frontier of heap slots; the next best cell is always a child of one already taken
+    auto worse = [this](int a, int b) { return ranksAbove(heap[b], heap[a]); };
+    std::priority_queue<int, std::vector<int>, decltype(worse)> frontier(worse);
+    frontier.push(0);
+
+    int count = heap.size();
+    while (!frontier.empty() && (int)result.size() < k) {
+        int slot = frontier.top();
+        frontier.pop();
+        result.push_back(heap[slot]);
+
+        int left = 2 * slot + 1;
+        if (left < count) frontier.push(left);
+        if (left + 1 < count) frontier.push(left + 1);
+    }
+    return result;
+}
@@ -3,57 +3,58 @@
 #include <iostream>
 
 void PuzzleManager::loadFromFile(const std::string& filename, int numPuzzles, std::vector<Graph> &graphs) {
-    // std::vector<Graph> graphs;
+    loadFromFile(filename, numPuzzles, graphs, 0.3);
+}
+
+void PuzzleManager::loadFromFile(const std::string& filename, int numPuzzles, std::vector<Graph> &graphs, double maskingPercentage) {
+    maskCorpus(loadCorpus(filename, numPuzzles), graphs, maskingPercentage);
+}
+
+std::vector<std::shared_ptr<const PuzzleGrid>> PuzzleManager::loadCorpus(const std::string& filename, int numPuzzles) {
+    AllocationTracker::Scope loading(AllocPhase::LOADING, AllocComponent::MANAGER);
+    std::vector<std::shared_ptr<const PuzzleGrid>> corpus;
     std::ifstream puzzleFile(filename);
 
     if (!puzzleFile.is_open()) {
         std::cerr << "Unable to open file: " << filename << std::endl;
-        // return graphs;
+        return corpus;
     }
 
     for (int i = 0; i < numPuzzles; i++) {
         int graphSize;
-        puzzleFile >> graphSize;
+        if (!(puzzleFile >> graphSize)) {
+            break;
+        }
 
         // Create 2d Matrix to hold txt data - resize to graphSize x graphSize
-        std::vector<std::vector<int>> puzzleData(graphSize, std::vector<int>(graphSize));
+        auto puzzleData = std::make_shared<PuzzleGrid>(graphSize, std::vector<int>(graphSize));
 
         for (int row = 0; row < graphSize; row++) {
             for (int col = 0; col < graphSize; col++) {
-                puzzleFile >> puzzleData[row][col];
+                puzzleFile >> (*puzzleData)[row][col];
             }
         }
-        Graph newGraph(puzzleData);
-        graphs.push_back(newGraph);
+        corpus.push_back(std::move(puzzleData));
     }
     puzzleFile.close();
-    // return graphs;
+    return corpus;
 }
 
-void PuzzleManager::loadFromFile(const std::string& filename, int numPuzzles, std::vector<Graph> &graphs, double maskingPercentage) {
-    // std::vector<Graph> graphs;
-    std::ifstream puzzleFile(filename);
-
-    if (!puzzleFile.is_open()) {
-        std::cerr << "Unable to open file: " << filename << std::endl;
-        // return graphs;
+void PuzzleManager::maskCorpus(const std::vector<std::shared_ptr<const PuzzleGrid>>& corpus, std::vector<Graph>& graphs,
+                               double maskingPercentage) {
+    AllocationTracker::Scope masking(AllocPhase::MASKING, AllocComponent::MANAGER);
+    graphs.reserve(graphs.size() + corpus.size());
+    for (const auto& puzzleData : corpus) {
+        graphs.emplace_back(puzzleData, maskingPercentage);
     }
+}
 
-    for (int i = 0; i < numPuzzles; i++) {
-        int graphSize;
-        puzzleFile >> graphSize;
-
-        // Create 2d Matrix to hold txt data - resize to graphSize x graphSize
-        std::vector<std::vector<int>> puzzleData(graphSize, std::vector<int>(graphSize));
-
-        for (int row = 0; row < graphSize; row++) {
-            for (int col = 0; col < graphSize; col++) {
-                puzzleFile >> puzzleData[row][col];
-            }
-        }
-        Graph newGraph(puzzleData, maskingPercentage);
-        graphs.push_back(newGraph);
+// Puzzle i is masked with seed + i, so a seed reproduces the whole batch
+void PuzzleManager::maskCorpus(const std::vector<std::shared_ptr<const PuzzleGrid>>& corpus, std::vector<Graph>& graphs,
+                               double maskingPercentage, unsigned int seed) {
+    AllocationTracker::Scope masking(AllocPhase::MASKING, AllocComponent::MANAGER);
+    graphs.reserve(graphs.size() + corpus.size());
+    for (size_t i = 0; i < corpus.size(); i++) {
+        graphs.emplace_back(corpus[i], maskingPercentage, seed + i);
     }
-    puzzleFile.close();
-    // return graphs;
-}
\ No newline at end of file
+}
@@ -1,5 +1,6 @@
 #include "../include/PuzzleSolver.h"
 #include "../include/graph.h"
+#include "../include/SolveScheduler.h"
 #include <set>
 #include <map>
 #include <algorithm>
@@ -7,7 +8,31 @@
 
 const int PuzzleSolver::directions[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
 
-PuzzleSolver::PuzzleSolver(Graph &graph) : puzzle(graph) {}
+const PuzzleSolver::StrictRule PuzzleSolver::strictRules[] = {
+    {"neighbours", 25, TRACE_RULE_NEIGHBOURS, InstrumentSite::RULE_NEIGHBOURS, &PuzzleSolver::inferNeighbours},
+    {"uniformity", 250, TRACE_RULE_UNIFORMITY, InstrumentSite::RULE_UNIFORMITY, &PuzzleSolver::inferRowColumnUniformity},
+    {"domains", 2500, TRACE_RULE_DOMAINS, InstrumentSite::RULE_DOMAINS, &PuzzleSolver::inferFromDomains},
+    {"contiguity", 100, TRACE_RULE_CONTIGUITY, InstrumentSite::RULE_CONTIGUITY, &PuzzleSolver::inferFromContiguity},
+    {"pattern", 7, TRACE_RULE_PATTERN, InstrumentSite::RULE_PATTERN, &PuzzleSolver::inferPatternCompletion},
+};
+
+PuzzleSolver::PuzzleSolver(Graph &graph)
+    : puzzle(graph), localOracle(new SimulatedProbeOracle(graph.getOriginal())), oracle(localOracle.get())
+{
+    for (int i = 0; i < strictRuleCount; i++) {
+        const StrictRule& rule = strictRules[i];
+        strictInference.addRule(rule.name, parameters.strictWeights[i], rule.cost, rule.traceRule);
+    }
+    strictInference.setThreshold(parameters.strictThreshold);
+
+    pristineMasked = graph.getMasked();
+    for (int row = 0; row < graph.getSize(); row++) {
+        pristineQueens.push_back(graph.queenColumn(row));
+    }
+
+    // Cells can be revealed before the first solve, as observeCell does
+    resetProbeQueue(graph.getSize());
+}
 
 int PuzzleSolver::inferNeighbours(int row, int col)
 {
@@ -40,52 +65,21 @@ int PuzzleSolver::inferNeighbours(int row, int col)
     return -1;
 }
 
+// Stops once the rules left cannot change the answer; with a trace attached every rule
+// runs, so the recorded rules are all those that agreed
 int PuzzleSolver::inferStrict(int row, int col)
 {
-    std::map<int, float> colourConfidence;
+    uint8_t agreeing = 0;
+    int bestColour = strictInference.infer(row, col, trace != nullptr, agreeing, [this](int rule, int r, int c) {
+        int colour = (this->*strictRules[rule].apply)(r, c);
+        QUEENS_RESULT(instrumentation, strictRules[rule].site, colour != -1);
+        return colour;
+    });
 
-    int neighbourInfer = inferNeighbours(row, col);
-    if (neighbourInfer != -1)
-    {
-        colourConfidence[neighbourInfer] += 3.0;
-    }
-
-    int uniformInfer = inferRowColumnUniformity(row, col);
-    if (uniformInfer != -1)
-    {
-        colourConfidence[uniformInfer] += 2.5;
+    QUEENS_RESULT(instrumentation, InstrumentSite::INFER_STRICT, bestColour != -1);
+    if (trace && bestColour != -1) {
+        lastInferenceRules = agreeing;
     }
-
-    int domainInfer = inferFromDomains(row, col);
-    if (domainInfer != -1)
-    {
-        colourConfidence[domainInfer] += 2.0;
-    }
-
-    int contigInfer = inferFromContiguity(row, col);
-    if (contigInfer != -1)
-    {
-        colourConfidence[contigInfer] += 2.0;
-    }
-
-    int patternInfer = inferPatternCompletion(row, col);
-    if (patternInfer != -1)
-    {
-        colourConfidence[patternInfer] += 1.5;
-    }
-
-    int bestColour = -1;
-    float maxConfidence = 4.5;
-
-    for (auto &[color, confidence] : colourConfidence)
-    {
-        if (confidence > maxConfidence)
-        {
-            maxConfidence = confidence;
-            bestColour = color;
-        }
-    }
-
     return bestColour;
 }
 
@@ -269,12 +263,12 @@ double PuzzleSolver::calculateProbeValue(int row, int col, int n)
     double value = 0.0;
 
     int unknownNeighbours = countUnknownNeighbours(row, col, n);
-    value += unknownNeighbours * 2.0;
+    value += unknownNeighbours * parameters.unknownNeighbourValue;
 
     if ((row == 0 || row == n-1) && (col == 0 || col == n-1))
-        value += 1.5;
+        value += parameters.cornerBonus;
     else if (row == 0 || row == n-1 || col == 0 || col == n-1)
-        value += 1.0;
+        value += parameters.edgeBonus;
 
     std::set<int> neighbourColours;
     for (int i = 0; i < 4; i++)
@@ -292,25 +286,26 @@ double PuzzleSolver::calculateProbeValue(int row, int col, int n)
         }
     }
     if (neighbourColours.size() >= 2)
-        value += neighbourColours.size() * 1.5;
+        value += neighbourColours.size() * parameters.boundaryColourValue;
 
     bool rowHasQueen = false;
     for (int c = 0; c < n; c++)
     {
-        if (puzzle.getCurrentState()[row][c] == 0)
+        if (puzzle.hasQueen(row, c))
         {
             rowHasQueen = true;
             break;
         }
     }
     if (!rowHasQueen)
-        value += 2.0;
+        value += parameters.openRowBonus;
 
     return value;
 }
 
 void PuzzleSolver::performInferenceCascade(int n)
 {
+    QUEENS_TIME(instrumentation, InstrumentSite::INFERENCE_CASCADE);
     bool madeProgress = true;
     int maxPasses = 2;
     int passes = 0;
@@ -329,8 +324,7 @@ void PuzzleSolver::performInferenceCascade(int n)
                     int inferredColour = inferStrict(row, col);
                     if (inferredColour != -1)
                     {
-                        puzzle.getMasked()[row][col] = inferredColour;
-                        inferredCount++;
+                        applyInference(row, col, inferredColour);
                         madeProgress = true;
                     }
                 }
@@ -346,7 +340,7 @@ bool PuzzleSolver::hasQueenInColour(int color)
     {
         for (int col = 0; col < n; col++)
         {
-            if (puzzle.getCurrentState()[row][col] == 0)
+            if (puzzle.hasQueen(row, col))
             {
                 int queenColour = puzzle.getMasked()[row][col];
                 if (queenColour == color)
@@ -361,14 +355,28 @@ bool PuzzleSolver::hasQueenInColour(int color)
 
 bool PuzzleSolver::validateFinalSolution(std::vector<std::pair<int, int>>& queenPositions)
 {
-    int n = puzzle.getOriginal().size();
+    if (!settleSpeculation(true)) {
+        return false;
+    }
+
+    probeBatch(unknownQueenCells(queenPositions));
+
+    return queensHaveDistinctColours(queenPositions);
+}
 
+std::vector<std::pair<int, int>> PuzzleSolver::unknownQueenCells(const std::vector<std::pair<int, int>>& queenPositions)
+{
+    std::vector<std::pair<int, int>> unknownQueens;
     for (auto [row, col] : queenPositions) {
         if (puzzle.getMasked()[row][col] == -1) {
-            probe(row, col);
+            unknownQueens.push_back({row, col});
         }
     }
+    return unknownQueens;
+}
 
+bool PuzzleSolver::queensHaveDistinctColours(const std::vector<std::pair<int, int>>& queenPositions)
+{
     for (size_t i = 0; i < queenPositions.size(); i++) {
         int r1 = queenPositions[i].first;
         int c1 = queenPositions[i].second;
@@ -391,12 +399,198 @@ bool PuzzleSolver::validateFinalSolution(std::vector<std::pair<int, int>>& queen
 void PuzzleSolver::probe(int row, int col)
 {
     probeCount++;
-    int colour = puzzle.getOriginal()[row][col];
+    int colour = oracle->probe(row, col);
+    revealCell(row, col, colour);
+    traceEvent(TraceEventKind::PROBE, row, col, colour);
+}
+
+// All cells go out as a single oracle request
+void PuzzleSolver::probeBatch(const std::vector<std::pair<int, int>>& cells)
+{
+    if (cells.empty()) return;
+
+    probeCount += cells.size();
+    std::vector<int> colours;
+    {
+        PhaseScope waiting(*this, SolvePhase::PROBE_WAIT);
+        colours = oracle->probeBatch(cells).get();
+    }
+    for (size_t i = 0; i < cells.size(); i++) {
+        revealCell(cells[i].first, cells[i].second, colours[i]);
+        traceEvent(TraceEventKind::PROBE, cells[i].first, cells[i].second, colours[i]);
+    }
+}
+
+void PuzzleSolver::setProbeOracle(ProbeOracle* probeOracle)
+{
+    oracle = probeOracle ? probeOracle : localOracle.get();
+}
+
+void PuzzleSolver::setProbeLatency(std::chrono::microseconds latency)
+{
+    localOracle->setLatency(latency);
+}
+
+// Colour learned outside the solver; counts as neither a probe nor an inference
+void PuzzleSolver::observeCell(int row, int col, int colour)
+{
+    revealCell(row, col, colour);
+    traceEvent(TraceEventKind::PROBE, row, col, colour, TRACE_PROBE_EXTERNAL);
+    propagateConstraints(puzzle.getSize());
+}
+
+void PuzzleSolver::writeCell(int row, int col, int colour)
+{
+    hashCell(row, col, puzzle.getMasked()[row][col], colour);
+    recordTrail({true, row, col, puzzle.getMasked()[row][col]});
     puzzle.getMasked()[row][col] = colour;
 }
 
+// A queen entry remembers the row's previous queen column (-1 for none)
+void PuzzleSolver::writeQueen(int row, int col)
+{
+    recordTrail({false, row, col, puzzle.queenColumn(row)});
+    if (col == -1) {
+        puzzle.clearQueen(row);
+    } else {
+        puzzle.setQueen(row, col);
+    }
+}
+
+void PuzzleSolver::recordTrail(const TrailEntry& entry)
+{
+    if (trailHeld()) {
+        trail.push_back(entry);
+    } else if (!trail.empty()) {
+        trail.clear();
+    }
+}
+
+void PuzzleSolver::rollbackTrail(size_t mark)
+{
+    while (trail.size() > mark) {
+        const TrailEntry& entry = trail.back();
+        traceEvent(TraceEventKind::REVERT, entry.row, entry.col, entry.previous, entry.masked ? 0 : TRACE_REVERT_QUEEN);
+        if (entry.masked) {
+            hashCell(entry.row, entry.col, puzzle.getMasked()[entry.row][entry.col], entry.previous);
+            puzzle.getMasked()[entry.row][entry.col] = entry.previous;
+        } else if (entry.previous == -1) {
+            puzzle.clearQueen(entry.row);
+        } else {
+            puzzle.setQueen(entry.row, entry.previous);
+        }
+        trail.pop_back();
+    }
+}
+
+void PuzzleSolver::hashCell(int row, int col, int from, int to)
+{
+    int cell = row * puzzle.getSize() + col;
+    colourHash ^= TranspositionTable::colourKey(cell, from) ^ TranspositionTable::colourKey(cell, to);
+}
+
+uint64_t PuzzleSolver::computeColourHash()
+{
+    int n = puzzle.getSize();
+    uint64_t hash = 0;
+    for (int row = 0; row < n; row++) {
+        for (int col = 0; col < n; col++) {
+            hash ^= TranspositionTable::colourKey(row * n + col, puzzle.getMasked()[row][col]);
+        }
+    }
+    return hash;
+}
+
+// What the search below a node reads of the queens above it: the columns and colours they
+// hold and the column next to the node's row. Which rows those came from does not matter,
+// so different placements leading to the same constraints share a key. A queen on a cell
+// of unknown colour counts by position, since its colour is still to be found out.
+uint64_t PuzzleSolver::transpositionKey(const std::vector<std::pair<int, int>>& queenPositions)
+{
+    int n = puzzle.getSize();
+    uint64_t key = colourHash ^ TranspositionTable::budgetKey(probeBudget - probesSpent());
+    for (auto [row, col] : queenPositions) {
+        int colour = puzzle.getMasked()[row][col];
+        if (colour == -1) {
+            key ^= TranspositionTable::queenKey(row * n + col);
+        } else {
+            key ^= TranspositionTable::columnKey(col) ^ TranspositionTable::takenColourKey(colour);
+        }
+    }
+    if (!queenPositions.empty()) {
+        key ^= TranspositionTable::lastColumnKey(queenPositions.back().second);
+    }
+    return key;
+}
+
+// A node that ran out of time or was unwound by a misprediction has not been searched out.
+// Stores made while a speculative probe is pending are journaled for confirmSpeculation
+void PuzzleSolver::rememberFailure(uint64_t key, uint32_t nodesAtEntry)
+{
+    if (!transpositionsActive || deadlineHit || rollbackToken != 0) return;
+    transpositions.setJournaling(!pendingProbes.empty());
+    transpositions.recordFailure(key, searchNodes - nodesAtEntry);
+}
+
+void PuzzleSolver::revealCell(int row, int col, int colour)
+{
+    writeCell(row, col, colour);
+    maskedVersion++;
+    invalidateProbeScoresAround(row, col);
+}
+
+// A colour found by inferStrict; lastInferenceRules still holds the rules behind it
+void PuzzleSolver::applyInference(int row, int col, int colour)
+{
+    revealCell(row, col, colour);
+    inferredCount++;
+    traceEvent(TraceEventKind::INFER, row, col, colour, lastInferenceRules);
+}
+
+// Dead end: nothing in this row can take a queen
+void PuzzleSolver::pruneRow(int row)
+{
+    traceEvent(TraceEventKind::PRUNE, row, -1, -1, TRACE_PRUNE_EMPTY_ROW);
+}
+
+void PuzzleSolver::placeQueen(int row, int col)
+{
+    writeQueen(row, col);
+    invalidateProbeScoresInRow(row);
+}
+
+void PuzzleSolver::resetProbeQueue(int n)
+{
+    probeQueue.reset(n * n);
+    candidateStamp.assign(n * n, 0);
+    queuedCandidates.clear();
+}
+
+// A cell's probe score depends on its four neighbours' colours
+void PuzzleSolver::invalidateProbeScoresAround(int row, int col)
+{
+    int n = puzzle.getSize();
+    for (int i = 0; i < 4; i++) {
+        int nr = row + directions[i][0];
+        int nc = col + directions[i][1];
+        if (nr >= 0 && nr < n && nc >= 0 && nc < n) {
+            probeQueue.invalidate(nr * n + nc);
+        }
+    }
+}
+
+// ...and on whether its row already holds a queen
+void PuzzleSolver::invalidateProbeScoresInRow(int row)
+{
+    int n = puzzle.getSize();
+    for (int col = 0; col < n; col++) {
+        probeQueue.invalidate(row * n + col);
+    }
+}
+
 bool PuzzleSolver::isValid(int row, int col)
 {
+    QUEENS_TIME(instrumentation, InstrumentSite::IS_VALID);
     int n = puzzle.getOriginal().size();
     int currentColour = puzzle.getMasked()[row][col];
 
@@ -407,7 +601,7 @@ bool PuzzleSolver::isValid(int row, int col)
 
     for (int i = 0; i < row; i++)
     {
-        if (puzzle.getCurrentState()[i][col] == 0)
+        if (puzzle.hasQueen(i, col))
         {
             return false;
         }
@@ -415,7 +609,7 @@ bool PuzzleSolver::isValid(int row, int col)
 
     for (int i = 0; i < row; i++) {
         for (int j = 0; j < n; j++) {
-            if (puzzle.getCurrentState()[i][j] == 0) {
+            if (puzzle.hasQueen(i, j)) {
                 if (abs(row - i) == 1 && abs(col - j) == 1) {
                     return false;
                 }
@@ -427,7 +621,7 @@ bool PuzzleSolver::isValid(int row, int col)
     {
         for (int j = 0; j < n; ++j)
         {
-            if (puzzle.getCurrentState()[i][j] == 0)
+            if (puzzle.hasQueen(i, j))
             {
                 int queenColour = puzzle.getMasked()[i][j];
                 if (queenColour != -1 && queenColour == currentColour)
@@ -444,7 +638,7 @@ void PuzzleSolver::printStatistics()
 {
     std::cout << "\n\n[ Solver Statistics ]\n";
 
-    std::cout << "\n--- CSP Backtracking ---" << std::endl;
+    std::cout << "\n--- CSP Backtracking ---\n";
     std::cout << "Final queens placed: " << queensPlaced << '\n';
     std::cout << "Total Queen placement attempts: " << totalQueensPlaced << '\n';
     std::cout << "Backtracks: " << backtrackCount << '\n';
@@ -462,12 +656,12 @@ void PuzzleSolver::printStatistics()
     if (probeBudget > 0) {
         std::cout << "\n--- Probe Budget ---\n";
         std::cout << "Probe budget: " << probeBudget << " ("<< (double)probeBudget/initialUnknownCells*100 << "% of unknowns)" << '\n';
-        std::cout << "Probes used: " << probeCount << " / " << probeBudget;
+        std::cout << "Probes charged: " << probesSpent() << " / " << probeBudget;
         if (budgetExhausted) {
             std::cout << " (BUDGET FULLY USED)";
         }
         std::cout << '\n';
-        std::cout << "Budget remaining: " << (probeBudget - probeCount) << '\n';
+        std::cout << "Budget remaining: " << (probeBudget - probesSpent()) << '\n';
 
 
     }
@@ -475,6 +669,31 @@ void PuzzleSolver::printStatistics()
     double activeSensingRatio = (double)probeCount / (inferredCount + probeCount + 1);
     double inferenceRatio = (double)inferredCount / (inferredCount + probeCount + 1);
 
+    if (speculativeProbes > 0) {
+        std::cout << "\n--- Speculative Probing ---\n";
+        std::cout << "Speculative probe requests: " << speculativeProbes << '\n';
+        std::cout << "Mispredicted (rolled back): " << mispredictedProbes << '\n';
+        std::cout << "Probes discarded by rollbacks: " << wastedProbes << " (charged to the budget)" << '\n';
+    }
+
+    const TranspositionTable::Stats& table = transpositions.getStats();
+    if (table.lookups > 0) {
+        std::cout << "\n--- Transposition Table ---\n";
+        std::cout << "Lookups: " << table.lookups << ", dead ends recognized: " << table.hits << " ("
+                  << 100.0 * table.hits / table.lookups << "%)\n";
+        std::cout << "Dead ends stored: " << table.stores << ", evicted: " << table.evictions << " (capacity "
+                  << transpositions.capacity() << ")\n";
+    }
+
+    std::vector<InferenceRuleStats> rules = strictInference.getStats();
+    if (!rules.empty() && rules[0].calls + rules[0].skipped > 0) {
+        std::cout << "\n--- Inference Rules ---\n";
+        for (const InferenceRuleStats& rule : rules) {
+            std::cout << rule.name << ": " << rule.calls << " runs, " << rule.yields << " named a colour, "
+                      << rule.agreed << " agreed, " << rule.skipped << " skipped, ~" << rule.millis << " ms\n";
+        }
+    }
+
     std::cout << "\n--- Efficiency Metrics ---\n";
     std::cout << "Active Sensing ratio: " << activeSensingRatio << " (probeCount / total sensing)\n";
     std::cout << "Inference ratio: " << inferenceRatio << " (inferred / total sensing)\n";
@@ -483,6 +702,7 @@ void PuzzleSolver::printStatistics()
 
 std::vector<std::pair<int, int>> PuzzleSolver::findViableQueenPositions(int row, int n)
 {
+    QUEENS_TIME(instrumentation, InstrumentSite::FIND_VIABLE);
     std::vector<std::pair<int, int>> viablePositions;
 
     for (int col = 0; col < n; col++) {
@@ -490,7 +710,7 @@ std::vector<std::pair<int, int>> PuzzleSolver::findViableQueenPositions(int row,
 
         // Check if any queen already exists in this column
         for (int r = 0; r < row; r++) {
-            if (puzzle.getCurrentState()[r][col] == 0) {
+            if (puzzle.hasQueen(r, col)) {
                 basicConstraintsOK = false;
                 break;
             }
@@ -500,7 +720,7 @@ std::vector<std::pair<int, int>> PuzzleSolver::findViableQueenPositions(int row,
         if (basicConstraintsOK) {
             for (int r = 0; r < row; r++) {
                 for (int c = 0; c < n; c++) {
-                    if (puzzle.getCurrentState()[r][c] == 0) {
+                    if (puzzle.hasQueen(r, c)) {
                         if (abs(row - r) == 1 && abs(col - c) == 1) {
                             basicConstraintsOK = false;
                             break;
@@ -518,8 +738,7 @@ std::vector<std::pair<int, int>> PuzzleSolver::findViableQueenPositions(int row,
             if (cellColour == -1) {
                 int inferredColour = inferStrict(row, col);
                 if (inferredColour != -1) {
-                    puzzle.getMasked()[row][col] = inferredColour;
-                    inferredCount++;
+                    applyInference(row, col, inferredColour);
                     cellColour = inferredColour;
                 }
             }
@@ -543,9 +762,16 @@ std::vector<std::pair<int, int>> PuzzleSolver::findViableQueenPositions(int row,
 
 void PuzzleSolver::undoQueenPlacement(int row, int col)
 {
-    puzzle.getCurrentState()[row][col] = puzzle.getMasked()[row][col];
-    queensPlaced--;
+    liftQueen(row);
     backtrackCount++;
+    traceEvent(TraceEventKind::UNDO, row, col, -1);
+}
+
+void PuzzleSolver::liftQueen(int row)
+{
+    writeQueen(row, -1);
+    invalidateProbeScoresInRow(row);
+    queensPlaced--;
 }
 
 void PuzzleSolver::restoreBestPartialSolution()
@@ -553,14 +779,15 @@ void PuzzleSolver::restoreBestPartialSolution()
     int n = puzzle.getOriginal().size();
 
     for (int row = 0; row < n; row++) {
-        for (int col = 0; col < n; col++) {
-            puzzle.getCurrentState()[row][col] = puzzle.getMasked()[row][col];
+        if (puzzle.queenColumn(row) != -1) {
+            writeQueen(row, -1);
         }
     }
 
     for (auto [row, col] : bestPartialSolution) {
-        puzzle.getCurrentState()[row][col] = 0;
+        writeQueen(row, col);
     }
+    probeQueue.invalidateAll();
 }
 
 double PuzzleSolver::calculateExpectedInformationGain(int row, int col, int n)
@@ -594,37 +821,83 @@ std::vector<std::pair<int, int>> PuzzleSolver::findBestProbeSpots(
     int k, std::vector<std::pair<int, int>>& viablePositions)
 {
     int n = puzzle.getOriginal().size();
-    std::vector<std::pair<double, std::pair<int, int>>> scoredProbes;
 
-    std::set<std::pair<int, int>> candidates;
+    if ((int)candidateStamp.size() != n * n) {
+        resetProbeQueue(n);
+    }
 
-    for (auto [row, col] : viablePositions) {
+    // Stamp this node's candidates: unknown viable cells and their unknown neighbours
+    candidateGeneration++;
+    auto markCandidate = [&](int row, int col) {
         if (puzzle.getMasked()[row][col] == -1) {
-            candidates.insert({row, col});
+            candidateStamp[row * n + col] = candidateGeneration;
         }
+    };
+
+    for (auto [row, col] : viablePositions) {
+        markCandidate(row, col);
 
         for (int i = 0; i < 4; i++) {
             int nr = row + directions[i][0];
             int nc = col + directions[i][1];
             if (nr >= 0 && nr < n && nc >= 0 && nc < n) {
-                if (puzzle.getMasked()[nr][nc] == -1) {
-                    candidates.insert({nr, nc});
+                markCandidate(nr, nc);
+            }
+        }
+    }
+
+    if (probeStrategy == ProbeStrategy::MONTE_CARLO) {
+        // Only resample once something new has been observed
+        if (beliefVersion != maskedVersion) {
+            beliefEngine.update(puzzle.getMasked());
+            beliefVersion = maskedVersion;
+        }
+
+        if (beliefEngine.acceptedSamples() > 0) {
+            std::vector<std::pair<int, int>> candidates;
+            for (int cell = 0; cell < n * n; cell++) {
+                if (candidateStamp[cell] == candidateGeneration) {
+                    candidates.push_back({cell / n, cell % n});
                 }
             }
+            return beliefEngine.rankProbes(candidates, k);
         }
     }
 
-    for (auto [row, col] : candidates) {
-        double gain = calculateExpectedInformationGain(row, col, n);
-        scoredProbes.push_back({gain, {row, col}});
+    // Drop cells that are no longer candidates, keep the rest with their cached scores
+    std::vector<int> stillQueued;
+    for (int cell : queuedCandidates) {
+        if (candidateStamp[cell] == candidateGeneration) {
+            stillQueued.push_back(cell);
+        } else if (probeQueue.contains(cell)) {
+            probeQueue.erase(cell);
+        }
     }
+    queuedCandidates.swap(stillQueued);
 
-    std::sort(scoredProbes.begin(), scoredProbes.end(),
-              [](const auto& a, const auto& b) { return a.first > b.first; });
+    auto score = [&](int cell) {
+        return calculateExpectedInformationGain(cell / n, cell % n, n);
+    };
+
+    for (auto [row, col] : viablePositions) {
+        for (int i = -1; i < 4; i++) {
+            int nr = i < 0 ? row : row + directions[i][0];
+            int nc = i < 0 ? col : col + directions[i][1];
+            if (nr < 0 || nr >= n || nc < 0 || nc >= n) continue;
+
+            int cell = nr * n + nc;
+            if (candidateStamp[cell] != candidateGeneration || probeQueue.contains(cell)) continue;
+
+            probeQueue.insert(cell, probeQueue.isStale(cell) ? score(cell) : probeQueue.scoreOf(cell));
+            queuedCandidates.push_back(cell);
+        }
+    }
+
+    probeQueue.refresh(score);
 
     std::vector<std::pair<int, int>> result;
-    for (int i = 0; i < std::min(k, (int)scoredProbes.size()); i++) {
-        result.push_back(scoredProbes[i].second);
+    for (int cell : probeQueue.top(k)) {
+        result.push_back({cell / n, cell % n});
     }
 
     return result;
@@ -632,98 +905,545 @@ std::vector<std::pair<int, int>> PuzzleSolver::findBestProbeSpots(
 
 void PuzzleSolver::propagateConstraints(int n)
 {
+    PhaseScope inference(*this, SolvePhase::INFERENCE);
     performInferenceCascade(n);
 }
 
 bool PuzzleSolver::solvePuzzle(int n)
 {
-    setProbeBudget(n, 0.5);
+    return solvePuzzle(n, 0.5);
+}
 
-    bestPartialSolution.clear();
-    maxQueensPlaced = 0;
+bool PuzzleSolver::solvePuzzle(int n, double probeBudgetPercent)
+{
+    prepareSolve(n, probeBudgetPercent, false);
 
     std::vector<std::pair<int, int>> queenPositions;
     bool solved = mainSolver(0, n, queenPositions);
 
-    if (!solved && !bestPartialSolution.empty()) {
-        restoreBestPartialSolution();
+    finishSolve(solved);
+    return solved;
+}
+
+// Same search as solvePuzzle, but every probe suspends the solve on the scheduler instead
+// of blocking the thread
+Task<bool> PuzzleSolver::solvePuzzleAsync(int n, double probeBudgetPercent, SolveScheduler& scheduler)
+{
+    prepareSolve(n, probeBudgetPercent, true);
+    oracle->setCompletionListener([&scheduler] { scheduler.notifyCompletion(); });
+
+    std::vector<std::pair<int, int>> queenPositions;
+    bool solved = co_await mainSolverAsync(0, n, queenPositions, scheduler);
+
+    // Every probe has been awaited, so nothing is left to report to the scheduler
+    oracle->setCompletionListener(nullptr);
+    finishSolve(solved);
+    co_return solved;
+}
+
+bool PuzzleSolver::resumeSolve(int n, double probeBudgetPercent, std::vector<std::pair<int, int>>& queenPositions,
+                               int& keepQueens)
+{
+    auto liftQueensDownTo = [&](int keep) {
+        while ((int)queenPositions.size() > keep) {
+            liftQueen(queenPositions.back().first);
+            queenPositions.pop_back();
+        }
+    };
+
+    liftQueensDownTo(keepQueens);
+    prepareSolve(n, probeBudgetPercent, false, true);
+    maxQueensPlaced = queenPositions.size();
+    bestPartialSolution = queenPositions;
+
+    bool solved = mainSolver(keepQueens, n, queenPositions);
+
+    if (!solved && keepQueens > 0 && !deadlineHit) {
+        liftQueensDownTo(0);
+        keepQueens = 0;
+        maxQueensPlaced = 0;
+        bestPartialSolution.clear();
+        solved = mainSolver(0, n, queenPositions);
     }
 
+    finishSolve(solved);
     return solved;
 }
 
-bool PuzzleSolver::solvePuzzle(int n, double probeBudgetPercent)
+// A resumed solve keeps the budget and pool membership of the solve it continues
+void PuzzleSolver::prepareSolve(int n, double probeBudgetPercent, bool concurrent, bool resumed)
 {
-    setProbeBudget(n, probeBudgetPercent);
+    solveStart = std::chrono::steady_clock::now();
+    phaseStart = solveStart;
+    activePhase = SolvePhase::SEARCH;
+    std::fill(std::begin(phaseMillis), std::end(phaseMillis), 0.0);
+    std::fill(std::begin(phasePerf), std::end(phasePerf), PerfCounts());
+    if (perfCounters) {
+        perfSolveStart = perfCounters->read();
+        perfPhaseStart = perfSolveStart;
+    }
+    allocationContextOutside = AllocationTracker::current();
+    solveActive = true;
+    deadlineHit = false;
+    deadlineCheck = 0;
+    enterPhase(SolvePhase::SEARCH);
+    if (resumed) {
+        budgetExhausted = probesSpent() >= probeBudget;
+    } else {
+        setProbeBudget(n, probeBudgetPercent);
+        if (budgetPool) {
+            poolMember = budgetPool->enrol(probeBudget);
+            probeBudget = budgetPool->baseAllocation(poolMember);
+        }
+    }
+    resetProbeQueue(n);
+
+    transpositionsActive = transpositionEntries > 0 && probeStrategy == ProbeStrategy::LOCAL_HEURISTIC &&
+                           !budgetPool;
+    if (transpositionsActive && !transpositions.enabled()) {
+        transpositions.resize(transpositionEntries);
+    }
+    transpositions.newSolve();
+    strictInference.resetStats();
+    colourHash = computeColourHash();
+    searchNodes = 0;
 
     bestPartialSolution.clear();
     maxQueensPlaced = 0;
 
-    std::vector<std::pair<int, int>> queenPositions;
-    bool solved = mainSolver(0, n, queenPositions);
+    // The board as the solve starts, with everything needed to start it the same way again
+    if (trace) {
+        TraceHeader header;
+        header.gridSize = n;
+        header.probeBudgetPercent = probeBudgetPercent;
+        header.probeBudget = probeBudget;
+        header.strategy = (int)probeStrategy;
+        header.beliefSamples = beliefEngine.sampleCount();
+        header.beliefThreads = beliefEngine.threadCount();
+        header.beliefSeed = beliefEngine.nextSeed();
+        header.speculative = speculativeProbing;
+        header.pooledBudget = budgetPool != nullptr;
+        header.concurrent = concurrent;
+        header.parameters = parameters;
+        header.original = puzzle.getOriginal();
+        header.masked = puzzle.getMasked();
+        trace->begin(header);
+    }
+}
 
+void PuzzleSolver::finishSolve(bool solved)
+{
     if (!solved && !bestPartialSolution.empty()) {
         restoreBestPartialSolution();
     }
 
-    return solved;
+    // Whatever this puzzle did not spend goes back to the rest of the batch
+    if (budgetPool) {
+        int unused = std::max(0, probeBudget - probesSpent());
+        budgetPool->release(poolMember, unused);
+        probeBudget -= unused;
+    }
+
+    enterPhase(SolvePhase::SEARCH);
+    solveMillis = std::chrono::duration<double, std::milli>(phaseStart - solveStart).count();
+    solvePerf = perfCounters ? perfPhaseStart - perfSolveStart : PerfCounts();
+    solveActive = false;
+    AllocationTracker::enter(allocationContextOutside);
+    if (trace) {
+        trace->end(solved);
+    }
 }
 
-bool PuzzleSolver::mainSolver(int row, int n, std::vector<std::pair<int, int>>& queenPositions)
+void PuzzleSolver::setDeadline(std::chrono::steady_clock::time_point limit)
+{
+    hasDeadline = true;
+    deadline = limit;
+}
+
+void PuzzleSolver::clearDeadline()
+{
+    hasDeadline = false;
+}
+
+void PuzzleSolver::setNodeLimit(uint32_t nodes)
+{
+    nodeLimit = nodes;
+}
+
+bool PuzzleSolver::timedOut() const
+{
+    return deadlineHit;
+}
+
+void PuzzleSolver::setParameters(const SolverParameters& values)
+{
+    parameters = values;
+    for (int i = 0; i < strictRuleCount; i++) {
+        strictInference.setWeight(i, parameters.strictWeights[i]);
+    }
+    strictInference.setThreshold(parameters.strictThreshold);
+}
+
+const SolverParameters& PuzzleSolver::getParameters() const
+{
+    return parameters;
+}
+
+void PuzzleSolver::setTranspositionTable(size_t entries)
+{
+    transpositionEntries = entries;
+    transpositions.resize(0);
+}
+
+// The clock is read every 64 nodes, the node count at every node; once either limit is
+// passed, the answer sticks for the rest of the solve
+bool PuzzleSolver::pastDeadline()
+{
+    if (deadlineHit) return true;
+    if (nodeLimit > 0 && searchNodes >= nodeLimit) {
+        deadlineHit = true;
+        return true;
+    }
+    if (!hasDeadline) return false;
+    if ((deadlineCheck++ & 63) == 0 && std::chrono::steady_clock::now() >= deadline) {
+        deadlineHit = true;
+    }
+    return deadlineHit;
+}
+
+static AllocPhase allocationPhase(SolvePhase phase)
+{
+    switch (phase) {
+        case SolvePhase::INFERENCE:       return AllocPhase::INFERENCE;
+        case SolvePhase::PROBE_SELECTION: return AllocPhase::PROBE_SELECTION;
+        case SolvePhase::PROBE_WAIT:      return AllocPhase::PROBE_WAIT;
+        default:                          return AllocPhase::SEARCH;
+    }
+}
+
+const char* solvePhaseName(SolvePhase phase)
+{
+    switch (phase) {
+        case SolvePhase::SEARCH:          return "search";
+        case SolvePhase::INFERENCE:       return "inference";
+        case SolvePhase::PROBE_SELECTION: return "probe_selection";
+        case SolvePhase::PROBE_WAIT:      return "probe_wait";
+        default:                          return "unknown";
+    }
+}
+
+// Charges the time since the last switch to the phase that was running and starts the
+// clock for the new one; returns the phase that was running
+SolvePhase PuzzleSolver::enterPhase(SolvePhase phase)
 {
+    auto now = std::chrono::steady_clock::now();
+    phaseMillis[(int)activePhase] += std::chrono::duration<double, std::milli>(now - phaseStart).count();
+    phaseStart = now;
+
+    if (perfCounters) {
+        PerfCounts counts = perfCounters->read();
+        phasePerf[(int)activePhase].add(counts - perfPhaseStart);
+        perfPhaseStart = counts;
+    }
+
+    // Also re-points the thread at this solver when a suspended solve resumes, since every
+    // suspension point sits inside a phase scope
+    if (solveActive) {
+        AllocationTracker::Context context;
+        context.counters = &allocations;
+        context.phase = allocationPhase(phase);
+        context.component = AllocComponent::SOLVER;
+        AllocationTracker::enter(context);
+    }
+
+    SolvePhase previous = activePhase;
+    activePhase = phase;
+    return previous;
+}
+
+Task<bool> PuzzleSolver::mainSolverAsync(int row, int n, std::vector<std::pair<int, int>>& queenPositions,
+                                         SolveScheduler& scheduler)
+{
+    QUEENS_NODE(instrumentation, row);
+
+    if (pastDeadline()) {
+        co_return false;
+    }
+
     if (row == n) {
-        return validateFinalSolution(queenPositions);
+        co_await probeBatchAsync(unknownQueenCells(queenPositions), scheduler);
+        co_return queensHaveDistinctColours(queenPositions);
     }
 
-    if (queenPositions.size() > maxQueensPlaced) {
-        maxQueensPlaced = queenPositions.size();
-        bestPartialSolution = queenPositions;
+    SearchNode node;
+    if (!openNode(node, row, n, queenPositions)) {
+        co_return false;
     }
 
-    auto viablePositions = findViableQueenPositions(row, n);
+    if (co_await canProbeAsync(row, n, scheduler)) {
+        co_await probeBatchAsync(selectProbeRequests(node.viablePositions), scheduler);
+    }
+
+    bool found = false;
+    for (auto [row, col] : nodeCandidates(node, n)) {
+        int cellColour = knownColour(row, col);
+
+        if (cellColour == -1) {
+            if (co_await canProbeAsync(row, n, scheduler)) {
+                // Built outside the co_await: GCC 12 rejects an initializer list in a coroutine frame
+                std::vector<std::pair<int, int>> cell(1, {row, col});
+                co_await probeBatchAsync(std::move(cell), scheduler);
+                propagateConstraints(n);
+                cellColour = puzzle.getMasked()[row][col];
+            } else {
+                cellColour = weakColour(row, col);
+            }
+        }
+
+        if (!canPlaceQueen(row, col, cellColour)) continue;
+
+        commitQueen(row, col, queenPositions);
+
+        if (co_await mainSolverAsync(row + 1, n, queenPositions, scheduler)) {
+            found = true;
+            break;
+        }
+
+        retractQueen(row, col, queenPositions);
+        if (deadlineHit) {
+            break;
+        }
+    }
+
+    closeNode(node, found);
+    co_return found;
+}
+
+Task<void> PuzzleSolver::probeBatchAsync(std::vector<std::pair<int, int>> cells, SolveScheduler& scheduler)
+{
+    if (cells.empty()) co_return;
+
+    probeCount += cells.size();
+    std::vector<int> colours;
+    {
+        PhaseScope waiting(*this, SolvePhase::PROBE_WAIT);
+        suspendPerf();
+        colours = co_await scheduler.wait(oracle->probeBatch(cells));
+        resumePerf();
+    }
+    for (size_t i = 0; i < cells.size(); i++) {
+        revealCell(cells[i].first, cells[i].second, colours[i]);
+        traceEvent(TraceEventKind::PROBE, cells[i].first, cells[i].second, colours[i]);
+    }
+}
 
-    if (viablePositions.empty()) {
+bool PuzzleSolver::mainSolver(int row, int n, std::vector<std::pair<int, int>>& queenPositions)
+{
+    QUEENS_NODE(instrumentation, row);
+
+    if (pastDeadline()) {
+        return false;
+    }
+
+    // A finished speculative probe that disagrees with its prediction unwinds the search
+    if (!settleSpeculation(false)) {
         return false;
     }
 
+    if (row == n) {
+        return validateFinalSolution(queenPositions);
+    }
+
+    SearchNode node;
+    if (!openNode(node, row, n, queenPositions)) {
+        return false;
+    }
+
+    int batchSpeculation = 0;
     if (canProbe()) {
-        int maxProbesThisRound = std::min(2, (int)viablePositions.size());
-        auto informativeProbes = findBestProbeSpots(maxProbesThisRound, viablePositions);
+        batchSpeculation = issueProbes(selectProbeRequests(node.viablePositions));
+        if (batchSpeculation < 0) {
+            return false;
+        }
+    }
 
-        for (auto [pr, pc] : informativeProbes) {
-            if (!canProbe()) break;
+    bool found = expandNode(node, n, queenPositions);
 
-            if (puzzle.getMasked()[pr][pc] == -1) {
-                int inferredColour = inferStrict(pr, pc);
-                if (inferredColour != -1) {
-                    puzzle.getMasked()[pr][pc] = inferredColour;
-                    inferredCount++;
-                } else {
-                    probe(pr, pc);
+    if (batchSpeculation > 0 && !confirmSpeculation(batchSpeculation)) {
+        found = expandNode(node, n, queenPositions);
+    }
+
+    closeNode(node, found);
+    return found;
+}
+
+bool PuzzleSolver::expandNode(SearchNode& node, int n, std::vector<std::pair<int, int>>& queenPositions)
+{
+    for (auto [row, col] : nodeCandidates(node, n)) {
+        int cellColour = knownColour(row, col);
+        int speculation = 0;
+
+        if (cellColour == -1) {
+            if (canProbe()) {
+                speculation = issueProbes({{row, col}});
+                if (speculation < 0) {
+                    return false;
                 }
+                propagateConstraints(n);
+                cellColour = puzzle.getMasked()[row][col];
+            } else {
+                cellColour = weakColour(row, col);
             }
         }
+
+        bool found = tryPlaceQueen(row, col, cellColour, n, queenPositions);
+
+        if (speculation > 0 && !confirmSpeculation(speculation)) {
+            propagateConstraints(n);
+            cellColour = puzzle.getMasked()[row][col];
+            found = tryPlaceQueen(row, col, cellColour, n, queenPositions);
+        }
+
+        if (found) {
+            return true;
+        }
+
+        // Someone further up guessed a probe wrong; unwind to them
+        if (rollbackToken != 0 || deadlineHit) {
+            return false;
+        }
     }
 
-    propagateConstraints(n);
+    return false;
+}
 
-    viablePositions = findViableQueenPositions(row, n);
+// Entry of a search node below the last row: records the deepest partial placement and
+// returns false when the node fails before any probing, as an empty row or a state the
+// transposition table already knows fails
+bool PuzzleSolver::openNode(SearchNode& node, int row, int n, const std::vector<std::pair<int, int>>& queenPositions)
+{
+    node.row = row;
 
-    if (viablePositions.empty()) {
+    if ((int)queenPositions.size() > maxQueensPlaced) {
+        maxQueensPlaced = (int)queenPositions.size();
+        bestPartialSolution = queenPositions;
+    }
+
+    node.viablePositions = findViableQueenPositions(row, n);
+
+    if (node.viablePositions.empty()) {
+        pruneRow(row);
         return false;
     }
 
+    // Another placement of the rows above already left the same constraints and failed
+    if (transpositionsActive) {
+        node.stateKey = transpositionKey(queenPositions);
+        if (transpositions.knownFailing(node.stateKey)) {
+            traceEvent(TraceEventKind::PRUNE, row, -1, -1, TRACE_PRUNE_KNOWN_FAILURE);
+            return false;
+        }
+    }
+    node.nodesAtEntry = searchNodes++;
+    return true;
+}
+
+// The node's placements in the order to try them, after the round's probes have been
+// propagated; empty (and traced as a pruned row) when none is left
+std::vector<std::pair<int, int>> PuzzleSolver::nodeCandidates(SearchNode& node, int n)
+{
+    propagateConstraints(n);
+
+    node.viablePositions = findViableQueenPositions(node.row, n);
+
+    if (node.viablePositions.empty()) {
+        pruneRow(node.row);
+        return {};
+    }
+    return rankViablePositions(node.viablePositions, n);
+}
+
+// Colour of a candidate cell that needs no probe: known, or strictly inferred now.
+// -1 when the caller has to probe or guess
+int PuzzleSolver::knownColour(int row, int col)
+{
+    int cellColour = puzzle.getMasked()[row][col];
+    if (cellColour != -1) return cellColour;
+
+    int inferredColour = inferStrict(row, col);
+    if (inferredColour != -1) {
+        applyInference(row, col, inferredColour);
+    }
+    return inferredColour;
+}
+
+void PuzzleSolver::closeNode(const SearchNode& node, bool found)
+{
+    if (!found) {
+        rememberFailure(node.stateKey, node.nodesAtEntry);
+    }
+}
+
+bool PuzzleSolver::tryPlaceQueen(int row, int col, int cellColour, int n, std::vector<std::pair<int, int>>& queenPositions)
+{
+    if (!canPlaceQueen(row, col, cellColour)) return false;
+
+    commitQueen(row, col, queenPositions);
+
+    if (mainSolver(row + 1, n, queenPositions)) {
+        return true;
+    }
+
+    retractQueen(row, col, queenPositions);
+    return false;
+}
+
+// Infers what it can among the best probe spots for this node and returns the cells that
+// still need a probe, within the remaining budget. An oracle that answers immediately is
+// asked one cell at a time instead, so each colour can settle the spots after it
+std::vector<std::pair<int, int>> PuzzleSolver::selectProbeRequests(std::vector<std::pair<int, int>>& viablePositions)
+{
+    PhaseScope selection(*this, SolvePhase::PROBE_SELECTION);
+    int maxProbesThisRound = std::min(parameters.probesPerRound, (int)viablePositions.size());
+    auto informativeProbes = findBestProbeSpots(maxProbesThisRound, viablePositions);
+    bool probeEach = oracle->answersImmediately() && !speculativeProbing;
+
+    // Otherwise cells that cannot be inferred are probed together in one round trip
+    std::vector<std::pair<int, int>> probeRequests;
+    for (auto [pr, pc] : informativeProbes) {
+        if (probesSpent() + (int)probeRequests.size() >= probeBudget) {
+            budgetExhausted = true;
+            break;
+        }
+
+        if (puzzle.getMasked()[pr][pc] == -1) {
+            int inferredColour = inferStrict(pr, pc);
+            if (inferredColour != -1) {
+                applyInference(pr, pc, inferredColour);
+            } else if (probeEach) {
+                probe(pr, pc);
+            } else {
+                probeRequests.push_back({pr, pc});
+            }
+        }
+    }
+    return probeRequests;
+}
+
+// Known colours first, then strictly inferable ones, then by probe value
+std::vector<std::pair<int, int>> PuzzleSolver::rankViablePositions(std::vector<std::pair<int, int>>& viablePositions, int n)
+{
     std::vector<std::pair<double, std::pair<int, int>>> scoredPositions;
 
     for (auto [row, col] : viablePositions) {
         double score = 0.0;
 
         if (puzzle.getMasked()[row][col] != -1) {
-            score = 1000.0;
+            score = parameters.knownColourScore;
         } else {
             int inferredColour = inferStrict(row, col);
             if (inferredColour != -1) {
-                score = 500.0;
+                score = parameters.inferredColourScore;
             } else {
                 score = calculateProbeValue(row, col, n);
             }
@@ -735,56 +1455,267 @@ bool PuzzleSolver::mainSolver(int row, int n, std::vector<std::pair<int, int>>&
     std::sort(scoredPositions.begin(), scoredPositions.end(),
               [](const auto& a, const auto& b) { return a.first > b.first; });
 
+    std::vector<std::pair<int, int>> ranked;
     for (auto& [score, pos] : scoredPositions) {
-        int row = pos.first;
-        int col = pos.second;
+        ranked.push_back(pos);
+    }
+    return ranked;
+}
+
+// Colour to assume for a placement once the probe budget is gone, -1 if too uncertain.
+// The probe it stands in for was refused, which a shared pool counts as a denial
+int PuzzleSolver::weakColour(int row, int col)
+{
+    if (budgetPool) {
+        budgetPool->countDenial();
+    }
 
-        int cellColour = puzzle.getMasked()[row][col];
+    double confidence = 0.0;
+    int predictedColour = inferWeak(row, col, confidence);
 
-        if (cellColour == -1) {
-            int inferredColour = inferStrict(row, col);
-            if (inferredColour != -1) {
-                puzzle.getMasked()[row][col] = inferredColour;
-                inferredCount++;
-                cellColour = inferredColour;
-            } else if (canProbe()) {
-                probe(row, col);
-                propagateConstraints(n);
-                cellColour = puzzle.getMasked()[row][col];
-            } else {
-                double confidence = 0.0;
-                int predictedColour = inferWeak(row, col, confidence);
+    if (confidence >= parameters.weakAccept && predictedColour != -1) {
+        return predictedColour;
+    }
+    return -1;
+}
 
-                if (confidence >= 2.0 && predictedColour != -1) {
-                    cellColour = predictedColour;
-                } else {
-                    continue;
-                }
-            }
+bool PuzzleSolver::canPlaceQueen(int row, int col, int cellColour)
+{
+    int reason = cellColour == -1 ? TRACE_PRUNE_UNKNOWN_COLOUR
+               : hasQueenInColour(cellColour) ? TRACE_PRUNE_COLOUR_TAKEN
+               : !isValid(row, col) ? TRACE_PRUNE_ATTACKED
+               : -1;
+    if (reason == -1) return true;
+
+    traceEvent(TraceEventKind::PRUNE, row, col, cellColour, reason);
+    return false;
+}
+
+void PuzzleSolver::commitQueen(int row, int col, std::vector<std::pair<int, int>>& queenPositions)
+{
+    placeQueen(row, col);
+    traceEvent(TraceEventKind::PLACE, row, col, puzzle.getMasked()[row][col]);
+    queensPlaced++;
+    totalQueensPlaced++;
+    queenPositions.push_back({row, col});
+}
+
+void PuzzleSolver::retractQueen(int row, int col, std::vector<std::pair<int, int>>& queenPositions)
+{
+    undoQueenPlacement(row, col);
+    queenPositions.pop_back();
+}
+
+// Guess for a cell about to be probed, or -1 to wait for the answer instead. Only a colour
+// inferWeak is as sure of as weakColour requires is worth searching on: a wrong guess costs
+// the work done on it and then the same work again
+int PuzzleSolver::predictColour(int row, int col)
+{
+    double confidence = 0.0;
+    int colour = inferWeak(row, col, confidence);
+    return confidence >= parameters.weakAccept ? colour : -1;
+}
+
+// Sends the cells as one request. In speculative mode the solver does not wait: it writes
+// predictColour's guesses into the board and keeps searching, returning a token the caller
+// later hands to confirmSpeculation. Returns 0 when the probe completed synchronously and
+// -1 when waiting on an earlier speculation exposed a wrong guess.
+int PuzzleSolver::issueProbes(const std::vector<std::pair<int, int>>& cells)
+{
+    if (cells.empty()) return 0;
+
+    // The previous guess is confirmed first, so every request is one a blocking solve
+    // would make too
+    if (!settleSpeculation(true)) {
+        return -1;
+    }
+
+    // Nothing to overlap with an oracle that has the answer already
+    bool speculate = speculativeProbing && !oracle->answersImmediately();
+    std::vector<int> predicted;
+    for (auto [row, col] : cells) {
+        int colour = speculate ? predictColour(row, col) : -1;
+        if (colour == -1) {
+            probeBatch(cells);
+            return 0;
         }
+        predicted.push_back(colour);
+    }
 
-        if (cellColour == -1) continue;
+    PendingProbe pending;
+    pending.result = oracle->probeBatch(cells);
+    probeCount += cells.size();
+    takeSnapshot(pending.snapshot);
+    transpositions.setJournaling(true);
+    pending.transpositionMark = transpositions.journalPosition();
+    pending.token = ++speculationCounter;
+    pending.cells = cells;
+    pending.predicted = predicted;
+    pendingProbes.push_back(std::move(pending));
+    speculativeProbes++;
 
-        if (hasQueenInColour(cellColour)) continue;
+    for (size_t i = 0; i < cells.size(); i++) {
+        revealCell(cells[i].first, cells[i].second, predicted[i]);
+        traceEvent(TraceEventKind::PROBE, cells[i].first, cells[i].second, predicted[i], TRACE_PROBE_SPECULATIVE);
+    }
 
-        if (isValid(row, col)) {
-            puzzle.getCurrentState()[row][col] = 0;
-            queensPlaced++;
-            totalQueensPlaced++;
-            queenPositions.push_back({row, col});
+    return speculationCounter;
+}
 
-            if (mainSolver(row + 1, n, queenPositions)) {
-                return true;
-            }
+// Compares one outstanding request with its prediction, optionally blocking on it. A wrong
+// guess discards every younger request and names the issuing frame in rollbackToken.
+bool PuzzleSolver::settlePendingProbe(size_t index, bool wait)
+{
+    PendingProbe& pending = pendingProbes[index];
+    if (!wait && pending.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return true;
+    }
 
-            undoQueenPlacement(row, col);
-            queenPositions.pop_back();
+    {
+        PhaseScope waiting(*this, SolvePhase::PROBE_WAIT);
+        pending.actual = pending.result.get();
+    }
+    if (pending.actual == pending.predicted) {
+        pendingProbes.erase(pendingProbes.begin() + index);
+        return true;
+    }
+
+    mispredictedProbes++;
+    rollback = std::move(pending);
+    rollbackToken = rollback.token;
+    pendingProbes.erase(pendingProbes.begin() + index, pendingProbes.end());
+    return false;
+}
+
+// Checks outstanding speculative probes, oldest first. Returns false once one turned out wrong.
+bool PuzzleSolver::settleSpeculation(bool wait)
+{
+    size_t index = 0;
+    while (index < pendingProbes.size()) {
+        size_t before = pendingProbes.size();
+        if (!settlePendingProbe(index, wait)) {
+            return false;
+        }
+        if (pendingProbes.size() == before) {
+            index++;
+        }
+    }
+    return true;
+}
+
+// Called by the frame that issued a speculative probe once its speculative work is done.
+// Returns false if the guess was wrong, after restoring the board with the real colours.
+bool PuzzleSolver::confirmSpeculation(int token)
+{
+    for (size_t i = 0; i < pendingProbes.size(); i++) {
+        if (pendingProbes[i].token == token) {
+            settlePendingProbe(i, true);
+            break;
         }
     }
 
+    if (rollbackToken != token) {
+        return true;
+    }
+
+    rollbackToken = 0;
+    wastedProbes += probeCount - rollback.snapshot.probeCount;
+    restoreSnapshot(rollback.snapshot);
+    transpositions.rollBack(rollback.transpositionMark);
+    for (size_t i = 0; i < rollback.cells.size(); i++) {
+        revealCell(rollback.cells[i].first, rollback.cells[i].second, rollback.actual[i]);
+        traceEvent(TraceEventKind::PROBE, rollback.cells[i].first, rollback.cells[i].second, rollback.actual[i],
+                   TRACE_PROBE_CORRECTION);
+    }
     return false;
 }
 
+void PuzzleSolver::takeSnapshot(SolverSnapshot& snapshot)
+{
+    snapshot.trailMark = trail.size();
+    snapshot.probeCount = probeCount;
+    snapshot.queensPlaced = queensPlaced;
+    snapshot.totalQueensPlaced = totalQueensPlaced;
+    snapshot.backtrackCount = backtrackCount;
+    snapshot.inferredCount = inferredCount;
+    snapshot.budgetExhausted = budgetExhausted;
+    snapshot.maxQueensPlaced = maxQueensPlaced;
+    snapshot.bestPartialSolution = bestPartialSolution;
+    snapshot.searchNodes = searchNodes;
+}
+
+void PuzzleSolver::restoreSnapshot(const SolverSnapshot& snapshot)
+{
+    rollbackTrail(snapshot.trailMark);
+    probeCount = snapshot.probeCount;
+    queensPlaced = snapshot.queensPlaced;
+    totalQueensPlaced = snapshot.totalQueensPlaced;
+    backtrackCount = snapshot.backtrackCount;
+    inferredCount = snapshot.inferredCount;
+    budgetExhausted = snapshot.budgetExhausted;
+    maxQueensPlaced = snapshot.maxQueensPlaced;
+    bestPartialSolution = snapshot.bestPartialSolution;
+    searchNodes = snapshot.searchNodes;
+
+    maskedVersion++;
+    probeQueue.invalidateAll();
+}
+
+SolverSnapshot PuzzleSolver::checkpoint()
+{
+    SolverSnapshot snapshot;
+    takeSnapshot(snapshot);
+    checkpointsHeld++;
+    return snapshot;
+}
+
+// The snapshot can no longer be restored once released
+void PuzzleSolver::releaseCheckpoint(const SolverSnapshot&)
+{
+    checkpointsHeld = std::max(0, checkpointsHeld - 1);
+}
+
+void PuzzleSolver::restoreCheckpoint(const SolverSnapshot& snapshot)
+{
+    restoreSnapshot(snapshot);
+}
+
+// Puts back the board as it was loaded and clears everything a solve accumulates, so the
+// same board can be solved again under another budget or strategy without reloading it
+void PuzzleSolver::resetToPristine()
+{
+    pendingProbes.clear();
+    rollback = PendingProbe();
+    rollbackToken = 0;
+
+    // Restored from the copy, since the trail may not reach back that far. A checkpoint
+    // taken on the untouched board (mark 0) still restores it afterwards
+    trail.clear();
+    puzzle.getMasked() = pristineMasked;
+    for (int row = 0; row < (int)pristineQueens.size(); row++) {
+        if (pristineQueens[row] == -1) {
+            puzzle.clearQueen(row);
+        } else {
+            puzzle.setQueen(row, pristineQueens[row]);
+        }
+    }
+    colourHash = computeColourHash();
+    restoreSnapshot(SolverSnapshot());
+
+    speculativeProbes = 0;
+    mispredictedProbes = 0;
+    wastedProbes = 0;
+    probeBudget = 0;
+    initialUnknownCells = 0;
+    poolMember = -1;
+    beliefVersion = -1;
+}
+
+void PuzzleSolver::setSpeculativeProbing(bool enabled)
+{
+    speculativeProbing = enabled;
+}
+
 void PuzzleSolver::setProbeBudget(int n, double budgetPercent)
 {
     initialUnknownCells = 0;
@@ -800,43 +1731,139 @@ void PuzzleSolver::setProbeBudget(int n, double budgetPercent)
     budgetExhausted = false;
 }
 
+int PuzzleSolver::fairProbeShare(double budgetPercent) const
+{
+    int unknown = 0;
+    for (const auto& row : puzzle.getMasked()) {
+        unknown += std::count(row.begin(), row.end(), -1);
+    }
+    return static_cast<int>(unknown * budgetPercent);
+}
+
+void PuzzleSolver::setProbeStrategy(ProbeStrategy strategy, int samples, int threads, unsigned int seed)
+{
+    probeStrategy = strategy;
+    beliefEngine = BeliefEngine(samples, threads, seed);
+    beliefVersion = -1;
+}
+
 bool PuzzleSolver::canProbe()
 {
-    if (probeCount >= probeBudget) {
+    if (probesSpent() >= probeBudget && budgetPool && budgetPool->tryGrant(poolMember)) {
+        probeBudget++;
+    }
+    if (probesSpent() >= probeBudget) {
         budgetExhausted = true;
         return false;
     }
     return true;
 }
 
+// Over its own budget, a concurrent solve asks the pool for one more probe and waits for
+// the pool to weigh it against the other puzzles' requests
+Task<bool> PuzzleSolver::canProbeAsync(int row, int n, SolveScheduler& scheduler)
+{
+    if (!budgetPool) {
+        co_return canProbe();
+    }
+
+    if (probesSpent() >= probeBudget) {
+        PhaseScope selection(*this, SolvePhase::PROBE_SELECTION);
+        double value = marginalProbeValue(row, n);
+        suspendPerf();
+        probeBudget += co_await budgetPool->request(poolMember, value, scheduler);
+        resumePerf();
+    }
+    budgetExhausted = probesSpent() >= probeBudget;
+    co_return !budgetExhausted;
+}
+
+// Expected payoff of one more probe for this puzzle: high while the search keeps
+// backtracking, low when many unknown cells remain where a queen could still go
+double PuzzleSolver::marginalProbeValue(int row, int n)
+{
+    std::vector<char> columnTaken(n, 0);
+    for (int r = 0; r < row; r++) {
+        for (int c = 0; c < n; c++) {
+            if (puzzle.hasQueen(r, c)) columnTaken[c] = 1;
+        }
+    }
+
+    int unknownCandidates = 0;
+    for (int r = row; r < n; r++) {
+        for (int c = 0; c < n; c++) {
+            if (!columnTaken[c] && puzzle.getMasked()[r][c] == -1) unknownCandidates++;
+        }
+    }
+
+    return (1.0 + backtrackCount) / (1.0 + unknownCandidates);
+}
+
+void PuzzleSolver::setProbeBudgetPool(ProbeBudgetPool* pool)
+{
+    budgetPool = pool;
+}
+
+void PuzzleSolver::setPerfCounters(PerfCounterGroup* group)
+{
+    perfCounters = group && group->available() ? group : nullptr;
+}
+
+void PuzzleSolver::suspendPerf()
+{
+    if (perfCounters) {
+        perfSuspendedAt = perfCounters->read();
+    }
+}
+
+// Moving both starting points past the gap takes it out of the solve total and the phase
+void PuzzleSolver::resumePerf()
+{
+    if (perfCounters) {
+        PerfCounts gap = perfCounters->read() - perfSuspendedAt;
+        perfSolveStart.add(gap);
+        perfPhaseStart.add(gap);
+    }
+}
+
+void PuzzleSolver::setDecisionTrace(DecisionTrace* decisionTrace)
+{
+    trace = decisionTrace;
+}
+
 int PuzzleSolver::inferWeak(int row, int col, double& confidence)
 {
     std::map<int, float> colourConfidence;
     int n = puzzle.getSize();
 
     int neighbourInfer = inferNeighbours(row, col);
+    QUEENS_RESULT(instrumentation, InstrumentSite::WEAK_NEIGHBOURS, neighbourInfer != -1);
     if (neighbourInfer != -1) {
-        colourConfidence[neighbourInfer] += 2.0;
+        colourConfidence[neighbourInfer] += parameters.weakWeights[0];
     }
 
     int rowColInfer = inferRowColumnUniformity(row, col);
+    QUEENS_RESULT(instrumentation, InstrumentSite::WEAK_UNIFORMITY, rowColInfer != -1);
     if (rowColInfer != -1) {
-        colourConfidence[rowColInfer] += 1.5;
+        colourConfidence[rowColInfer] += parameters.weakWeights[1];
     }
 
     int domainInfer = inferFromDomains(row, col);
+    QUEENS_RESULT(instrumentation, InstrumentSite::WEAK_DOMAINS, domainInfer != -1);
     if (domainInfer != -1) {
-        colourConfidence[domainInfer] += 1.0;
+        colourConfidence[domainInfer] += parameters.weakWeights[2];
     }
 
     int contiguityInfer = inferFromContiguity(row, col);
+    QUEENS_RESULT(instrumentation, InstrumentSite::WEAK_CONTIGUITY, contiguityInfer != -1);
     if (contiguityInfer != -1) {
-        colourConfidence[contiguityInfer] += 1.5;
+        colourConfidence[contiguityInfer] += parameters.weakWeights[3];
     }
 
     int patternInfer = inferPatternCompletion(row, col);
+    QUEENS_RESULT(instrumentation, InstrumentSite::WEAK_PATTERN, patternInfer != -1);
     if (patternInfer != -1) {
-        colourConfidence[patternInfer] += 1.5;
+        colourConfidence[patternInfer] += parameters.weakWeights[4];
     }
 
     int bestColour = -1;
@@ -850,6 +1877,7 @@ int PuzzleSolver::inferWeak(int row, int col, double& confidence)
     }
 
     confidence = maxConfidence;
+    QUEENS_RESULT(instrumentation, InstrumentSite::INFER_WEAK, bestColour != -1);
     return bestColour;
 }
 
@@ -950,7 +1978,7 @@ double PuzzleSolver::compareToCorrectPositions(int puzzleNumber, const std::vect
 
     for (int row = 0; row < n; row++) {
         for (int col = 0; col < n; col++) {
-            if (puzzle.getCurrentState()[row][col] == 0) {
+            if (puzzle.hasQueen(row, col)) {
                 currentQueens.insert({row, col});
             }
         }
@@ -986,7 +2014,7 @@ void PuzzleSolver::printCorrectnessReport(int puzzleNumber, const std::vector<st
 
     for (int row = 0; row < n; row++) {
         for (int col = 0; col < n; col++) {
-            if (puzzle.getCurrentState()[row][col] == 0) {
+            if (puzzle.hasQueen(row, col)) {
                 currentQueenPositions.push_back({row, col});
             }
         }
@@ -1015,8 +2043,8 @@ void PuzzleSolver::printCorrectnessReport(int puzzleNumber, const std::vector<st
     std::cout << "\n\n[Solver vs Solution]\n";
 
     std::cout << "--- Comparison ---\n";
-    std::cout << "Expected queens: " << correctPositions.size() << std::endl;
-    std::cout << "Placed queens: " << currentQueenPositions.size() << std::endl;
+    std::cout << "Expected queens: " << correctPositions.size() << '\n';
+    std::cout << "Placed queens: " << currentQueenPositions.size() << '\n';
     std::cout << "Correct positions: " << correct.size() << " / " << correctPositions.size() << " (" << correctPercent << "%)\n";
 
     bool exactMatch = (currentQueenPositions.size() == correctPositionsSet.size());
@@ -1063,6 +2091,8 @@ void PuzzleSolver::printCorrectnessReport(int puzzleNumber, const std::vector<st
 PuzzleStatistics PuzzleSolver::collectStatistics(int puzzleNumber, bool solved,
                                                   const std::vector<std::pair<int, int>>& correctPositions)
 {
+    AllocationTracker::Scope reporting(allocations, AllocPhase::REPORTING, AllocComponent::SOLVER);
+
     PuzzleStatistics stats;
     stats.puzzleNumber = puzzleNumber;
     stats.solved = solved;
@@ -1070,11 +2100,26 @@ PuzzleStatistics PuzzleSolver::collectStatistics(int puzzleNumber, bool solved,
     stats.queensPlaced = queensPlaced;
     stats.expectedQueens = puzzle.getSize();
     stats.probesUsed = probeCount;
+    stats.probesCharged = probesSpent();
+    stats.probesDiscarded = wastedProbes;
     stats.probeBudget = probeBudget;
     stats.inferences = inferredCount;
     stats.backtracks = backtrackCount;
     stats.initialMaskedCells = initialUnknownCells;
     stats.cellsRevealed = probeCount + inferredCount;
+    stats.solveMillis = solveMillis;
+    stats.maskingMillis = puzzle.getMaskingMillis();
+    stats.inferenceMillis = phaseMillis[(int)SolvePhase::INFERENCE];
+    stats.probeSelectionMillis = phaseMillis[(int)SolvePhase::PROBE_SELECTION];
+    stats.probeWaitMillis = phaseMillis[(int)SolvePhase::PROBE_WAIT];
+    stats.searchMillis = phaseMillis[(int)SolvePhase::SEARCH];
+    stats.timedOut = deadlineHit;
+    stats.transpositionLookups = transpositions.getStats().lookups;
+    stats.transpositionHits = transpositions.getStats().hits;
+    stats.inferenceRules = strictInference.getStats();
+    stats.instrumentation = instrumentation;
+    stats.perf = solvePerf;
+    std::copy(std::begin(phasePerf), std::end(phasePerf), std::begin(stats.perfByPhase));
 
     // Calculate correctness score
     if (!correctPositions.empty()) {
@@ -1088,7 +2133,7 @@ PuzzleStatistics PuzzleSolver::collectStatistics(int puzzleNumber, bool solved,
             stats.correctQueens = 0;
             for (int row = 0; row < n; row++) {
                 for (int col = 0; col < n; col++) {
-                    if (puzzle.getCurrentState()[row][col] == 0) {
+                    if (puzzle.hasQueen(row, col)) {
                         if (correctPositionsSet.find({row, col}) != correctPositionsSet.end()) {
                             stats.correctQueens++;
                         }
@@ -1098,5 +2143,9 @@ PuzzleStatistics PuzzleSolver::collectStatistics(int puzzleNumber, bool solved,
         }
     }
 
+    // Taken last so the record includes the work of building it
+    stats.allocations = allocations;
+    stats.allocations.byPhase[(int)AllocPhase::MASKING].merge(puzzle.getMaskingAllocations());
+    stats.allocations.byComponent[(int)AllocComponent::GRAPH].merge(puzzle.getMaskingAllocations());
     return stats;
 }
@@ -0,0 +1,428 @@
+#include "../include/ResultSink.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+namespace {
+    // JSON has no NaN or infinity; such a value is written as null (an empty CSV field)
+    std::string formatNumber(double value, const char* notFinite = "null")
+    {
+        if (!std::isfinite(value)) return notFinite;
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.6g", value);
+        return text;
+    }
+
+    std::string formatCsvNumber(double value)
+    {
+        return formatNumber(value, "");
+    }
+
+    std::string quoted(const std::string& text)
+    {
+        std::string result = "\"";
+        for (char c : text) {
+            if (c == '"' || c == '\\') result += '\\';
+            result += c;
+        }
+        return result + "\"";
+    }
+
+    bool endsWith(const std::string& text, const std::string& suffix)
+    {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+}
+
+void SolveLatency::record(const PuzzleStatistics& stats)
+{
+    solve.record(stats.solveMillis);
+    masking.record(stats.maskingMillis);
+    inference.record(stats.inferenceMillis);
+    probeSelection.record(stats.probeSelectionMillis);
+    probeWait.record(stats.probeWaitMillis);
+    search.record(stats.searchMillis);
+}
+
+std::vector<std::pair<const char*, const LatencyHistogram*>> SolveLatency::phases() const
+{
+    return {{"solve", &solve}, {"masking", &masking}, {"inference", &inference},
+            {"probe_selection", &probeSelection}, {"probe_wait", &probeWait}, {"search", &search}};
+}
+
+OutputOptions extractOutputOptions(int& argc, char* argv[])
+{
+    OutputOptions options;
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--results=", 10) == 0) {
+            options.resultsPath = argv[i] + 10;
+        } else if (std::strcmp(argv[i], "--perf") == 0) {
+            options.perfCounters = true;
+        } else if (std::strncmp(argv[i], "--trace=", 8) == 0) {
+            options.traceDir = argv[i] + 8;
+        } else if (std::strncmp(argv[i], "--trace-ring=", 13) == 0) {
+            options.traceRingEvents = std::strtoull(argv[i] + 13, nullptr, 10);
+        } else if (std::strncmp(argv[i], "--metrics=", 10) == 0) {
+            options.metricsPath = argv[i] + 10;
+        } else if (std::strncmp(argv[i], "--metrics-interval=", 19) == 0) {
+            options.metricsIntervalSeconds = std::max(0.1, std::atof(argv[i] + 19));
+        } else if (std::strncmp(argv[i], "--params=", 9) == 0) {
+            options.parametersPath = argv[i] + 9;
+        } else if (std::strncmp(argv[i], "--mask-seed=", 12) == 0) {
+            options.maskSeed = std::strtoul(argv[i] + 12, nullptr, 10);
+            options.maskSeedGiven = true;
+        } else if (std::strncmp(argv[i], "--verbosity=", 12) == 0) {
+            int level = std::atoi(argv[i] + 12);
+            options.verbosity = static_cast<Verbosity>(std::max(0, std::min(2, level)));
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    if (!options.maskSeedGiven) {
+        options.maskSeed = std::random_device()();
+    }
+    return options;
+}
+
+ResultSink::ResultSink(const std::string& path, size_t bufferBytes)
+    : ResultSink(path, endsWith(path, ".csv") ? ResultFormat::CSV : ResultFormat::JSONL, bufferBytes) {}
+
+ResultSink::ResultSink(const std::string& path, ResultFormat format, size_t bufferBytes)
+    : out(path), path(path), format(format), capacity(bufferBytes)
+{
+    buffer.reserve(capacity);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not open file " << path << " for writing.\n";
+    }
+}
+
+ResultSink::~ResultSink()
+{
+    flush();
+}
+
+bool ResultSink::isOpen() const
+{
+    return out.is_open();
+}
+
+void ResultSink::write(const PuzzleStatistics& stats, const ResultContext& context)
+{
+    AllocationTracker::Scope reporting(AllocPhase::REPORTING, AllocComponent::OTHER);
+    if (format == ResultFormat::CSV) {
+        appendCsv(stats, context);
+    } else {
+        appendJson(stats, context);
+    }
+
+    if (buffer.size() >= capacity) {
+        flush();
+    }
+}
+
+void ResultSink::writeLatency(const SolveLatency& latency, const ResultContext& context, int gridSize)
+{
+    AllocationTracker::Scope reporting(AllocPhase::REPORTING, AllocComponent::OTHER);
+    if (format == ResultFormat::JSONL) {
+        buffer += "{\"record\":\"latency\"";
+        buffer += ",\"masking\":" + formatNumber(context.maskingPercent);
+        buffer += ",\"budget_percent\":" + formatNumber(context.probeBudgetPercent);
+        buffer += ",\"strategy\":" + quoted(context.strategy);
+        buffer += ",\"grid_size\":" + std::to_string(gridSize);
+        buffer += ",\"count\":" + std::to_string(latency.solve.count());
+        for (auto [name, histogram] : latency.phases()) {
+            buffer += std::string(",\"") + name + "_ms\":{";
+            buffer += "\"p50\":" + formatNumber(histogram->percentile(50));
+            buffer += ",\"p90\":" + formatNumber(histogram->percentile(90));
+            buffer += ",\"p99\":" + formatNumber(histogram->percentile(99));
+            buffer += ",\"max\":" + formatNumber(histogram->max());
+            buffer += ",\"mean\":" + formatNumber(histogram->mean()) + "}";
+        }
+        buffer += "}\n";
+        if (buffer.size() >= capacity) {
+            flush();
+        }
+        return;
+    }
+
+    if (!latencyOut.is_open()) {
+        std::string stem = endsWith(path, ".csv") ? path.substr(0, path.size() - 4) : path;
+        std::string latencyPath = stem + "_latency.csv";
+        latencyOut.open(latencyPath);
+        if (!latencyOut.is_open()) {
+            std::cerr << "Error: Could not open file " << latencyPath << " for writing.\n";
+            return;
+        }
+        latencyOut << "masking,budget_percent,strategy,grid_size,phase,count,p50_ms,p90_ms,p99_ms,max_ms,mean_ms\n";
+    }
+
+    for (auto [name, histogram] : latency.phases()) {
+        latencyOut << formatNumber(context.maskingPercent) << "," << formatNumber(context.probeBudgetPercent) << ","
+                   << context.strategy << "," << gridSize << "," << name << "," << histogram->count() << ","
+                   << formatNumber(histogram->percentile(50)) << "," << formatNumber(histogram->percentile(90)) << ","
+                   << formatNumber(histogram->percentile(99)) << "," << formatNumber(histogram->max()) << ","
+                   << formatNumber(histogram->mean()) << "\n";
+    }
+}
+
+void ResultSink::flush()
+{
+    if (out.is_open() && !buffer.empty()) {
+        out.write(buffer.data(), buffer.size());
+        out.flush();
+    }
+    buffer.clear();
+}
+
+void ResultSink::appendJson(const PuzzleStatistics& stats, const ResultContext& context)
+{
+    buffer += "{\"record\":\"puzzle\",\"puzzle\":" + std::to_string(stats.puzzleNumber);
+    buffer += ",\"masking\":" + formatNumber(context.maskingPercent);
+    buffer += ",\"budget_percent\":" + formatNumber(context.probeBudgetPercent);
+    buffer += ",\"strategy\":" + quoted(context.strategy);
+    if (context.maskSeed >= 0) {
+        buffer += ",\"mask_seed\":" + std::to_string(context.maskSeed);
+    }
+    buffer += ",\"grid_size\":" + std::to_string(stats.gridSize);
+    buffer += std::string(",\"solved\":") + (stats.solved ? "true" : "false");
+    buffer += std::string(",\"timed_out\":") + (stats.timedOut ? "true" : "false");
+    buffer += ",\"correctness\":" + formatNumber(stats.correctnessScore);
+    buffer += ",\"queens_placed\":" + std::to_string(stats.queensPlaced);
+    buffer += ",\"expected_queens\":" + std::to_string(stats.expectedQueens);
+    buffer += ",\"correct_queens\":" + std::to_string(stats.correctQueens);
+    buffer += ",\"probes_used\":" + std::to_string(stats.probesUsed);
+    buffer += ",\"probe_budget\":" + std::to_string(stats.probeBudget);
+    buffer += ",\"probes_charged\":" + std::to_string(stats.probesCharged);
+    buffer += ",\"probes_discarded\":" + std::to_string(stats.probesDiscarded);
+    buffer += ",\"inferences\":" + std::to_string(stats.inferences);
+    buffer += ",\"backtracks\":" + std::to_string(stats.backtracks);
+    buffer += ",\"initial_masked\":" + std::to_string(stats.initialMaskedCells);
+    buffer += ",\"cells_revealed\":" + std::to_string(stats.cellsRevealed);
+    buffer += ",\"solve_ms\":" + formatNumber(stats.solveMillis);
+    buffer += ",\"masking_ms\":" + formatNumber(stats.maskingMillis);
+    buffer += ",\"inference_ms\":" + formatNumber(stats.inferenceMillis);
+    buffer += ",\"probe_selection_ms\":" + formatNumber(stats.probeSelectionMillis);
+    buffer += ",\"probe_wait_ms\":" + formatNumber(stats.probeWaitMillis);
+    buffer += ",\"search_ms\":" + formatNumber(stats.searchMillis);
+    buffer += ",\"tt_lookups\":" + std::to_string(stats.transpositionLookups);
+    buffer += ",\"tt_hits\":" + std::to_string(stats.transpositionHits);
+    if (!stats.inferenceRules.empty()) {
+        appendInferenceRulesJson(stats.inferenceRules);
+    }
+    if (InstrumentationCounters::enabled) {
+        appendInstrumentationJson(stats.instrumentation);
+    }
+    if (stats.perf.captured()) {
+        appendPerfJson(stats);
+    }
+    if (AllocationTracker::installed()) {
+        appendAllocationJson(stats.allocations);
+    }
+    buffer += "}\n";
+}
+
+// {"neighbours":{"calls":n,"yields":n,"agreed":n,"skipped":n,"ms":x},...}
+void ResultSink::appendInferenceRulesJson(const std::vector<InferenceRuleStats>& rules)
+{
+    buffer += ",\"inference_rules\":{";
+    for (size_t i = 0; i < rules.size(); i++) {
+        const InferenceRuleStats& rule = rules[i];
+        buffer += std::string(i ? "," : "") + quoted(rule.name) + ":{\"calls\":" + std::to_string(rule.calls) +
+                  ",\"yields\":" + std::to_string(rule.yields) + ",\"agreed\":" + std::to_string(rule.agreed) +
+                  ",\"skipped\":" + std::to_string(rule.skipped) + ",\"ms\":" + formatNumber(rule.millis) + "}";
+    }
+    buffer += "}";
+}
+
+// {"calls":{site:n},"hits":{...},"ns":{...},"nodes_by_depth":[...]}, nodes trimmed after
+// the deepest level reached
+void ResultSink::appendInstrumentationJson(const InstrumentationCounters& counters)
+{
+    std::string calls, hits, nanos;
+    for (int i = 0; i < InstrumentationCounters::siteCount; i++) {
+        InstrumentSite site = static_cast<InstrumentSite>(i);
+        std::string key = quoted(InstrumentationCounters::siteName(site)) + ":";
+        calls += (calls.empty() ? "" : ",") + key + std::to_string(counters.calls[i]);
+        if (InstrumentationCounters::countsHits(site)) {
+            hits += (hits.empty() ? "" : ",") + key + std::to_string(counters.hits[i]);
+        }
+        if (InstrumentationCounters::isTimed(site)) {
+            nanos += (nanos.empty() ? "" : ",") + key + std::to_string(counters.nanos[i]);
+        }
+    }
+
+    int deepest = InstrumentationCounters::maxDepth - 1;
+    while (deepest > 0 && counters.nodesAtDepth[deepest] == 0) deepest--;
+    std::string nodes;
+    for (int d = 0; d <= deepest; d++) {
+        nodes += (d ? "," : "") + std::to_string(counters.nodesAtDepth[d]);
+    }
+
+    buffer += ",\"instrumentation\":{\"calls\":{" + calls + "},\"hits\":{" + hits + "},\"ns\":{" + nanos +
+              "},\"nodes_by_depth\":[" + nodes + "]}";
+}
+
+// {"cycles":n,...,"phases":{"search":{...},...}} with only the events that were available
+void ResultSink::appendPerfJson(const PuzzleStatistics& stats)
+{
+    auto events = [](const PerfCounts& counts, const PerfCounts& available) {
+        std::string text;
+        for (int e = 0; e < PerfCounts::eventCount; e++) {
+            PerfEvent event = static_cast<PerfEvent>(e);
+            if (!available.has(event)) continue;
+            text += (text.empty() ? "" : ",") + quoted(PerfCounts::eventName(event)) + ":" +
+                    std::to_string(counts.get(event));
+        }
+        return text;
+    };
+
+    buffer += ",\"perf\":{" + events(stats.perf, stats.perf) + ",\"phases\":{";
+    for (int p = 0; p < (int)SolvePhase::COUNT; p++) {
+        buffer += std::string(p ? "," : "") + quoted(solvePhaseName(static_cast<SolvePhase>(p))) + ":{" +
+                  events(stats.perfByPhase[p], stats.perf) + "}";
+    }
+    buffer += "}}";
+}
+
+// {"count":n,"bytes":n,"frees":n,"peak_bytes":n,"phases":{"loading":{...},...},"components":{...}}
+void ResultSink::appendAllocationJson(const AllocationCounters& counters)
+{
+    auto fields = [](const AllocationStats& stats) {
+        return "\"count\":" + std::to_string(stats.allocations) + ",\"bytes\":" + std::to_string(stats.bytes) +
+               ",\"frees\":" + std::to_string(stats.frees) + ",\"peak_bytes\":" + std::to_string(stats.peakLiveBytes);
+    };
+
+    buffer += ",\"alloc\":{" + fields(counters.total()) + ",\"phases\":{";
+    for (int p = 0; p < AllocationCounters::phaseCount; p++) {
+        buffer += std::string(p ? "," : "") + quoted(AllocationCounters::phaseName(static_cast<AllocPhase>(p))) +
+                  ":{" + fields(counters.byPhase[p]) + "}";
+    }
+    buffer += "},\"components\":{";
+    for (int c = 0; c < AllocationCounters::componentCount; c++) {
+        buffer += std::string(c ? "," : "") +
+                  quoted(AllocationCounters::componentName(static_cast<AllocComponent>(c))) + ":{" +
+                  fields(counters.byComponent[c]) + "}";
+    }
+    buffer += "}}";
+}
+
+void ResultSink::appendCsv(const PuzzleStatistics& stats, const ResultContext& context)
+{
+    if (!headerWritten) {
+        buffer += "puzzle,masking,budget_percent,strategy,mask_seed,grid_size,solved,timed_out,correctness,"
+                  "queens_placed,expected_queens,correct_queens,probes_used,probe_budget,probes_charged,probes_discarded,"
+                  "inferences,backtracks,"
+                  "initial_masked,cells_revealed,solve_ms,masking_ms,inference_ms,probe_selection_ms,"
+                  "probe_wait_ms,search_ms,tt_lookups,tt_hits";
+        for (const InferenceRuleStats& rule : stats.inferenceRules) {
+            std::string prefix = ",infer_" + rule.name;
+            buffer += prefix + "_calls" + prefix + "_yields" + prefix + "_skipped" + prefix + "_ms";
+        }
+        if (InstrumentationCounters::enabled) {
+            for (int i = 0; i < InstrumentationCounters::siteCount; i++) {
+                InstrumentSite site = static_cast<InstrumentSite>(i);
+                std::string name = InstrumentationCounters::siteName(site);
+                buffer += "," + name + "_calls";
+                if (InstrumentationCounters::countsHits(site)) buffer += "," + name + "_hits";
+                if (InstrumentationCounters::isTimed(site)) buffer += "," + name + "_ns";
+            }
+            buffer += ",search_nodes";
+        }
+        csvPerfColumns = stats.perf.captured();
+        if (csvPerfColumns) {
+            for (int e = 0; e < PerfCounts::eventCount; e++) {
+                buffer += std::string(",perf_") + PerfCounts::eventName(static_cast<PerfEvent>(e));
+            }
+            for (int p = 0; p < (int)SolvePhase::COUNT; p++) {
+                for (int e = 0; e < PerfCounts::eventCount; e++) {
+                    buffer += std::string(",") + solvePhaseName(static_cast<SolvePhase>(p)) + "_" +
+                              PerfCounts::eventName(static_cast<PerfEvent>(e));
+                }
+            }
+        }
+        if (AllocationTracker::installed()) {
+            auto columns = [&](const std::string& prefix) {
+                buffer += "," + prefix + "alloc_count," + prefix + "alloc_bytes," + prefix + "alloc_peak_bytes";
+            };
+            columns("");
+            for (int p = 0; p < AllocationCounters::phaseCount; p++) {
+                columns(std::string(AllocationCounters::phaseName(static_cast<AllocPhase>(p))) + "_");
+            }
+            for (int c = 0; c < AllocationCounters::componentCount; c++) {
+                columns(std::string(AllocationCounters::componentName(static_cast<AllocComponent>(c))) + "_");
+            }
+        }
+        buffer += "\n";
+        headerWritten = true;
+    }
+
+    buffer += std::to_string(stats.puzzleNumber) + ",";
+    buffer += formatCsvNumber(context.maskingPercent) + ",";
+    buffer += formatCsvNumber(context.probeBudgetPercent) + ",";
+    buffer += context.strategy + ",";
+    buffer += (context.maskSeed >= 0 ? std::to_string(context.maskSeed) : std::string()) + ",";
+    buffer += std::to_string(stats.gridSize) + ",";
+    buffer += std::string(stats.solved ? "1" : "0") + ",";
+    buffer += std::string(stats.timedOut ? "1" : "0") + ",";
+    buffer += formatCsvNumber(stats.correctnessScore) + ",";
+    buffer += std::to_string(stats.queensPlaced) + ",";
+    buffer += std::to_string(stats.expectedQueens) + ",";
+    buffer += std::to_string(stats.correctQueens) + ",";
+    buffer += std::to_string(stats.probesUsed) + ",";
+    buffer += std::to_string(stats.probeBudget) + ",";
+    buffer += std::to_string(stats.probesCharged) + ",";
+    buffer += std::to_string(stats.probesDiscarded) + ",";
+    buffer += std::to_string(stats.inferences) + ",";
+    buffer += std::to_string(stats.backtracks) + ",";
+    buffer += std::to_string(stats.initialMaskedCells) + ",";
+    buffer += std::to_string(stats.cellsRevealed) + ",";
+    buffer += formatCsvNumber(stats.solveMillis) + ",";
+    buffer += formatCsvNumber(stats.maskingMillis) + ",";
+    buffer += formatCsvNumber(stats.inferenceMillis) + ",";
+    buffer += formatCsvNumber(stats.probeSelectionMillis) + ",";
+    buffer += formatCsvNumber(stats.probeWaitMillis) + ",";
+    buffer += formatCsvNumber(stats.searchMillis) + ",";
+    buffer += std::to_string(stats.transpositionLookups) + ",";
+    buffer += std::to_string(stats.transpositionHits);
+    for (const InferenceRuleStats& rule : stats.inferenceRules) {
+        buffer += "," + std::to_string(rule.calls) + "," + std::to_string(rule.yields) + "," +
+                  std::to_string(rule.skipped) + "," + formatCsvNumber(rule.millis);
+    }
+    if (InstrumentationCounters::enabled) {
+        const InstrumentationCounters& counters = stats.instrumentation;
+        for (int i = 0; i < InstrumentationCounters::siteCount; i++) {
+            InstrumentSite site = static_cast<InstrumentSite>(i);
+            buffer += "," + std::to_string(counters.calls[i]);
+            if (InstrumentationCounters::countsHits(site)) buffer += "," + std::to_string(counters.hits[i]);
+            if (InstrumentationCounters::isTimed(site)) buffer += "," + std::to_string(counters.nanos[i]);
+        }
+        buffer += "," + std::to_string(counters.totalNodes());
+    }
+    if (csvPerfColumns) {
+        // Unavailable events are left empty
+        auto events = [&](const PerfCounts& counts) {
+            for (int e = 0; e < PerfCounts::eventCount; e++) {
+                PerfEvent event = static_cast<PerfEvent>(e);
+                buffer += "," + (stats.perf.has(event) ? std::to_string(counts.get(event)) : std::string());
+            }
+        };
+        events(stats.perf);
+        for (int p = 0; p < (int)SolvePhase::COUNT; p++) {
+            events(stats.perfByPhase[p]);
+        }
+    }
+    if (AllocationTracker::installed()) {
+        auto values = [&](const AllocationStats& counts) {
+            buffer += "," + std::to_string(counts.allocations) + "," + std::to_string(counts.bytes) + "," +
+                      std::to_string(counts.peakLiveBytes);
+        };
+        values(stats.allocations.total());
+        for (const AllocationStats& counts : stats.allocations.byPhase) values(counts);
+        for (const AllocationStats& counts : stats.allocations.byComponent) values(counts);
+    }
+    buffer += "\n";
+}
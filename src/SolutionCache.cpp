@@ -0,0 +1,314 @@
+#include "../include/SolutionCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    const size_t headerBytes = 32;
+    const size_t indexEntryBytes = 16;
+    const size_t recordHeaderBytes = 4;
+    const uint8_t noQueen = 255;
+
+    // Transform t mirrors the columns when bit 2 is set, then turns the board a quarter
+    // turn (t & 3) times; these are the 8 symmetries of the square
+    std::pair<int, int> transformed(int t, int n, int row, int col)
+    {
+        if (t & 4) col = n - 1 - col;
+        for (int k = 0; k < (t & 3); k++) {
+            int turnedRow = col;
+            col = n - 1 - row;
+            row = turnedRow;
+        }
+        return {row, col};
+    }
+
+    std::pair<int, int> untransformed(int t, int n, int row, int col)
+    {
+        for (int k = 0; k < (t & 3); k++) {
+            int turnedRow = n - 1 - col;
+            col = row;
+            row = turnedRow;
+        }
+        if (t & 4) col = n - 1 - col;
+        return {row, col};
+    }
+
+    uint64_t hashCells(int n, const std::vector<uint8_t>& cells)
+    {
+        uint64_t hash = 1469598103934665603ull;   // FNV-1a
+        auto mix = [&](uint8_t byte) {
+            hash ^= byte;
+            hash *= 1099511628211ull;
+        };
+        mix((uint8_t)n);
+        for (uint8_t cell : cells) {
+            mix(cell);
+        }
+        return hash;
+    }
+
+    template <typename T>
+    T readAt(const uint8_t* base, size_t offset)
+    {
+        T value;
+        std::memcpy(&value, base + offset, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void put(std::string& out, T value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+}
+
+std::pair<int, int> CanonicalBoard::toOriginal(int row, int col) const
+{
+    return transformed(transform, size, row, col);
+}
+
+std::pair<int, int> CanonicalBoard::toCanonical(int row, int col) const
+{
+    return untransformed(transform, size, row, col);
+}
+
+CanonicalBoard CanonicalBoard::of(const PuzzleGrid& board)
+{
+    int n = board.size();
+    int maxColour = 0;
+    for (const auto& row : board) {
+        for (int colour : row) {
+            maxColour = std::max(maxColour, colour);
+        }
+    }
+
+    CanonicalBoard best;
+    best.size = n;
+    std::vector<uint8_t> cells(n * n);
+    std::vector<int> labels(maxColour + 1);
+    for (int t = 0; t < transformCount; t++) {
+        std::fill(labels.begin(), labels.end(), 0);
+        int nextLabel = 1;
+        for (int row = 0; row < n; row++) {
+            for (int col = 0; col < n; col++) {
+                auto [r, c] = transformed(t, n, row, col);
+                int colour = std::max(0, board[r][c]);   // masked cells share label slot 0
+                if (labels[colour] == 0) labels[colour] = nextLabel++;
+                cells[row * n + col] = (uint8_t)labels[colour];
+            }
+        }
+        if (t == 0 || cells < best.cells) {
+            best.cells = cells;
+            best.transform = t;
+        }
+    }
+    best.hash = hashCells(n, best.cells);
+    return best;
+}
+
+SolutionCache::~SolutionCache()
+{
+    unmap();
+}
+
+void SolutionCache::unmap()
+{
+    if (mapped) {
+        munmap(const_cast<uint8_t*>(mapped), mappedBytes);
+    }
+    mapped = nullptr;
+    mappedBytes = 0;
+    mappedEntries = 0;
+}
+
+bool SolutionCache::open(const std::string& path, std::string& error)
+{
+    unmap();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return true;   // nothing cached yet
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)headerBytes) {
+        ::close(fd);
+        error = path + " is not a solution cache";
+        return false;
+    }
+    void* memory = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+
+    mapped = static_cast<const uint8_t*>(memory);
+    mappedBytes = info.st_size;
+    uint64_t entries = readAt<uint64_t>(mapped, 8);
+    uint64_t indexOffset = readAt<uint64_t>(mapped, 16);
+    if (readAt<uint32_t>(mapped, 0) != magic || readAt<uint32_t>(mapped, 4) != version ||
+        indexOffset + entries * indexEntryBytes > mappedBytes) {
+        unmap();
+        error = path + " is not a solution cache (or a different version)";
+        return false;
+    }
+    mappedEntries = entries;
+    return true;
+}
+
+bool SolutionCache::findMapped(const CanonicalBoard& canonical, Entry& entry) const
+{
+    if (!mapped) return false;
+    uint64_t indexOffset = readAt<uint64_t>(mapped, 16);
+    auto hashAt = [&](uint64_t i) { return readAt<uint64_t>(mapped, indexOffset + i * indexEntryBytes); };
+
+    uint64_t low = 0, high = mappedEntries;
+    while (low < high) {
+        uint64_t middle = (low + high) / 2;
+        if (hashAt(middle) < canonical.hash) low = middle + 1;
+        else high = middle;
+    }
+
+    size_t n = canonical.size;
+    for (uint64_t i = low; i < mappedEntries && hashAt(i) == canonical.hash; i++) {
+        uint64_t offset = readAt<uint64_t>(mapped, indexOffset + i * indexEntryBytes + 8);
+        if (offset + recordHeaderBytes + n * n + n > mappedBytes) break;
+        if (mapped[offset] != n) continue;
+        if (std::memcmp(mapped + offset + recordHeaderBytes, canonical.cells.data(), n * n) != 0) continue;
+
+        entry.solved = mapped[offset + 1] != 0;
+        const uint8_t* queens = mapped + offset + recordHeaderBytes + n * n;
+        entry.queenCols.assign(queens, queens + n);
+        return true;
+    }
+    return false;
+}
+
+bool SolutionCache::findAdded(const CanonicalBoard& canonical, Entry& entry) const
+{
+    auto bucket = added.find(canonical.hash);
+    if (bucket == added.end()) return false;
+    for (const auto& [cells, stored] : bucket->second) {
+        if (cells == canonical.cells) {
+            entry = stored;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SolutionCache::lookup(const PuzzleGrid& board, bool& solved, std::vector<std::pair<int, int>>& queens)
+{
+    CanonicalBoard canonical = CanonicalBoard::of(board);
+    Entry entry;
+    if (!findAdded(canonical, entry) && !findMapped(canonical, entry)) {
+        stats.misses++;
+        return false;
+    }
+
+    stats.hits++;
+    solved = entry.solved;
+    queens.clear();
+    for (int row = 0; row < (int)entry.queenCols.size(); row++) {
+        if (entry.queenCols[row] != noQueen) {
+            queens.push_back(canonical.toOriginal(row, entry.queenCols[row]));
+        }
+    }
+    std::sort(queens.begin(), queens.end());
+    return true;
+}
+
+void SolutionCache::insert(const PuzzleGrid& board, bool solved, const std::vector<std::pair<int, int>>& queens)
+{
+    CanonicalBoard canonical = CanonicalBoard::of(board);
+    Entry existing;
+    if (findAdded(canonical, existing) || findMapped(canonical, existing)) {
+        return;   // the first answer stands
+    }
+
+    Entry entry;
+    entry.solved = solved;
+    entry.queenCols.assign(canonical.size, noQueen);
+    for (auto [row, col] : queens) {
+        auto [r, c] = canonical.toCanonical(row, col);
+        entry.queenCols[r] = (uint8_t)c;
+    }
+    added[canonical.hash].push_back({canonical.cells, std::move(entry)});
+    addedCount++;
+}
+
+bool SolutionCache::save(const std::string& path, std::string& error)
+{
+    // (hash, record bytes) for every entry, old and new
+    std::vector<std::pair<uint64_t, std::string>> records;
+    if (mapped) {
+        uint64_t indexOffset = readAt<uint64_t>(mapped, 16);
+        for (uint64_t i = 0; i < mappedEntries; i++) {
+            uint64_t hash = readAt<uint64_t>(mapped, indexOffset + i * indexEntryBytes);
+            uint64_t offset = readAt<uint64_t>(mapped, indexOffset + i * indexEntryBytes + 8);
+            size_t n = mapped[offset];
+            size_t bytes = recordHeaderBytes + n * n + n;
+            if (offset + bytes > mappedBytes) continue;
+            records.push_back({hash, std::string(reinterpret_cast<const char*>(mapped + offset), bytes)});
+        }
+    }
+    for (const auto& [hash, bucket] : added) {
+        for (const auto& [cells, entry] : bucket) {
+            std::string record;
+            put<uint8_t>(record, (uint8_t)entry.queenCols.size());
+            put<uint8_t>(record, entry.solved ? 1 : 0);
+            put<uint16_t>(record, 0);
+            record.append(cells.begin(), cells.end());
+            record.append(entry.queenCols.begin(), entry.queenCols.end());
+            records.push_back({hash, std::move(record)});
+        }
+    }
+    std::stable_sort(records.begin(), records.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::string index, data;
+    uint64_t dataOffset = headerBytes + records.size() * indexEntryBytes;
+    for (const auto& [hash, record] : records) {
+        put<uint64_t>(index, hash);
+        put<uint64_t>(index, dataOffset + data.size());
+        data += record;
+    }
+    std::string header;
+    put<uint32_t>(header, magic);
+    put<uint32_t>(header, version);
+    put<uint64_t>(header, records.size());
+    put<uint64_t>(header, headerBytes);
+    put<uint64_t>(header, dataOffset);
+
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out.is_open() || !(out << header << index << data)) {
+            error = "cannot write " + temporary;
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        error = "cannot replace " + path;
+        return false;
+    }
+
+    added.clear();
+    addedCount = 0;
+    return open(path, error);
+}
+
+size_t SolutionCache::size() const
+{
+    return mappedEntries + addedCount;
+}
+
+const SolutionCache::Stats& SolutionCache::getStats() const
+{
+    return stats;
+}
@@ -0,0 +1,130 @@
+#include "../include/SolveScheduler.h"
+#include <algorithm>
+
+SolveScheduler::SolveScheduler(int maxInFlight) : maxInFlight(std::max(1, maxInFlight)) {}
+
+void SolveScheduler::spawn(Task<void> solve)
+{
+    queued.push_back(std::move(solve));
+}
+
+SolveScheduler::ProbeWait SolveScheduler::wait(std::future<std::vector<int>> result)
+{
+    return ProbeWait(*this, std::move(result));
+}
+
+void SolveScheduler::notifyCompletion()
+{
+    {
+        std::lock_guard<std::mutex> lock(completionMutex);
+        completions++;
+    }
+    completionArrived.notify_one();
+}
+
+void SolveScheduler::addIdleHandler(std::function<bool()> handler)
+{
+    idleHandlers.push_back(std::move(handler));
+}
+
+void SolveScheduler::schedule(std::coroutine_handle<> solve)
+{
+    ready.push_back(solve);
+}
+
+void SolveScheduler::startQueued()
+{
+    while ((int)running.size() < maxInFlight && !queued.empty()) {
+        running.push_back(std::move(queued.front()));
+        queued.pop_front();
+        ready.push_back(running.back().coroutine());
+    }
+    peakInFlight = std::max(peakInFlight, (int)running.size());
+}
+
+void SolveScheduler::collectFinished()
+{
+    auto finished = std::remove_if(running.begin(), running.end(),
+                                   [](const Task<void>& solve) { return solve.done(); });
+    completed += running.end() - finished;
+    running.erase(finished, running.end());
+    startQueued();
+}
+
+// Moves solves whose probe results have arrived to the ready queue. When blocking and
+// nothing has arrived yet, sleeps until notifyCompletion reports the next one.
+void SolveScheduler::wakeReady(bool block)
+{
+    while (true) {
+        // Read before checking the futures: a completion landing in between still wakes the wait
+        unsigned long long seen;
+        {
+            std::lock_guard<std::mutex> lock(completionMutex);
+            seen = completions;
+        }
+
+        auto stillWaiting = std::stable_partition(waiting.begin(), waiting.end(), [](const WaitingSolve& w) {
+            return w.result->wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+        });
+        for (auto it = stillWaiting; it != waiting.end(); ++it) {
+            ready.push_back(it->solve);
+        }
+        waiting.erase(stillWaiting, waiting.end());
+
+        if (!ready.empty() || !block || waiting.empty()) return;
+        std::unique_lock<std::mutex> lock(completionMutex);
+        completionArrived.wait(lock, [this, seen] { return completions != seen; });
+    }
+}
+
+void SolveScheduler::run()
+{
+    startQueued();
+
+    while (!running.empty()) {
+        while (!ready.empty()) {
+            std::coroutine_handle<> solve = ready.front();
+            ready.pop_front();
+            solve.resume();
+        }
+
+        collectFinished();
+        wakeReady(false);
+        if (ready.empty()) {
+            runIdleHandlers();
+        }
+        wakeReady(ready.empty() && !running.empty());
+    }
+}
+
+void SolveScheduler::runIdleHandlers()
+{
+    for (auto& handler : idleHandlers) {
+        if (handler()) return;
+    }
+}
+
+int SolveScheduler::completedCount() const
+{
+    return completed;
+}
+
+int SolveScheduler::queuedCount() const
+{
+    return queued.size();
+}
+
+int SolveScheduler::runningCount() const
+{
+    return running.size();
+}
+
+int SolveScheduler::peakConcurrency() const
+{
+    return peakInFlight;
+}
+
+long long SolveScheduler::suspensionCount() const
+{
+    return suspensions;
+}
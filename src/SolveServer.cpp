@@ -0,0 +1,410 @@
+#include "../include/SolveServer.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    // JSON has no NaN or infinity
+    std::string formatNumber(double value)
+    {
+        if (!std::isfinite(value)) return "null";
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.6g", value);
+        return text;
+    }
+
+    std::string quoted(const std::string& text)
+    {
+        std::string result = "\"";
+        for (char c : text) {
+            if (c == '"' || c == '\\') result += '\\';
+            if (c == '\n') {
+                result += "\\n";
+                continue;
+            }
+            result += c;
+        }
+        return result + "\"";
+    }
+
+    double millisSince(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+    {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // Whitespace-separated tokens straight from a descriptor. A token is only returned once
+    // the whitespace after it has arrived, so an interactive client is never waited on for
+    // more than it sent. '#' starts a comment running to the end of the line.
+    class TokenReader
+    {
+    private:
+        int fd;
+        char buffer[1 << 16];
+        size_t position = 0;
+        size_t length = 0;
+        bool finished = false;
+
+        bool fill()
+        {
+            if (finished) return false;
+            while (true) {
+                ssize_t got = ::read(fd, buffer, sizeof(buffer));
+                if (got > 0) {
+                    position = 0;
+                    length = got;
+                    return true;
+                }
+                if (got < 0 && errno == EINTR) continue;
+                finished = true;
+                return false;
+            }
+        }
+
+        bool peek(char& c)
+        {
+            if (position == length && !fill()) return false;
+            c = buffer[position];
+            return true;
+        }
+
+    public:
+        explicit TokenReader(int fd) : fd(fd) {}
+
+        bool next(std::string& token)
+        {
+            token.clear();
+            char c;
+            while (peek(c)) {
+                if (c == '#') {
+                    while (peek(c) && c != '\n') position++;
+                } else if (std::isspace((unsigned char)c)) {
+                    position++;
+                } else {
+                    break;
+                }
+            }
+            while (peek(c) && !std::isspace((unsigned char)c)) {
+                token += c;
+                position++;
+            }
+            return !token.empty();
+        }
+    };
+
+    bool parseInt(const std::string& token, int& value)
+    {
+        char* end = nullptr;
+        long parsed = std::strtol(token.c_str(), &end, 10);
+        if (end == token.c_str() || *end != '\0') return false;
+        value = (int)parsed;
+        return true;
+    }
+
+    // Removes a socket left at path; anything else there is left alone. False when the
+    // path holds something that is not a socket.
+    bool removeSocket(const std::string& path)
+    {
+        struct stat status;
+        if (::lstat(path.c_str(), &status) < 0) return true;
+        if (!S_ISSOCK(status.st_mode)) return false;
+        ::unlink(path.c_str());
+        return true;
+    }
+}
+
+// One client's output side. Responses are written whole under the lock; the connection
+// counts its outstanding requests so serve() can return only after the last answer.
+struct SolveServer::Connection
+{
+    int outFd;
+    std::mutex writeMutex;
+    bool broken = false;
+
+    std::mutex pendingMutex;
+    std::condition_variable drained;
+    int pending = 0;
+
+    explicit Connection(int fd) : outFd(fd) {}
+
+    void write(const std::string& line)
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        size_t sent = 0;
+        while (!broken && sent < line.size()) {
+            ssize_t wrote = ::write(outFd, line.data() + sent, line.size() - sent);
+            if (wrote < 0 && errno == EINTR) continue;
+            if (wrote <= 0) {
+                broken = true;    // client went away; its remaining answers are dropped
+                break;
+            }
+            sent += wrote;
+        }
+    }
+
+    void started()
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pending++;
+    }
+
+    void finished()
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        if (--pending == 0) drained.notify_all();
+    }
+
+    void waitDrained()
+    {
+        std::unique_lock<std::mutex> lock(pendingMutex);
+        drained.wait(lock, [this]() { return pending == 0; });
+    }
+};
+
+SolveServer::SolveServer(const ServerOptions& serverOptions) : options(serverOptions)
+{
+    if (options.workers <= 0) {
+        options.workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (options.queueLimit <= 0) {
+        options.queueLimit = 2 * options.workers;
+    }
+    for (int w = 0; w < options.workers; w++) {
+        workers.emplace_back(&SolveServer::workerLoop, this);
+    }
+}
+
+SolveServer::~SolveServer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    notEmpty.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+int SolveServer::workerCount() const
+{
+    return options.workers;
+}
+
+void SolveServer::workerLoop()
+{
+    while (true) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (queue.empty()) return;
+            request = std::move(queue.front());
+            queue.pop_front();
+            busy++;
+        }
+        notFull.notify_one();
+
+        std::string line = solve(request);
+        request.connection->write(line);
+        double totalMillis = millisSince(request.received, std::chrono::steady_clock::now());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy--;
+            completed++;
+            latency.record(totalMillis);
+        }
+        request.connection->finished();
+    }
+}
+
+// Every solve gets a fresh board and solver; the work that is shared across requests
+// (threads, the process, the strategy settings) is what the server keeps warm
+std::string SolveServer::solve(const Request& request)
+{
+    auto start = std::chrono::steady_clock::now();
+    int n = request.board->size();
+    Graph board = request.premasked ? Graph(request.board, *request.board)
+                                    : Graph(request.board, options.maskingPercent, options.seed + request.id);
+    PuzzleSolver solver(board);
+    if (options.strategy == ProbeStrategy::MONTE_CARLO) {
+        solver.setProbeStrategy(options.strategy, 256, 1);
+    }
+
+    // Without the full colours there is nothing to answer a probe with
+    bool solved = solver.solvePuzzle(n, request.premasked ? 0.0 : options.probeBudgetPercent);
+    PuzzleStatistics stats = solver.collectStatistics(request.id, solved, {});
+    auto end = std::chrono::steady_clock::now();
+
+    if (solved) {
+        std::lock_guard<std::mutex> lock(mutex);
+        solvedCount++;
+    }
+
+    std::string line = "{\"id\":" + std::to_string(request.id) + ",\"size\":" + std::to_string(n) +
+                       ",\"solved\":" + (solved ? "true" : "false") + ",\"queens\":[";
+    for (int row = 0; row < n; row++) {
+        if (row > 0) line += ",";
+        line += std::to_string(board.queenColumn(row));
+    }
+    double queueMillis = millisSince(request.received, start);
+    double workMillis = millisSince(start, end);
+    line += "],\"probes\":" + std::to_string(stats.probesUsed) + ",\"probe_budget\":" +
+            std::to_string(stats.probeBudget) + ",\"inferences\":" + std::to_string(stats.inferences) +
+            ",\"backtracks\":" + std::to_string(stats.backtracks) + ",\"queue_ms\":" + formatNumber(queueMillis) +
+            ",\"setup_ms\":" + formatNumber(std::max(0.0, workMillis - stats.solveMillis)) +
+            ",\"solve_ms\":" + formatNumber(stats.solveMillis) +
+            ",\"total_ms\":" + formatNumber(queueMillis + workMillis) + "}\n";
+    return line;
+}
+
+std::string SolveServer::statsLine()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return "{\"stats\":{\"requests\":" + std::to_string(nextId - 1) + ",\"completed\":" +
+           std::to_string(completed) + ",\"solved\":" + std::to_string(solvedCount) + ",\"rejected\":" +
+           std::to_string(rejected) + ",\"queued\":" + std::to_string(queue.size()) + ",\"busy\":" +
+           std::to_string(busy) + ",\"workers\":" + std::to_string(options.workers) + ",\"p50_ms\":" +
+           formatNumber(latency.percentile(50)) + ",\"p99_ms\":" + formatNumber(latency.percentile(99)) +
+           ",\"max_ms\":" + formatNumber(latency.max()) + "}}\n";
+}
+
+void SolveServer::reject(const std::shared_ptr<Connection>& connection, const std::string& reason)
+{
+    long long id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = nextId++;
+        rejected++;
+    }
+    connection->write("{\"id\":" + std::to_string(id) + ",\"error\":" + quoted(reason) + "}\n");
+}
+
+void SolveServer::serve(int inFd, int outFd)
+{
+    auto connection = std::make_shared<Connection>(outFd);
+    TokenReader reader(inFd);
+    std::string token;
+
+    while (reader.next(token)) {
+        if (token == "STATS") {
+            connection->write(statsLine());
+            continue;
+        }
+
+        int n = 0;
+        if (!parseInt(token, n) || n < 1 || n > maxGridSize) {
+            reject(connection, "expected a board size (1 to " + std::to_string(maxGridSize) + ") or STATS, got " + token);
+            continue;
+        }
+
+        // The whole board is read even when a cell is bad, so the next request starts in step
+        auto board = std::make_shared<PuzzleGrid>(n, std::vector<int>(n));
+        bool premasked = false;
+        std::string error;
+        for (int cell = 0; cell < n * n; cell++) {
+            if (!reader.next(token)) {
+                if (error.empty()) {
+                    error = "input ended inside a " + std::to_string(n) + "x" + std::to_string(n) + " board";
+                }
+                break;
+            }
+            int colour = 0;
+            if (!parseInt(token, colour) || colour == 0 || colour < -1 || colour > n) {
+                if (error.empty()) {
+                    error = "bad cell " + token + " at row " + std::to_string(cell / n) + ", column " +
+                            std::to_string(cell % n) + " (colours are 1 to " + std::to_string(n) + ", -1 masked)";
+                }
+                continue;
+            }
+            (*board)[cell / n][cell % n] = colour;
+            premasked = premasked || colour == -1;
+        }
+        if (!error.empty()) {
+            reject(connection, error);
+            continue;
+        }
+
+        connection->started();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            notFull.wait(lock, [this]() { return (int)queue.size() < options.queueLimit; });
+            Request request;
+            request.connection = connection;
+            request.id = nextId++;
+            request.board = std::move(board);
+            request.premasked = premasked;
+            request.received = std::chrono::steady_clock::now();
+            queue.push_back(std::move(request));
+        }
+        notEmpty.notify_one();
+    }
+
+    connection->waitDrained();
+}
+
+bool SolveServer::listenUnix(const std::string& path)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: socket path too long: " << path << "\n";
+        return false;
+    }
+    std::strcpy(address.sun_path, path.c_str());
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "Error: socket: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    if (!removeSocket(path)) {   // a stale socket from an earlier run
+        std::cerr << "Error: " << path << " exists and is not a socket\n";
+        ::close(listener);
+        return false;
+    }
+    if (::bind(listener, (sockaddr*)&address, sizeof(address)) < 0 || ::listen(listener, 64) < 0) {
+        std::cerr << "Error: cannot listen on " << path << ": " << std::strerror(errno) << "\n";
+        ::close(listener);
+        return false;
+    }
+
+    // Connection threads are detached; the listener waits for them before returning
+    std::mutex connectionsMutex;
+    std::condition_variable connectionsDone;
+    int openConnections = 0;
+    bool listening = true;
+
+    while (listening) {
+        int client = ::accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            std::cerr << "Error: accept: " << std::strerror(errno) << "\n";
+            listening = false;
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            openConnections++;
+        }
+        std::thread([&, client]() {
+            serve(client, client);
+            ::close(client);
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            if (--openConnections == 0) connectionsDone.notify_all();
+        }).detach();
+    }
+
+    std::unique_lock<std::mutex> lock(connectionsMutex);
+    connectionsDone.wait(lock, [&]() { return openConnections == 0; });
+    ::close(listener);
+    removeSocket(path);
+    return listening;
+}
@@ -0,0 +1,104 @@
+#include "../include/SolveSession.h"
+#include <set>
+
+SolveSession::SolveSession(Graph& graph, double probeBudgetPercent)
+    : puzzle(graph), solver(graph), probeBudgetPercent(probeBudgetPercent) {}
+
+bool SolveSession::solve()
+{
+    started = true;
+    solved = solver.solvePuzzle(puzzle.getSize(), probeBudgetPercent);
+    queenPositions = queensOnBoard();
+    keptQueens = 0;
+    return solved;
+}
+
+bool SolveSession::observe(int row, int col, int colour)
+{
+    return observe(std::vector<CellObservation>{{row, col, colour}});
+}
+
+bool SolveSession::observe(const std::vector<CellObservation>& observations)
+{
+    bool changed = false;
+    for (const auto& observation : observations) {
+        if (puzzle.getMasked()[observation.row][observation.col] != observation.colour) {
+            solver.observeCell(observation.row, observation.col, observation.colour);
+            changed = true;
+        }
+    }
+
+    if (!started) return false;
+    if (!changed) return solved;
+
+    return resolve();
+}
+
+// Keeps the queens above the first one whose colour now clashes, then searches the rows
+// below them. If that prefix cannot be completed, falls back to a full search over
+// everything observed and probed so far.
+bool SolveSession::resolve()
+{
+    int n = puzzle.getSize();
+    keptQueens = consistentPrefixLength();
+
+    if (solved && keptQueens == n) {
+        return true;
+    }
+
+    solved = solver.resumeSolve(n, probeBudgetPercent, queenPositions, keptQueens);
+
+    // A failed solve leaves its best partial placement on the board
+    if (!solved) {
+        queenPositions = queensOnBoard();
+    }
+    return solved;
+}
+
+// Queens are placed one per row from the top, so the board holds a prefix of rows
+std::vector<std::pair<int, int>> SolveSession::queensOnBoard()
+{
+    int n = puzzle.getSize();
+    std::vector<std::pair<int, int>> queens;
+    for (int row = 0; row < n; row++) {
+        int queenCol = puzzle.queenColumn(row);
+        if (queenCol == -1) break;
+        queens.push_back({row, queenCol});
+    }
+    return queens;
+}
+
+// Rows and diagonals do not depend on colours, so only a repeated colour can invalidate
+// a queen that is already placed
+int SolveSession::consistentPrefixLength()
+{
+    std::set<int> usedColours;
+    for (size_t i = 0; i < queenPositions.size(); i++) {
+        int colour = puzzle.getMasked()[queenPositions[i].first][queenPositions[i].second];
+        if (colour == -1) continue;
+        if (!usedColours.insert(colour).second) {
+            return i;
+        }
+    }
+    return queenPositions.size();
+}
+
+bool SolveSession::isSolved() const
+{
+    return solved;
+}
+
+const std::vector<std::pair<int, int>>& SolveSession::getQueens() const
+{
+    return queenPositions;
+}
+
+int SolveSession::lastKeptQueens() const
+{
+    return keptQueens;
+}
+
+PuzzleSolver& SolveSession::getSolver()
+{
+    return solver;
+}
@@ -0,0 +1,154 @@
+#include "../include/SolverParameters.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+const SolverParameters::Field SolverParameters::fields[SolverParameters::fieldCount] = {
+    {"strict_neighbours", 0.0, 8.0, 1.0 / 64},
+    {"strict_uniformity", 0.0, 8.0, 1.0 / 64},
+    {"strict_domains", 0.0, 8.0, 1.0 / 64},
+    {"strict_contiguity", 0.0, 8.0, 1.0 / 64},
+    {"strict_pattern", 0.0, 8.0, 1.0 / 64},
+    {"strict_threshold", 0.0, 16.0, 1.0 / 64},
+    {"weak_neighbours", 0.0, 8.0, 0.0},
+    {"weak_uniformity", 0.0, 8.0, 0.0},
+    {"weak_domains", 0.0, 8.0, 0.0},
+    {"weak_contiguity", 0.0, 8.0, 0.0},
+    {"weak_pattern", 0.0, 8.0, 0.0},
+    {"weak_accept", 0.0, 16.0, 0.0},
+    {"probe_unknown_neighbour", 0.0, 8.0, 0.0},
+    {"probe_corner", 0.0, 8.0, 0.0},
+    {"probe_edge", 0.0, 8.0, 0.0},
+    {"probe_boundary_colour", 0.0, 8.0, 0.0},
+    {"probe_open_row", 0.0, 8.0, 0.0},
+    {"rank_known_colour", 0.0, 2000.0, 0.0},
+    {"rank_inferred_colour", 0.0, 2000.0, 0.0},
+    {"probes_per_round", 1.0, 8.0, 1.0},
+};
+
+double SolverParameters::get(int field) const
+{
+    if (field < ruleCount) return strictWeights[field];
+    if (field == ruleCount) return strictThreshold;
+    if (field < 2 * ruleCount + 1) return weakWeights[field - ruleCount - 1];
+
+    switch (field - 2 * ruleCount - 1) {
+        case 0: return weakAccept;
+        case 1: return unknownNeighbourValue;
+        case 2: return cornerBonus;
+        case 3: return edgeBonus;
+        case 4: return boundaryColourValue;
+        case 5: return openRowBonus;
+        case 6: return knownColourScore;
+        case 7: return inferredColourScore;
+        default: return probesPerRound;
+    }
+}
+
+void SolverParameters::set(int field, double value)
+{
+    const Field& range = fields[field];
+    value = std::clamp(value, range.min, range.max);
+    if (range.step > 0) {
+        value = std::round(value / range.step) * range.step;
+    }
+
+    if (field < ruleCount) {
+        strictWeights[field] = value;
+    } else if (field == ruleCount) {
+        strictThreshold = value;
+    } else if (field < 2 * ruleCount + 1) {
+        weakWeights[field - ruleCount - 1] = value;
+    } else {
+        switch (field - 2 * ruleCount - 1) {
+            case 0: weakAccept = value; break;
+            case 1: unknownNeighbourValue = value; break;
+            case 2: cornerBonus = value; break;
+            case 3: edgeBonus = value; break;
+            case 4: boundaryColourValue = value; break;
+            case 5: openRowBonus = value; break;
+            case 6: knownColourScore = value; break;
+            case 7: inferredColourScore = value; break;
+            default: probesPerRound = (int)value; break;
+        }
+    }
+}
+
+int SolverParameters::findField(const std::string& name)
+{
+    for (int i = 0; i < fieldCount; i++) {
+        if (name == fields[i].name) return i;
+    }
+    return -1;
+}
+
+bool SolverParameters::load(const std::string& path, std::string& error)
+{
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    SolverParameters loaded;
+    std::string line;
+    for (int lineNumber = 1; std::getline(in, line); lineNumber++) {
+        line = line.substr(0, line.find('#'));
+        size_t equals = line.find('=');
+        std::string name = line.substr(0, equals);
+        name.erase(std::remove_if(name.begin(), name.end(), ::isspace), name.end());
+        if (name.empty() && equals == std::string::npos) continue;
+
+        std::string where = path + ":" + std::to_string(lineNumber);
+        int field = findField(name);
+        if (field == -1 || equals == std::string::npos) {
+            error = where + ": expected <parameter> = <value>, got \"" + line + "\"";
+            return false;
+        }
+        std::istringstream text(line.substr(equals + 1));
+        double value = 0.0;
+        std::string rest;
+        if (!(text >> value) || (text >> rest)) {
+            error = where + ": " + name + " needs a number";
+            return false;
+        }
+        loaded.set(field, value);
+    }
+
+    *this = loaded;
+    return true;
+}
+
+std::string SolverParameters::toString() const
+{
+    std::string text;
+    for (int i = 0; i < fieldCount; i++) {
+        char number[32];
+        auto end = std::to_chars(number, number + sizeof(number), get(i)).ptr;
+        text += std::string(fields[i].name) + " = " + std::string(number, end) + "\n";
+    }
+    return text;
+}
+
+// Written next to the destination and renamed over it, so readers never see half a file
+bool SolverParameters::save(const std::string& path, const std::string& comment) const
+{
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary);
+        if (!out.is_open()) return false;
+
+        std::istringstream lines(comment);
+        std::string line;
+        while (std::getline(lines, line)) {
+            out << "# " << line << "\n";
+        }
+        out << toString();
+        if (!out) return false;
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
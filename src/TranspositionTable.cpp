@@ -0,0 +1,149 @@
+#include "../include/TranspositionTable.h"
+#include <algorithm>
+
+// splitmix64's finalizer: every input bit affects every output bit
+uint64_t TranspositionTable::mix(uint64_t value)
+{
+    value += 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+// The top byte keeps the features apart
+uint64_t TranspositionTable::colourKey(int cell, int colour)
+{
+    if (colour == -1) return 0;
+    return mix((1ull << 56) | ((uint64_t)(uint32_t)cell << 20) | (uint32_t)(colour & 0xfffff));
+}
+
+uint64_t TranspositionTable::budgetKey(int probesLeft)
+{
+    return mix((2ull << 56) | (uint32_t)std::max(0, probesLeft));
+}
+
+uint64_t TranspositionTable::columnKey(int col)
+{
+    return mix((3ull << 56) | (uint32_t)col);
+}
+
+uint64_t TranspositionTable::takenColourKey(int colour)
+{
+    return mix((4ull << 56) | (uint32_t)colour);
+}
+
+uint64_t TranspositionTable::lastColumnKey(int col)
+{
+    return mix((5ull << 56) | (uint32_t)col);
+}
+
+uint64_t TranspositionTable::queenKey(int cell)
+{
+    return mix((6ull << 56) | (uint32_t)cell);
+}
+
+void TranspositionTable::resize(size_t entryCount)
+{
+    size_t buckets = 0;
+    if (entryCount >= 2) {
+        buckets = 1;
+        while (buckets * 4 <= entryCount) buckets *= 2;
+    }
+    entries.assign(buckets * 2, Entry());
+    entries.shrink_to_fit();
+    bucketMask = buckets ? buckets - 1 : 0;
+    generation = 0;
+    journal.clear();
+}
+
+size_t TranspositionTable::capacity() const
+{
+    return entries.size();
+}
+
+bool TranspositionTable::enabled() const
+{
+    return !entries.empty();
+}
+
+void TranspositionTable::newSolve()
+{
+    stats = Stats();
+    setJournaling(false);
+    if (++generation == 0) {
+        // Wrapped after 4 billion solves: old generations could look current again
+        std::fill(entries.begin(), entries.end(), Entry());
+        generation = 1;
+    }
+}
+
+bool TranspositionTable::knownFailing(uint64_t key)
+{
+    if (entries.empty()) return false;
+    stats.lookups++;
+    const Entry* bucket = &entries[(key & bucketMask) * 2];
+    for (int slot = 0; slot < 2; slot++) {
+        if (bucket[slot].generation == generation && bucket[slot].key == key) {
+            stats.hits++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::recordFailure(uint64_t key, uint32_t subtreeNodes)
+{
+    if (entries.empty()) return;
+    stats.stores++;
+    size_t index = key & bucketMask;
+    Entry* bucket = &entries[index * 2];
+    if (journaling) {
+        journal.push_back({index, bucket[0], bucket[1]});
+    }
+    Entry& kept = bucket[0];
+    Entry& recent = bucket[1];
+
+    Entry* target = &recent;
+    if (kept.generation != generation || kept.key == key || subtreeNodes >= kept.subtreeNodes) {
+        // The larger subtree moves into the kept slot; what it displaces is still recent
+        if (kept.generation == generation && kept.key != key) {
+            if (recent.generation == generation) stats.evictions++;
+            recent = kept;
+        }
+        target = &kept;
+    } else if (recent.generation == generation && recent.key != key) {
+        stats.evictions++;
+    }
+    target->key = key;
+    target->generation = generation;
+    target->subtreeNodes = subtreeNodes;
+}
+
+const TranspositionTable::Stats& TranspositionTable::getStats() const
+{
+    return stats;
+}
+
+void TranspositionTable::setJournaling(bool enabled)
+{
+    journaling = enabled;
+    if (!enabled) {
+        journal.clear();
+    }
+}
+
+size_t TranspositionTable::journalPosition() const
+{
+    return journal.size();
+}
+
+// Newest first, so a bucket changed twice ends up as it was before the first change
+void TranspositionTable::rollBack(size_t position)
+{
+    while (journal.size() > position) {
+        const JournalEntry& undo = journal.back();
+        entries[undo.bucket * 2] = undo.kept;
+        entries[undo.bucket * 2 + 1] = undo.recent;
+        journal.pop_back();
+    }
+}
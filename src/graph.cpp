@@ -1,4 +1,5 @@
 #include "../include/graph.h"
+#include <chrono>
 #include <map>
 #include <set>
 
@@ -6,7 +7,7 @@
 // Non-queen spot represented by -1
 
 // Default Constructor
-Graph::Graph() {
+Graph::Graph() : original(std::make_shared<const PuzzleGrid>()) {
     // puzzle = {
     //     {1, 2, 2, 2, 2, 2, 2, 2, 2},
     //     {1, 1, 2, 3, 3, 3, 2, 2, 2},
@@ -45,13 +46,31 @@ Graph::Graph() {
 
 // Constructor (default 30% masking)
 Graph::Graph(const std::vector<std::vector<int>>& data)
-    : original(data), currentState(data), masked(createMaskedMatrix(data, 0.3)) {}
+    : Graph(std::make_shared<const PuzzleGrid>(data), 0.3) {}
 
 // Constructor with configurable masking percentage
 Graph::Graph(const std::vector<std::vector<int>>& data, double maskingPercentage)
-    : original(data), currentState(data), masked(createMaskedMatrix(data, maskingPercentage)) {}
+    : Graph(std::make_shared<const PuzzleGrid>(data), maskingPercentage) {}
 
-const std::vector<std::vector<int>>& Graph::getOriginal() {
+// Shares an already loaded board instead of copying it
+Graph::Graph(std::shared_ptr<const PuzzleGrid> data, double maskingPercentage)
+    : original(std::move(data)), masked(createMaskedMatrix(*original, maskingPercentage)),
+      queenCols(original->size(), -1) {}
+
+// Seeded masking, so the same seed reproduces the same masked board
+Graph::Graph(std::shared_ptr<const PuzzleGrid> data, double maskingPercentage, unsigned int seed)
+    : original(std::move(data)), masked(createMaskedMatrix(*original, maskingPercentage, seed)),
+      queenCols(original->size(), -1) {}
+
+// A board masked elsewhere, e.g. the starting board of a recorded solve
+Graph::Graph(std::shared_ptr<const PuzzleGrid> data, const PuzzleGrid& maskedBoard)
+    : original(std::move(data)), masked(maskedBoard), queenCols(original->size(), -1) {}
+
+const std::vector<std::vector<int>>& Graph::getOriginal() const {
+    return *original;
+}
+
+std::shared_ptr<const PuzzleGrid> Graph::getSharedOriginal() const {
     return original;
 }
 
@@ -59,13 +78,33 @@ std::vector<std::vector<int>>& Graph::getMasked() {
     return masked;
 }
 
-std::vector<std::vector<int>>& Graph::getCurrentState() {
-    return currentState;
+bool Graph::hasQueen(int row, int col) const {
+    return queenCols[row] == col;
 }
 
+// Column of the queen in this row, or -1
+int Graph::queenColumn(int row) const {
+    return queenCols[row];
+}
+
+void Graph::setQueen(int row, int col) {
+    queenCols[row] = col;
+}
+
+void Graph::clearQueen(int row) {
+    queenCols[row] = -1;
+}
 
 int Graph::getSize() const {
-    return original.size();
+    return original->size();
+}
+
+double Graph::getMaskingMillis() const {
+    return maskingMillis;
+}
+
+const AllocationStats& Graph::getMaskingAllocations() const {
+    return maskingAllocations;
 }
 
 void Graph::printGraph(PrintMode mode) const {
@@ -74,19 +113,17 @@ void Graph::printGraph(PrintMode mode) const {
     
     switch (mode) {
         case ORIGINAL:
-            puzzleType = &original;
+            puzzleType = original.get();
             break;
         case MASKED:
-            puzzleType = &masked;
-            break;
         case CURRENT_RAW:
         case CURRENT_SYMBOLS:
-            puzzleType = &currentState;
+            puzzleType = &masked;
             break;
     }
     
     if (!puzzleType || puzzleType->empty()) {
-        std::cout << "Empty matrix" << std::endl;
+        std::cout << "Empty matrix\n";
         return;
     }
     
@@ -94,7 +131,9 @@ void Graph::printGraph(PrintMode mode) const {
     std::cout << "---------------------\n";
     for (int i = 0; i < n; ++i) {
         for (int j = 0; j < n; ++j) {
-            int value = (*puzzleType)[i][j];
+            // Current state is the masked board with queens on top
+            bool queen = (mode == CURRENT_RAW || mode == CURRENT_SYMBOLS) && hasQueen(i, j);
+            int value = queen ? 0 : (*puzzleType)[i][j];
             
             if (mode == CURRENT_SYMBOLS) {
                 if (value == 0)
@@ -122,18 +161,31 @@ void Graph::printGraph(PrintMode mode) const {
 // }
 
 std::vector<std::vector<int>> Graph::createMaskedMatrix(const std::vector<std::vector<int>>& original, double mask_prob) {
-    std::vector<std::vector<int>> masked = original;
     std::random_device rd;
-    std::mt19937 gen(rd());
-    std::bernoulli_distribution mask(mask_prob);
+    return createMaskedMatrix(original, mask_prob, rd());
+}
 
-    for (size_t i = 0; i < masked.size(); ++i) {
-        for (size_t j = 0; j < masked[i].size(); ++j) {
-            if (mask(gen)) {
-                masked[i][j] = -1;
+std::vector<std::vector<int>> Graph::createMaskedMatrix(const std::vector<std::vector<int>>& original, double mask_prob, unsigned int seed) {
+    auto start = std::chrono::steady_clock::now();
+    // The board's own block, so the puzzle's record can carry its masking cost
+    AllocationCounters allocations;
+    std::vector<std::vector<int>> masked;
+    {
+        AllocationTracker::Scope scope(allocations, AllocPhase::MASKING, AllocComponent::GRAPH);
+        masked = original;
+        std::mt19937 gen(seed);
+        std::bernoulli_distribution mask(mask_prob);
+
+        for (size_t i = 0; i < masked.size(); ++i) {
+            for (size_t j = 0; j < masked[i].size(); ++j) {
+                if (mask(gen)) {
+                    masked[i][j] = -1;
+                }
             }
         }
     }
+    maskingAllocations = allocations.byPhase[(int)AllocPhase::MASKING];
+    maskingMillis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
     return masked;
 }
 
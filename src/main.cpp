@@ -1,11 +1,17 @@
 #include "../include/PuzzleManager.h"
 #include "../include/PuzzleSolver.h"
+#include "../include/ResultSink.h"
 #include <string>
+#include <memory>
 
 // Key: {Queen = 0, Masked = -1, Colour Square = 1 to N-Colours}
 
 int main(int argc, char* argv[])
 {
+    std::ios::sync_with_stdio(false);
+    OutputOptions output = extractOutputOptions(argc, argv);
+    bool showBoards = output.verbosity == Verbosity::BOARDS;
+
     // Configuration parameters (can be passed as command line args)
     int numPuzzles = 100;
     double maskingPercentage = 0.3;      // 30% by default
@@ -13,7 +19,7 @@ int main(int argc, char* argv[])
     std::string puzzleFileName = "puzzles.txt";
 
     // Allow command line arguments for customization
-    // Usage: ./main.out [numPuzzles] [maskingPercent] [probeBudgetPercent]
+    // Usage: ./main.out [numPuzzles] [maskingPercent] [probeBudgetPercent] [--results=file.jsonl|file.csv] [--verbosity=0|1|2] [--params=file] [--mask-seed=n]
     if (argc >= 2) {
         numPuzzles = std::stoi(argv[1]);
     }
@@ -24,14 +30,23 @@ int main(int argc, char* argv[])
         probeBudgetPercent = std::stod(argv[3]);
     }
 
+    SolverParameters parameters;
+    std::string parametersError;
+    if (!output.parametersPath.empty() && !parameters.load(output.parametersPath, parametersError)) {
+        std::cerr << "Error: " << parametersError << "\n";
+        return 1;
+    }
+
     std::cout << "\n[ CONFIGURATION ]\n";
     std::cout << "Number of puzzles: " << numPuzzles << "\n";
     std::cout << "Masking percentage: " << (maskingPercentage * 100) << "%\n";
-    std::cout << "Probe budget: " << (probeBudgetPercent * 100) << "% of masked cells\n\n";
+    std::cout << "Probe budget: " << (probeBudgetPercent * 100) << "% of masked cells\n";
+    std::cout << "Masking seed: " << output.maskSeed << "\n\n";
 
     std::vector<Graph> graphs;
     // std::vector<Graph> Graphs; = PuzzleManager::loadFromFile(puzzleFileName, numPuzzles);
-    PuzzleManager::loadFromFile(puzzleFileName, numPuzzles, graphs, maskingPercentage);
+    PuzzleManager::maskCorpus(PuzzleManager::loadCorpus(puzzleFileName, numPuzzles), graphs,
+                              maskingPercentage, output.maskSeed);
 
     // Load solutions to verify PuzzleSolver results 
     auto solutionsPos = PuzzleSolver::loadSolutions("solutions.txt");
@@ -44,23 +59,39 @@ int main(int argc, char* argv[])
     double totalCorrectness = 0.0;
     int totalPuzzles = 0;
 
+    std::unique_ptr<ResultSink> sink;
+    if (!output.resultsPath.empty()) {
+        sink.reset(new ResultSink(output.resultsPath));
+    }
+    ResultContext context;
+    context.maskingPercent = maskingPercentage;
+    context.probeBudgetPercent = probeBudgetPercent;
+    context.maskSeed = output.maskSeed;
+
     for (auto &g : graphs)
     {
-        std::cout << "\n------ PUZZLE " << puzzleNumber << "/" << numPuzzles << " ------\n\n";
-
         PuzzleSolver solver(g);
-        // g.printGraph(g.ORIGINAL);
-        // Initial masked before board is altered (starting state of problem)
-        std::cout << "Original Masked:\n";
-        g.printGraph(g.MASKED);
-        // Full board with colours revealed
-        std::cout << "Original:\n";
-        g.printGraph(g.ORIGINAL);
+        solver.setParameters(parameters);
+
+        if (showBoards) {
+            std::cout << "\n------ PUZZLE " << puzzleNumber << "/" << numPuzzles << " ------\n\n";
+            // g.printGraph(g.ORIGINAL);
+            // Initial masked before board is altered (starting state of problem)
+            std::cout << "Original Masked:\n";
+            g.printGraph(g.MASKED);
+            // Full board with colours revealed
+            std::cout << "Original:\n";
+            g.printGraph(g.ORIGINAL);
+        }
 
         bool solved = solver.solvePuzzle(g.getSize(), probeBudgetPercent);  // Using minimal sensing solver
 
+        if (solved) {
+            solvedCount++;
+        }
+
         // when the solver fails
-        if (!solved)
+        if (showBoards && !solved)
         {
             std::cout << "\n❌ PUZZLE " << puzzleNumber << " - No solution found.\n";
             std::cout << "Current State of failed board (queens placed so far):\n";
@@ -69,34 +100,49 @@ int main(int argc, char* argv[])
             if (solutionBoards.find(puzzleNumber) != solutionBoards.end()) {
                 std::cout << "Correct Solution Board:\n";
                 for (const auto& row : solutionBoards[puzzleNumber]) {
-                    std::cout << row << std::endl;
+                    std::cout << row << '\n';
                 }
             }
         }
         // when the solver does not fail
-        else
+        else if (showBoards)
         {
             std::cout << "✅ PUZZLE " << puzzleNumber << " - Solution found!\n";
             std::cout << "Current:\n";
             g.printGraph(g.CURRENT_SYMBOLS);
             std::cout << "Final Masked:\n";
             g.printGraph(g.MASKED);
-
-            solvedCount++;
         }
 
-        solver.printStatistics();
+        if (showBoards) {
+            solver.printStatistics();
+        }
 
         // Compare with correct solution (for both solved and failed)
+        std::vector<std::pair<int, int>> correctPositions;
         if (solutionsPos.find(puzzleNumber) != solutionsPos.end()) {
-            auto& correctPositions = solutionsPos[puzzleNumber];
-            solver.printCorrectnessReport(puzzleNumber, correctPositions);
+            correctPositions = solutionsPos[puzzleNumber];
+            if (showBoards) {
+                solver.printCorrectnessReport(puzzleNumber, correctPositions);
+            }
+        }
 
-            double correctness = solver.compareToCorrectPositions(puzzleNumber, correctPositions);
-            totalCorrectness += correctness;
+        PuzzleStatistics stats = solver.collectStatistics(puzzleNumber, solved, correctPositions);
+        if (!correctPositions.empty()) {
+            totalCorrectness += stats.correctnessScore;
             totalPuzzles++;
+        }
+
+        if (showBoards && !correctPositions.empty()) {
+            std::cout << "Correctness score: " << (stats.correctnessScore * 100.0) << "%\n";
+        } else if (output.verbosity == Verbosity::PROGRESS) {
+            std::cout << "Puzzle " << puzzleNumber << "/" << numPuzzles << ": " << (solved ? "SOLVED" : "FAILED")
+                      << " (P:" << stats.probesUsed << "/" << stats.probeBudget << " I:" << stats.inferences
+                      << " B:" << stats.backtracks << " " << stats.solveMillis << " ms)\n";
+        }
 
-            std::cout << "Correctness score: " << (correctness * 100.0) << "%" << std::endl;
+        if (sink) {
+            sink->write(stats, context);
         }
 
         puzzleNumber++;
@@ -0,0 +1,411 @@
+#include "../include/PuzzleManager.h"
+#include "../include/PuzzleSolver.h"
+#include "../include/CSPLinkedInSolver.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Microbenchmarks for the solver's hot paths, one row per (benchmark, grid size, masking).
+// Boards come from puzzles.txt and are masked with fixed seeds, so two runs (or two
+// commits) time exactly the same work.
+// Usage: ./bench.out [--sizes=7,8,9,10,11] [--maskings=0.1,0.3,0.5] [--filter=substring]
+//                    [--puzzles=8] [--samples=5] [--min-sample-ms=20] [--seed=12345]
+//                    [--output=bench_results.json]
+
+// Private solver steps the benchmarks call directly
+class SolverBench
+{
+public:
+    static int inferNeighbours(PuzzleSolver& s, int r, int c) { return s.inferNeighbours(r, c); }
+    static int inferUniformity(PuzzleSolver& s, int r, int c) { return s.inferRowColumnUniformity(r, c); }
+    static int inferDomains(PuzzleSolver& s, int r, int c) { return s.inferFromDomains(r, c); }
+    static int inferContiguity(PuzzleSolver& s, int r, int c) { return s.inferFromContiguity(r, c); }
+    static int inferPattern(PuzzleSolver& s, int r, int c) { return s.inferPatternCompletion(r, c); }
+    static int inferStrict(PuzzleSolver& s, int r, int c) { return s.inferStrict(r, c); }
+    static void resetProbeQueue(PuzzleSolver& s, int n) { s.resetProbeQueue(n); }
+};
+
+namespace {
+    struct BenchOptions
+    {
+        std::vector<int> sizes = {7, 8, 9, 10, 11};
+        std::vector<double> maskings = {0.1, 0.3, 0.5};
+        std::string filter;
+        int puzzlesPerSize = 8;
+        int samples = 5;
+        double minSampleMillis = 20.0;
+        unsigned int seed = 12345;
+        std::string outputPath = "bench_results.json";
+    };
+
+    struct BenchResult
+    {
+        std::string name;
+        int gridSize = 0;
+        double masking = 0.0;
+        int boards = 0;
+        long long opsPerSample = 0;
+        std::vector<double> nsPerOp;   // one entry per sample
+        double allocsPerOp = 0.0;      // ALLOC_TRACK builds only
+        double bytesPerOp = 0.0;
+    };
+
+    // Boards of one grid size at one masking level, each with its own solver
+    struct Fixture
+    {
+        int gridSize = 0;
+        double masking = 0.0;
+        std::deque<Graph> boards;
+        std::deque<PuzzleSolver> solvers;
+        std::vector<SolverSnapshot> pristine;
+    };
+
+    // Keeps a result alive so the compiler cannot drop the call that produced it
+    template <typename T>
+    void keep(const T& value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    template <typename T>
+    std::vector<T> parseList(const std::string& spec, T (*convert)(const std::string&))
+    {
+        std::vector<T> values;
+        std::stringstream parts(spec);
+        std::string value;
+        while (std::getline(parts, value, ',')) {
+            if (!value.empty()) values.push_back(convert(value));
+        }
+        return values;
+    }
+
+    int toInt(const std::string& text) { return std::stoi(text); }
+    double toDouble(const std::string& text) { return std::stod(text); }
+
+    BenchOptions parseOptions(int argc, char* argv[])
+    {
+        BenchOptions options;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            size_t eq = arg.find('=');
+            std::string key = arg.substr(0, eq);
+            std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+            if (key == "--sizes") options.sizes = parseList(value, toInt);
+            else if (key == "--maskings") options.maskings = parseList(value, toDouble);
+            else if (key == "--filter") options.filter = value;
+            else if (key == "--puzzles") options.puzzlesPerSize = std::stoi(value);
+            else if (key == "--samples") options.samples = std::max(1, std::stoi(value));
+            else if (key == "--min-sample-ms") options.minSampleMillis = std::stod(value);
+            else if (key == "--seed") options.seed = std::stoul(value);
+            else if (key == "--output") options.outputPath = value;
+            else std::cerr << "Ignoring unknown option " << arg << "\n";
+        }
+        return options;
+    }
+
+    // Heap activity so far of everything a benchmark can charge: calls made directly land in
+    // its own block, solves in the solvers' blocks
+    AllocationStats fixtureAllocations(const Fixture& fixture, const AllocationCounters& direct)
+    {
+        AllocationStats total = direct.total();
+        for (const PuzzleSolver& solver : fixture.solvers) {
+            total.merge(solver.allocations.total());
+        }
+        return total;
+    }
+
+    // A pass runs op once for every item. The first sample doubles the number of passes
+    // until it lasts minSampleMillis; every sample then runs that many passes.
+    BenchResult measure(const std::string& name, const Fixture& fixture, double masking, size_t items,
+                        const BenchOptions& options, const std::function<void(size_t)>& op)
+    {
+        BenchResult result;
+        result.name = name;
+        result.gridSize = fixture.gridSize;
+        result.masking = masking;
+        result.boards = fixture.boards.size();
+
+        AllocationCounters direct;
+        AllocationTracker::Scope counting(direct, AllocPhase::OTHER, AllocComponent::OTHER);
+        AllocationStats before = fixtureAllocations(fixture, direct);
+        long long totalOps = 0;
+
+        auto runPasses = [&](long long passes) {
+            totalOps += passes * items;
+            auto start = std::chrono::steady_clock::now();
+            for (long long p = 0; p < passes; p++) {
+                for (size_t i = 0; i < items; i++) {
+                    op(i);
+                }
+            }
+            return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        };
+
+        long long passes = 1;
+        double elapsed = runPasses(passes);
+        while (elapsed < options.minSampleMillis * 1e6) {
+            passes *= 2;
+            elapsed = runPasses(passes);
+        }
+
+        result.opsPerSample = passes * items;
+        result.nsPerOp.push_back(elapsed / result.opsPerSample);
+        for (int s = 1; s < options.samples; s++) {
+            result.nsPerOp.push_back(runPasses(passes) / result.opsPerSample);
+        }
+
+        AllocationStats after = fixtureAllocations(fixture, direct);
+        result.allocsPerOp = (double)(after.allocations - before.allocations) / totalOps;
+        result.bytesPerOp = (double)(after.bytes - before.bytes) / totalOps;
+        return result;
+    }
+
+    double median(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        size_t mid = values.size() / 2;
+        return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2.0;
+    }
+
+    std::string commandOutput(const char* command)
+    {
+        std::string output;
+        if (FILE* pipe = popen(command, "r")) {
+            char line[128];
+            while (std::fgets(line, sizeof(line), pipe)) output += line;
+            pclose(pipe);
+        }
+        while (!output.empty() && (output.back() == '\n' || output.back() == '\r')) output.pop_back();
+        return output.empty() ? "unknown" : output;
+    }
+
+    void runFixture(Fixture& fixture, const BenchOptions& options, bool firstMasking,
+                    std::vector<BenchResult>& results)
+    {
+        int n = fixture.gridSize;
+        auto wanted = [&](const std::string& name) {
+            return options.filter.empty() || name.find(options.filter) != std::string::npos;
+        };
+
+        // Every cell, and the masked cells the inference rules are asked about
+        std::vector<std::tuple<int, int, int>> cells, maskedCells;
+        for (size_t b = 0; b < fixture.boards.size(); b++) {
+            for (int r = 0; r < n; r++) {
+                for (int c = 0; c < n; c++) {
+                    cells.push_back({(int)b, r, c});
+                    if (fixture.boards[b].getMasked()[r][c] == -1) {
+                        maskedCells.push_back({(int)b, r, c});
+                    }
+                }
+            }
+        }
+
+        auto add = [&](const std::string& name, size_t items, const std::function<void(size_t)>& op,
+                       double masking) {
+            if (!wanted(name) || items == 0) return;
+            results.push_back(measure(name, fixture, masking, items, options, op));
+            const BenchResult& r = results.back();
+            std::cout << std::left << std::setw(20) << r.name << std::right << std::setw(6) << r.gridSize
+                      << std::setw(9) << std::fixed << std::setprecision(2) << r.masking
+                      << std::setw(16) << std::setprecision(1) << median(r.nsPerOp)
+                      << std::setw(16) << *std::min_element(r.nsPerOp.begin(), r.nsPerOp.end())
+                      << std::setw(12) << r.opsPerSample;
+            if (AllocationTracker::installed()) {
+                std::cout << std::setw(12) << std::setprecision(2) << r.allocsPerOp << std::setw(12)
+                          << std::setprecision(0) << r.bytesPerOp;
+            }
+            std::cout << "\n";
+            std::cout.flush();
+        };
+
+        auto solverAt = [&](int b) -> PuzzleSolver& { return fixture.solvers[b]; };
+
+        add("is_valid", cells.size(), [&](size_t i) {
+            auto [b, r, c] = cells[i];
+            keep(solverAt(b).isValid(r, c));
+        }, fixture.masking);
+
+        // Viability checks may infer and reveal cells, so each board is restored before its
+        // first row (one rollback per n calls)
+        add("find_viable", fixture.boards.size() * n, [&](size_t i) {
+            if (i % n == 0) {
+                solverAt(i / n).restoreCheckpoint(fixture.pristine[i / n]);
+            }
+            keep(solverAt(i / n).findViableQueenPositions(i % n, n));
+        }, fixture.masking);
+
+        using Rule = int (*)(PuzzleSolver&, int, int);
+        std::vector<std::pair<const char*, Rule>> rules = {
+            {"infer_neighbours", SolverBench::inferNeighbours},
+            {"infer_uniformity", SolverBench::inferUniformity},
+            {"infer_domains", SolverBench::inferDomains},
+            {"infer_contiguity", SolverBench::inferContiguity},
+            {"infer_pattern", SolverBench::inferPattern},
+            {"infer_strict", SolverBench::inferStrict},
+        };
+        for (auto [name, rule] : rules) {
+            add(name, maskedCells.size(), [&, rule = rule](size_t i) {
+                auto [b, r, c] = maskedCells[i];
+                keep(rule(solverAt(b), r, c));
+            }, fixture.masking);
+        }
+
+        add("infer_weak", maskedCells.size(), [&](size_t i) {
+            auto [b, r, c] = maskedCells[i];
+            double confidence = 0.0;
+            keep(solverAt(b).inferWeak(r, c, confidence));
+        }, fixture.masking);
+
+        // Cascades reveal cells, so each op starts from the board as loaded (the trail
+        // rollback is part of the op)
+        add("inference_cascade", fixture.boards.size(), [&](size_t b) {
+            solverAt(b).restoreCheckpoint(fixture.pristine[b]);
+            solverAt(b).performInferenceCascade(n);
+        }, fixture.masking);
+
+        // Cold ranking of the first row's candidates, from an empty score cache
+        std::vector<std::vector<std::pair<int, int>>> firstRowViable;
+        for (size_t b = 0; b < fixture.boards.size(); b++) {
+            solverAt(b).restoreCheckpoint(fixture.pristine[b]);
+            firstRowViable.push_back(solverAt(b).findViableQueenPositions(0, n));
+        }
+        add("probe_selection", fixture.boards.size(), [&](size_t b) {
+            SolverBench::resetProbeQueue(solverAt(b), n);
+            keep(solverAt(b).findBestProbeSpots(2, firstRowViable[b]));
+        }, fixture.masking);
+
+        add("masked_solve", fixture.boards.size(), [&](size_t b) {
+            solverAt(b).resetToPristine();
+            keep(solverAt(b).solvePuzzle(n, 0.5));
+        }, fixture.masking);
+
+        // The complete-information solver ignores masking, so it runs once per size
+        if (firstMasking) {
+            add("csp_solve", fixture.boards.size(), [&](size_t b) {
+                CSPLinkedInSolver csp(fixture.boards[b]);
+                keep(csp.solve());
+            }, 0.0);
+        }
+
+        for (size_t b = 0; b < fixture.boards.size(); b++) {
+            solverAt(b).resetToPristine();
+        }
+    }
+
+    void writeJson(const std::string& path, const BenchOptions& options, const std::vector<BenchResult>& results)
+    {
+        std::ofstream out(path);
+        if (!out.is_open()) {
+            std::cerr << "Error: Could not open file " << path << " for writing.\n";
+            return;
+        }
+
+        time_t now = time(0);
+        char timestamp[32];
+        std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+#ifdef __OPTIMIZE__
+        bool optimized = true;
+#else
+        bool optimized = false;
+#endif
+
+        out << std::setprecision(6);
+        out << "{\n";
+        out << "  \"schema\": 1,\n";
+        out << "  \"commit\": \"" << commandOutput("git rev-parse --short HEAD 2>/dev/null") << "\",\n";
+        out << "  \"timestamp\": \"" << timestamp << "\",\n";
+        out << "  \"compiler\": \"" << __VERSION__ << "\",\n";
+        out << "  \"optimized\": " << (optimized ? "true" : "false") << ",\n";
+        out << "  \"instrumented\": " << (InstrumentationCounters::enabled ? "true" : "false") << ",\n";
+        out << "  \"alloc_tracked\": " << (AllocationTracker::installed() ? "true" : "false") << ",\n";
+        out << "  \"seed\": " << options.seed << ",\n";
+        out << "  \"puzzles_per_size\": " << options.puzzlesPerSize << ",\n";
+        out << "  \"samples\": " << options.samples << ",\n";
+        out << "  \"min_sample_ms\": " << options.minSampleMillis << ",\n";
+        out << "  \"results\": [";
+
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchResult& r = results[i];
+            double sum = 0.0;
+            for (double v : r.nsPerOp) sum += v;
+
+            out << (i ? "," : "") << "\n    {\"name\": \"" << r.name << "\", \"grid_size\": " << r.gridSize
+                << ", \"masking\": " << r.masking << ", \"boards\": " << r.boards
+                << ", \"ops_per_sample\": " << r.opsPerSample
+                << ", \"median_ns\": " << median(r.nsPerOp)
+                << ", \"min_ns\": " << *std::min_element(r.nsPerOp.begin(), r.nsPerOp.end())
+                << ", \"max_ns\": " << *std::max_element(r.nsPerOp.begin(), r.nsPerOp.end())
+                << ", \"mean_ns\": " << sum / r.nsPerOp.size();
+            if (AllocationTracker::installed()) {
+                out << ", \"allocs_per_op\": " << r.allocsPerOp << ", \"bytes_per_op\": " << r.bytesPerOp;
+            }
+            out << ", \"samples_ns\": [";
+            for (size_t s = 0; s < r.nsPerOp.size(); s++) {
+                out << (s ? ", " : "") << r.nsPerOp[s];
+            }
+            out << "]}";
+        }
+        out << "\n  ]\n}\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::ios::sync_with_stdio(false);
+    BenchOptions options = parseOptions(argc, argv);
+
+    // Enough of the corpus to fill every requested size
+    auto corpus = PuzzleManager::loadCorpus("puzzles.txt", 1000);
+
+    std::cout << std::left << std::setw(20) << "benchmark" << std::right << std::setw(6) << "size"
+              << std::setw(9) << "masking" << std::setw(16) << "median ns/op" << std::setw(16) << "min ns/op"
+              << std::setw(12) << "ops";
+    if (AllocationTracker::installed()) {
+        std::cout << std::setw(12) << "allocs/op" << std::setw(12) << "bytes/op";
+    }
+    std::cout << "\n";
+
+    std::vector<BenchResult> results;
+    for (int size : options.sizes) {
+        std::vector<std::shared_ptr<const PuzzleGrid>> boards;
+        for (const auto& grid : corpus) {
+            if ((int)grid->size() == size && (int)boards.size() < options.puzzlesPerSize) {
+                boards.push_back(grid);
+            }
+        }
+        if (boards.empty()) {
+            std::cerr << "No " << size << "x" << size << " boards in puzzles.txt, skipping\n";
+            continue;
+        }
+
+        for (size_t m = 0; m < options.maskings.size(); m++) {
+            Fixture fixture;
+            fixture.gridSize = size;
+            fixture.masking = options.maskings[m];
+            for (size_t b = 0; b < boards.size(); b++) {
+                fixture.boards.emplace_back(boards[b], fixture.masking, options.seed + b);
+            }
+            for (auto& board : fixture.boards) {
+                fixture.solvers.emplace_back(board);
+                SolverBench::resetProbeQueue(fixture.solvers.back(), size);
+                fixture.pristine.push_back(fixture.solvers.back().checkpoint());
+            }
+            runFixture(fixture, options, m == 0, results);
+        }
+    }
+
+    writeJson(options.outputPath, options, results);
+    std::cout << "\n✓ Benchmark results written to: " << options.outputPath << "\n";
+    return 0;
+}
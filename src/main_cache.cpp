@@ -0,0 +1,207 @@
+#include "../include/CSPLinkedInSolver.h"
+#include "../include/PuzzleManager.h"
+#include "../include/PuzzleSolver.h"
+#include "../include/SolutionCache.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Keeps solutions in a canonical-form cache (see SolutionCache.h), so a board that is a
+// rotation, reflection or recolouring of one already solved is answered without solving.
+//   build <cache.qsol> <puzzles.txt> [solutions.txt]   add every puzzle, taking the answer
+//                                                       from the ground truth when given and
+//                                                       solving with the CSP solver otherwise
+//   lookup <cache.qsol> <puzzles.txt>                  look every puzzle up, with timings
+//   report <puzzles.txt> [more.txt ...]                layouts shared within and across files
+// Exit status: 0 ok, 1 a lookup missed, 2 bad input.
+
+namespace {
+    const int maxPuzzles = 100000;
+
+    struct Puzzle
+    {
+        std::string file;
+        int number = 0;   // 1-based, as in solutions.txt
+        std::shared_ptr<const PuzzleGrid> grid;
+    };
+
+    std::vector<Puzzle> loadPuzzles(const std::string& file)
+    {
+        std::vector<Puzzle> puzzles;
+        auto corpus = PuzzleManager::loadCorpus(file, maxPuzzles);
+        for (size_t i = 0; i < corpus.size(); i++) {
+            puzzles.push_back({file, (int)i + 1, corpus[i]});
+        }
+        return puzzles;
+    }
+
+    double microsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void printTimings(const char* label, std::vector<double> micros)
+    {
+        if (micros.empty()) return;
+        std::sort(micros.begin(), micros.end());
+        double total = 0.0;
+        for (double m : micros) total += m;
+        std::cout << std::fixed << std::setprecision(2) << label << ": " << micros.size() << ", mean "
+                  << total / micros.size() << " us, p50 " << micros[micros.size() / 2] << " us, max "
+                  << micros.back() << " us\n";
+    }
+
+    // Groups puzzles by canonical board and prints every group with more than one member
+    void report(const std::vector<Puzzle>& puzzles)
+    {
+        std::map<std::pair<int, std::vector<uint8_t>>, std::vector<size_t>> groups;
+        for (size_t i = 0; i < puzzles.size(); i++) {
+            CanonicalBoard canonical = CanonicalBoard::of(*puzzles[i].grid);
+            groups[{canonical.size, canonical.cells}].push_back(i);
+        }
+
+        int exact = 0, symmetric = 0, shared = 0;
+        for (const auto& [key, members] : groups) {
+            if (members.size() < 2) continue;
+            shared++;
+            std::cout << "  " << key.first << "x" << key.first << ":";
+            for (size_t m = 0; m < members.size(); m++) {
+                const Puzzle& puzzle = puzzles[members[m]];
+                std::cout << " " << puzzle.file << "#" << puzzle.number;
+                if (m == 0) continue;
+                // Identical cells, or only the same up to symmetry and colour names
+                if (*puzzle.grid == *puzzles[members[0]].grid) exact++;
+                else symmetric++;
+            }
+            std::cout << "\n";
+        }
+        std::cout << puzzles.size() << " puzzles, " << groups.size() << " distinct layouts, " << shared
+                  << " shared by several puzzles: " << exact << " exact duplicates, " << symmetric
+                  << " rotated, reflected or recoloured\n";
+    }
+
+    int build(const std::string& cachePath, const std::string& puzzlesPath, const std::string& solutionsPath)
+    {
+        SolutionCache cache;
+        std::string error;
+        if (!cache.open(cachePath, error)) {
+            std::cerr << error << "\n";
+            return 2;
+        }
+        std::vector<Puzzle> puzzles = loadPuzzles(puzzlesPath);
+        if (puzzles.empty()) {
+            std::cerr << "no puzzles in " << puzzlesPath << "\n";
+            return 2;
+        }
+        std::map<int, std::vector<std::pair<int, int>>> groundTruth;
+        if (!solutionsPath.empty()) groundTruth = PuzzleSolver::loadSolutions(solutionsPath);
+
+        size_t before = cache.size();
+        int fromTruth = 0, solvedHere = 0;
+        std::vector<double> hitMicros, solveMicros;
+        for (const Puzzle& puzzle : puzzles) {
+            bool solved = false;
+            std::vector<std::pair<int, int>> queens;
+            auto start = std::chrono::steady_clock::now();
+            if (cache.lookup(*puzzle.grid, solved, queens)) {
+                hitMicros.push_back(microsSince(start));
+                continue;
+            }
+
+            // The ground truth lists failed puzzles with no positions
+            auto truth = groundTruth.find(puzzle.number);
+            if (truth != groundTruth.end()) {
+                queens = truth->second;
+                solved = !queens.empty();
+                fromTruth++;
+            } else {
+                start = std::chrono::steady_clock::now();
+                Graph graph(puzzle.grid, 0.0, 0u);
+                CSPLinkedInSolver solver(graph);
+                solved = solver.solve();
+                if (solved) queens = solver.getSolution();
+                solveMicros.push_back(microsSince(start));
+                solvedHere++;
+            }
+            cache.insert(*puzzle.grid, solved, queens);
+        }
+
+        if (!cache.save(cachePath, error)) {
+            std::cerr << error << "\n";
+            return 2;
+        }
+        std::cout << puzzles.size() << " puzzles: " << hitMicros.size() << " already cached, "
+                  << cache.size() - before << " added (" << fromTruth << " from ground truth, " << solvedHere
+                  << " solved); " << cache.size() << " in " << cachePath << "\n";
+        printTimings("cache hits", hitMicros);
+        printTimings("CSP solves", solveMicros);
+        report(puzzles);
+        return 0;
+    }
+
+    int lookup(const std::string& cachePath, const std::string& puzzlesPath)
+    {
+        SolutionCache cache;
+        std::string error;
+        if (!cache.open(cachePath, error)) {
+            std::cerr << error << "\n";
+            return 2;
+        }
+        std::vector<Puzzle> puzzles = loadPuzzles(puzzlesPath);
+        std::vector<double> micros;
+        for (const Puzzle& puzzle : puzzles) {
+            bool solved = false;
+            std::vector<std::pair<int, int>> queens;
+            auto start = std::chrono::steady_clock::now();
+            bool hit = cache.lookup(*puzzle.grid, solved, queens);
+            micros.push_back(microsSince(start));
+
+            std::cout << "Puzzle " << puzzle.number << ": " << (!hit ? "miss" : solved ? "solved" : "no solution");
+            for (const auto& [r, c] : queens) {
+                std::cout << " (" << r << "," << c << ")";
+            }
+            std::cout << "\n";
+        }
+        const SolutionCache::Stats& stats = cache.getStats();
+        std::cout << stats.hits << " hits, " << stats.misses << " misses\n";
+        printTimings("lookups", micros);
+        return stats.misses == 0 ? 0 : 1;
+    }
+
+    void usage()
+    {
+        std::cerr << "usage: cache.out build <cache.qsol> <puzzles.txt> [solutions.txt]\n"
+                  << "       cache.out lookup <cache.qsol> <puzzles.txt>\n"
+                  << "       cache.out report <puzzles.txt> [more.txt ...]\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string command = argc > 1 ? argv[1] : "";
+    if (command == "build" && (argc == 4 || argc == 5)) {
+        return build(argv[2], argv[3], argc == 5 ? argv[4] : "");
+    }
+    if (command == "lookup" && argc == 4) {
+        return lookup(argv[2], argv[3]);
+    }
+    if (command == "report" && argc >= 3) {
+        std::vector<Puzzle> puzzles;
+        for (int i = 2; i < argc; i++) {
+            std::vector<Puzzle> more = loadPuzzles(argv[i]);
+            puzzles.insert(puzzles.end(), more.begin(), more.end());
+        }
+        if (puzzles.empty()) {
+            std::cerr << "no puzzles\n";
+            return 2;
+        }
+        report(puzzles);
+        return 0;
+    }
+    usage();
+    return 2;
+}
@@ -0,0 +1,393 @@
+#include "../include/JsonValue.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Compares a baseline result set against a candidate and flags significant regressions.
+// Inputs are either bench.out JSON (per-sample ns/op for each benchmark) or the JSONL
+// records experiments.out writes with --results= (one line per puzzle).
+// Usage: ./compare.out <baseline> <candidate> [--threshold=5] [--confidence=0.95]
+//                      [--resamples=2000] [--seed=12345] [--metrics=solve_ms,probes_used,backtracks]
+// Exit status: 0 no regression, 1 at least one regression above the threshold, 2 bad input.
+
+namespace {
+    struct CompareOptions
+    {
+        double thresholdPercent = 5.0;
+        double confidence = 0.95;
+        int resamples = 2000;
+        unsigned int seed = 12345;
+        std::vector<std::string> metrics = {"solve_ms", "probes_used", "backtracks"};
+    };
+
+    // Observations of one metric for one benchmark or configuration. Per-puzzle values
+    // carry the puzzle number and masking seed so the two runs can be paired.
+    struct Series
+    {
+        std::vector<double> values;
+        std::vector<int> ids;
+        std::vector<long long> maskSeeds;   // -1 when the record has none
+    };
+
+    using SeriesKey = std::pair<std::string, std::string>;   // (benchmark or config, metric)
+
+    struct Comparison
+    {
+        std::string key;
+        std::string metric;
+        bool paired = false;
+        size_t observations = 0;
+        double baseline = 0.0;
+        double candidate = 0.0;
+        double deltaPercent = 0.0;
+        double lowPercent = 0.0;
+        double highPercent = 0.0;
+        double pValue = 1.0;
+        std::string verdict;
+    };
+
+    std::string formatKeyNumber(double value)
+    {
+        std::ostringstream text;
+        text << value;
+        return text.str();
+    }
+
+    // bench.out: {"results": [{"name", "grid_size", "masking", "samples_ns": [...]}, ...]}
+    void loadBench(const JsonValue& root, std::map<SeriesKey, Series>& series)
+    {
+        for (const JsonValue& result : root["results"].items()) {
+            std::string key = result["name"].asString() + " n=" + formatKeyNumber(result["grid_size"].asNumber()) +
+                              " m=" + formatKeyNumber(result["masking"].asNumber());
+            Series& s = series[{key, "time_ns"}];
+            for (const JsonValue& sample : result["samples_ns"].items()) {
+                s.values.push_back(sample.asNumber());
+            }
+        }
+    }
+
+    // JSONL: one object per line; puzzle records are grouped by run configuration
+    bool loadRecords(const std::string& path, const CompareOptions& options, std::map<SeriesKey, Series>& series)
+    {
+        std::ifstream in(path);
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(in, line)) {
+            lineNumber++;
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+            JsonValue record;
+            try {
+                record = JsonValue::parse(line);
+            } catch (const std::exception& error) {
+                std::cerr << path << ":" << lineNumber << ": " << error.what() << "\n";
+                return false;
+            }
+
+            if (record.has("record") && record["record"].asString() != "puzzle") continue;
+            if (!record.has("puzzle")) continue;
+
+            std::string key = "masking=" + formatKeyNumber(record["masking"].asNumber()) +
+                              " budget=" + formatKeyNumber(record["budget_percent"].asNumber()) +
+                              " " + record["strategy"].asString("heuristic");
+            for (const std::string& metric : options.metrics) {
+                if (!record[metric].isNumber()) continue;
+                Series& s = series[{key, metric}];
+                s.values.push_back(record[metric].asNumber());
+                s.ids.push_back((int)record["puzzle"].asNumber());
+                s.maskSeeds.push_back(record["mask_seed"].isNumber() ? (long long)record["mask_seed"].asNumber() : -1);
+            }
+        }
+        return true;
+    }
+
+    bool loadResults(const std::string& path, const CompareOptions& options, std::map<SeriesKey, Series>& series)
+    {
+        std::ifstream in(path);
+        if (!in.is_open()) {
+            std::cerr << "Error: Could not open " << path << "\n";
+            return false;
+        }
+        std::stringstream content;
+        content << in.rdbuf();
+
+        // A single document with "results" is a benchmark run; anything else is read as JSONL
+        try {
+            JsonValue root = JsonValue::parse(content.str());
+            if (root.isObject() && root["results"].isArray()) {
+                loadBench(root, series);
+                return true;
+            }
+        } catch (const std::exception&) {
+        }
+        return loadRecords(path, options, series);
+    }
+
+    double median(std::vector<double> values)
+    {
+        if (values.empty()) return 0.0;
+        std::sort(values.begin(), values.end());
+        size_t mid = values.size() / 2;
+        return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2.0;
+    }
+
+    double sum(const std::vector<double>& values)
+    {
+        double total = 0.0;
+        for (double v : values) total += v;
+        return total;
+    }
+
+    double percentile(std::vector<double> values, double p)
+    {
+        if (values.empty()) return 0.0;
+        std::sort(values.begin(), values.end());
+        double position = p * (values.size() - 1);
+        size_t low = (size_t)position;
+        size_t high = std::min(low + 1, values.size() - 1);
+        return values[low] + (position - low) * (values[high] - values[low]);
+    }
+
+    // Two-sided Mann-Whitney U test, normal approximation with tie correction
+    double mannWhitneyP(const std::vector<double>& a, const std::vector<double>& b)
+    {
+        size_t n1 = a.size(), n2 = b.size(), total = n1 + n2;
+        if (n1 == 0 || n2 == 0) return 1.0;
+
+        std::vector<std::pair<double, int>> pooled;
+        for (double v : a) pooled.push_back({v, 0});
+        for (double v : b) pooled.push_back({v, 1});
+        std::sort(pooled.begin(), pooled.end());
+
+        double rankSumA = 0.0, tieTerm = 0.0;
+        for (size_t i = 0; i < total;) {
+            size_t j = i;
+            while (j < total && pooled[j].first == pooled[i].first) j++;
+            double averageRank = (i + 1 + j) / 2.0;
+            for (size_t k = i; k < j; k++) {
+                if (pooled[k].second == 0) rankSumA += averageRank;
+            }
+            double ties = j - i;
+            tieTerm += ties * ties * ties - ties;
+            i = j;
+        }
+
+        double u = rankSumA - n1 * (n1 + 1) / 2.0;
+        double mean = n1 * n2 / 2.0;
+        double variance = n1 * n2 / 12.0 * ((total + 1) - tieTerm / ((double)total * (total - 1)));
+        if (variance <= 0.0) return 1.0;
+
+        double z = (std::fabs(u - mean) - 0.5) / std::sqrt(variance);
+        return std::erfc(std::max(0.0, z) / std::sqrt(2.0));
+    }
+
+    // Benchmark samples: unpaired, effect is the ratio of medians
+    Comparison compareUnpaired(const Series& base, const Series& cand, const CompareOptions& options, std::mt19937& rng)
+    {
+        Comparison c;
+        c.observations = std::min(base.values.size(), cand.values.size());
+        c.baseline = median(base.values);
+        c.candidate = median(cand.values);
+        c.deltaPercent = c.baseline > 0 ? (c.candidate / c.baseline - 1.0) * 100.0 : 0.0;
+        c.pValue = mannWhitneyP(base.values, cand.values);
+
+        std::vector<double> deltas;
+        std::vector<double> b(base.values.size()), k(cand.values.size());
+        std::uniform_int_distribution<size_t> pickBase(0, base.values.size() - 1), pickCand(0, cand.values.size() - 1);
+        for (int r = 0; r < options.resamples; r++) {
+            for (auto& v : b) v = base.values[pickBase(rng)];
+            for (auto& v : k) v = cand.values[pickCand(rng)];
+            double mb = median(b);
+            if (mb > 0) deltas.push_back((median(k) / mb - 1.0) * 100.0);
+        }
+        double tail = (1.0 - options.confidence) / 2.0;
+        c.lowPercent = percentile(deltas, tail);
+        c.highPercent = percentile(deltas, 1.0 - tail);
+        return c;
+    }
+
+    // A puzzle number names the same board in both runs only if both masked it with the
+    // same seed; records without a seed cannot show that
+    bool sameMasking(const Series& base, const Series& cand)
+    {
+        std::map<int, long long> candidateSeed;
+        for (size_t i = 0; i < cand.ids.size(); i++) candidateSeed[cand.ids[i]] = cand.maskSeeds[i];
+
+        for (size_t i = 0; i < base.ids.size(); i++) {
+            auto it = candidateSeed.find(base.ids[i]);
+            if (it == candidateSeed.end()) continue;
+            if (base.maskSeeds[i] < 0 || it->second != base.maskSeeds[i]) return false;
+        }
+        return true;
+    }
+
+    // Per-puzzle results: puzzles are matched by number and resampled together, effect is
+    // the ratio of totals (so puzzles with zero backtracks still count)
+    Comparison comparePaired(const Series& base, const Series& cand, const CompareOptions& options, std::mt19937& rng)
+    {
+        std::map<int, double> candidateById;
+        for (size_t i = 0; i < cand.ids.size(); i++) candidateById[cand.ids[i]] = cand.values[i];
+
+        std::vector<double> b, k;
+        for (size_t i = 0; i < base.ids.size(); i++) {
+            auto it = candidateById.find(base.ids[i]);
+            if (it != candidateById.end()) {
+                b.push_back(base.values[i]);
+                k.push_back(it->second);
+            }
+        }
+
+        Comparison c;
+        c.paired = true;
+        c.observations = b.size();
+        if (b.empty()) return c;
+
+        c.baseline = sum(b) / b.size();
+        c.candidate = sum(k) / k.size();
+        c.deltaPercent = sum(b) > 0 ? (sum(k) / sum(b) - 1.0) * 100.0 : 0.0;
+
+        std::vector<double> deltas;
+        std::uniform_int_distribution<size_t> pick(0, b.size() - 1);
+        for (int r = 0; r < options.resamples; r++) {
+            double sb = 0.0, sk = 0.0;
+            for (size_t i = 0; i < b.size(); i++) {
+                size_t j = pick(rng);
+                sb += b[j];
+                sk += k[j];
+            }
+            if (sb > 0) deltas.push_back((sk / sb - 1.0) * 100.0);
+        }
+
+        // Two-sided bootstrap p: how often the resampled effect lands on the other side of zero
+        if (!deltas.empty()) {
+            size_t above = std::count_if(deltas.begin(), deltas.end(), [](double d) { return d >= 0.0; });
+            size_t below = std::count_if(deltas.begin(), deltas.end(), [](double d) { return d <= 0.0; });
+            c.pValue = std::min(1.0, 2.0 * std::min(above, below) / deltas.size());
+        }
+        double tail = (1.0 - options.confidence) / 2.0;
+        c.lowPercent = percentile(deltas, tail);
+        c.highPercent = percentile(deltas, 1.0 - tail);
+        return c;
+    }
+
+    CompareOptions parseOptions(int argc, char* argv[], std::vector<std::string>& paths)
+    {
+        CompareOptions options;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.rfind("--", 0) != 0) {
+                paths.push_back(arg);
+                continue;
+            }
+            size_t eq = arg.find('=');
+            std::string key = arg.substr(0, eq);
+            std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+            if (key == "--threshold") options.thresholdPercent = std::stod(value);
+            else if (key == "--confidence") options.confidence = std::stod(value);
+            else if (key == "--resamples") options.resamples = std::max(100, std::stoi(value));
+            else if (key == "--seed") options.seed = std::stoul(value);
+            else if (key == "--metrics") {
+                options.metrics.clear();
+                std::stringstream parts(value);
+                std::string metric;
+                while (std::getline(parts, metric, ',')) {
+                    if (!metric.empty()) options.metrics.push_back(metric);
+                }
+            } else {
+                std::cerr << "Ignoring unknown option " << arg << "\n";
+            }
+        }
+        return options;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> paths;
+    CompareOptions options = parseOptions(argc, argv, paths);
+    if (paths.size() != 2) {
+        std::cerr << "Usage: " << argv[0] << " <baseline> <candidate> [--threshold=5] [--confidence=0.95] "
+                  << "[--resamples=2000] [--seed=12345] [--metrics=solve_ms,probes_used,backtracks]\n";
+        return 2;
+    }
+
+    std::map<SeriesKey, Series> baseline, candidate;
+    if (!loadResults(paths[0], options, baseline) || !loadResults(paths[1], options, candidate)) {
+        return 2;
+    }
+
+    std::mt19937 rng(options.seed);
+    std::vector<Comparison> comparisons;
+    std::string unpairedNoted;
+    for (const auto& [key, base] : baseline) {
+        auto it = candidate.find(key);
+        if (it == candidate.end() || base.values.empty() || it->second.values.empty()) continue;
+
+        bool paired = !base.ids.empty() && !it->second.ids.empty();
+        if (paired && !sameMasking(base, it->second)) {
+            if (key.first != unpairedNoted) {
+                std::cerr << "Note: " << key.first << ": the runs masked puzzles with different or unrecorded "
+                          << "seeds, comparing unpaired\n";
+                unpairedNoted = key.first;
+            }
+            paired = false;
+        }
+        Comparison c = paired ? comparePaired(base, it->second, options, rng)
+                              : compareUnpaired(base, it->second, options, rng);
+        c.key = key.first;
+        c.metric = key.second;
+
+        // Significant means the interval excludes zero and the test agrees; higher is worse
+        // for every metric compared here
+        bool significant = c.pValue < 1.0 - options.confidence && (c.lowPercent > 0.0 || c.highPercent < 0.0);
+        if (significant && c.deltaPercent > options.thresholdPercent) {
+            c.verdict = "REGRESSION";
+        } else if (significant && c.deltaPercent < -options.thresholdPercent) {
+            c.verdict = "improved";
+        } else if (significant) {
+            c.verdict = "within threshold";
+        } else {
+            c.verdict = "no change";
+        }
+        comparisons.push_back(c);
+    }
+
+    if (comparisons.empty()) {
+        std::cerr << "Error: the two result sets have no benchmark or configuration in common.\n";
+        return 2;
+    }
+
+    int confidencePercent = (int)std::lround(options.confidence * 100);
+    std::cout << std::left << std::setw(36) << "benchmark / configuration" << std::setw(14) << "metric"
+              << std::right << std::setw(6) << "n" << std::setw(14) << "baseline" << std::setw(14) << "candidate"
+              << std::setw(10) << "delta%" << std::setw(22) << (std::to_string(confidencePercent) + "% CI")
+              << std::setw(9) << "p" << "  verdict\n";
+
+    int regressions = 0;
+    for (const Comparison& c : comparisons) {
+        std::ostringstream interval;
+        interval << std::fixed << std::setprecision(1) << "[" << c.lowPercent << ", " << c.highPercent << "]";
+
+        std::cout << std::left << std::setw(36) << c.key << std::setw(14) << c.metric << std::right
+                  << std::setw(6) << c.observations << std::fixed << std::setprecision(2)
+                  << std::setw(14) << c.baseline << std::setw(14) << c.candidate
+                  << std::setprecision(1) << std::setw(10) << c.deltaPercent << std::setw(22) << interval.str()
+                  << std::setprecision(3) << std::setw(9) << c.pValue << "  " << c.verdict << "\n";
+        if (c.verdict == "REGRESSION") regressions++;
+    }
+
+    std::cout << std::defaultfloat << "\n" << comparisons.size() << " comparisons, " << regressions << " regression(s) above "
+              << options.thresholdPercent << "%\n";
+    std::cout << "Benchmarks: medians, bootstrap CI of the median ratio, Mann-Whitney p.\n";
+    std::cout << "Experiment records: means over puzzles present in both runs, paired bootstrap CI and p;\n"
+              << "runs masked with different seeds are compared like benchmarks.\n";
+    return regressions > 0 ? 1 : 0;
+}
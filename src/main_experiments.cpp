@@ -1,9 +1,18 @@
 #include "../include/PuzzleManager.h"
 #include "../include/PuzzleSolver.h"
+#include "../include/SolveScheduler.h"
+#include "../include/ResultSink.h"
+#include "../include/MetricsRegistry.h"
 #include <string>
+#include <memory>
+#include <chrono>
 #include <fstream>
 #include <iomanip>
 #include <ctime>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <filesystem>
 
 // Key: {Queen = 0, Masked = -1, Colour Square = 1 to N-Colours}
 
@@ -28,6 +37,7 @@ struct AggregateStatistics
     // Probe efficiency metrics
     int totalProbesUsed = 0;
     int totalProbeBudget = 0;
+    int totalProbesDiscarded = 0;            // answered but thrown away by speculative rollbacks
     double avgProbesUsed = 0.0;
     double avgProbeBudgetUtilization = 0.0;  // probesUsed / probeBudget
 
@@ -44,11 +54,55 @@ struct AggregateStatistics
     // Backtracking metrics
     int totalBacktracks = 0;
     double avgBacktracks = 0.0;
+    long long totalTranspositionLookups = 0;
+    long long totalTranspositionHits = 0;   // nodes skipped as known dead ends
+
+    // inferStrict's rules, summed over all puzzles
+    std::vector<InferenceRuleStats> inferenceRules;
 
     // Grid size info
     double avgGridSize = 0.0;
+
+    // Latency distributions, overall and per grid size
+    SolveLatency latency;
+    std::map<int, SolveLatency> latencyByGridSize;
+
+    // Hot-path counters summed over all puzzles (QUEENS_INSTRUMENT builds only)
+    InstrumentationCounters instrumentation;
+
+    // Hardware counters summed over the puzzles that captured them (--perf)
+    PerfCounts perf;
+    PerfCounts perfByPhase[(int)SolvePhase::COUNT];
+
+    // Heap activity summed over the puzzles, plus the run's own loading and reporting
+    // (ALLOC_TRACK builds only)
+    AllocationCounters allocations;
 };
 
+// Root coroutine for one puzzle in concurrent mode; metrics are recorded as each solve
+// finishes rather than when the results are reported after the whole batch
+Task<void> solveConcurrently(PuzzleSolver& solver, int n, double probeBudgetPercent,
+                             SolveScheduler& scheduler, char& solved, SolveMetrics* metrics,
+                             const ResultContext& context)
+{
+    solved = co_await solver.solvePuzzleAsync(n, probeBudgetPercent, scheduler);
+    if (metrics) {
+        metrics->record(solver.collectStatistics(0, solved, {}), context);
+        metrics->setQueueDepth(scheduler.queuedCount(), scheduler.runningCount() - 1);
+    }
+}
+
+// One file per traced solve, <dir>/<name>.qtrace; the directory is created on first use
+void saveTrace(const DecisionTrace& trace, const std::string& dir, const std::string& name)
+{
+    std::error_code ignored;
+    std::filesystem::create_directories(dir, ignored);
+    std::string path = dir + "/" + name + ".qtrace";
+    if (!trace.save(path)) {
+        std::cerr << "Error: Could not write trace " << path << "\n";
+    }
+}
+
 // Calculate aggregate statistics from individual puzzle stats
 AggregateStatistics calculateAggregateStats(const std::vector<PuzzleStatistics>& allStats)
 {
@@ -82,11 +136,30 @@ AggregateStatistics calculateAggregateStats(const std::vector<PuzzleStatistics>&
         // Accumulate other metrics
         agg.totalProbesUsed += stat.probesUsed;
         agg.totalProbeBudget += stat.probeBudget;
+        agg.totalProbesDiscarded += stat.probesDiscarded;
         agg.totalInferences += stat.inferences;
         agg.totalInitialMasked += stat.initialMaskedCells;
         agg.totalRevealed += stat.cellsRevealed;
         agg.totalBacktracks += stat.backtracks;
+        agg.totalTranspositionLookups += stat.transpositionLookups;
+        agg.totalTranspositionHits += stat.transpositionHits;
+        if (agg.inferenceRules.empty()) {
+            agg.inferenceRules = stat.inferenceRules;
+        } else {
+            for (size_t i = 0; i < stat.inferenceRules.size() && i < agg.inferenceRules.size(); i++) {
+                agg.inferenceRules[i].merge(stat.inferenceRules[i]);
+            }
+        }
         agg.avgGridSize += stat.gridSize;
+
+        agg.latency.record(stat);
+        agg.latencyByGridSize[stat.gridSize].record(stat);
+        agg.instrumentation.merge(stat.instrumentation);
+        agg.perf.add(stat.perf);
+        for (int p = 0; p < (int)SolvePhase::COUNT; p++) {
+            agg.perfByPhase[p].add(stat.perfByPhase[p]);
+        }
+        agg.allocations.merge(stat.allocations);
     }
 
     // Calculate averages and ratios
@@ -125,6 +198,114 @@ AggregateStatistics calculateAggregateStats(const std::vector<PuzzleStatistics>&
     return agg;
 }
 
+// Hot-path counters: calls, hit rate and time per instrumented function, then search
+// nodes per depth
+void writeInstrumentation(std::ostream& out, const InstrumentationCounters& counters)
+{
+    out << "--------------------------------------------------------------------------------\n";
+    out << "                      INSTRUMENTATION COUNTERS                                  \n";
+    out << "--------------------------------------------------------------------------------\n\n";
+
+    out << std::left << std::setw(20) << "Site" << std::right << std::setw(14) << "calls" << std::setw(10) << "hit%"
+        << std::setw(12) << "total ms" << std::setw(10) << "ns/call" << "\n";
+    for (int i = 0; i < InstrumentationCounters::siteCount; i++) {
+        InstrumentSite site = static_cast<InstrumentSite>(i);
+        uint64_t calls = counters.calls[i];
+        out << std::left << std::setw(20) << InstrumentationCounters::siteName(site) << std::right << std::setw(14) << calls;
+
+        if (InstrumentationCounters::countsHits(site) && calls > 0) {
+            out << std::setw(10) << (double)counters.hits[i] / calls * 100.0;
+        } else {
+            out << std::setw(10) << "-";
+        }
+        if (InstrumentationCounters::isTimed(site) && calls > 0) {
+            out << std::setw(12) << counters.nanos[i] / 1e6 << std::setw(10) << (double)counters.nanos[i] / calls;
+        } else {
+            out << std::setw(12) << "-" << std::setw(10) << "-";
+        }
+        out << "\n";
+    }
+
+    out << "\nSearch Nodes:                    " << counters.totalNodes() << "\n";
+    out << "Nodes per Depth:                ";
+    int deepest = InstrumentationCounters::maxDepth - 1;
+    while (deepest > 0 && counters.nodesAtDepth[deepest] == 0) deepest--;
+    for (int d = 0; d <= deepest; d++) {
+        out << " " << counters.nodesAtDepth[d];
+    }
+    out << "\n\n";
+}
+
+// Hardware event totals for the whole solve and per phase, with instructions per cycle
+void writePerfCounters(std::ostream& out, const AggregateStatistics& stats)
+{
+    out << "--------------------------------------------------------------------------------\n";
+    out << "                        HARDWARE COUNTERS                                       \n";
+    out << "--------------------------------------------------------------------------------\n\n";
+
+    out << std::left << std::setw(18) << "Phase" << std::right;
+    for (int e = 0; e < PerfCounts::eventCount; e++) {
+        PerfEvent event = static_cast<PerfEvent>(e);
+        if (stats.perf.has(event)) out << std::setw(16) << PerfCounts::eventName(event);
+    }
+    out << std::setw(8) << "IPC" << "\n";
+
+    auto row = [&](const std::string& name, const PerfCounts& counts) {
+        out << std::left << std::setw(18) << name << std::right;
+        for (int e = 0; e < PerfCounts::eventCount; e++) {
+            PerfEvent event = static_cast<PerfEvent>(e);
+            if (stats.perf.has(event)) out << std::setw(16) << counts.get(event);
+        }
+        long long cycles = counts.get(PerfEvent::CYCLES);
+        bool hasIpc = stats.perf.has(PerfEvent::CYCLES) && stats.perf.has(PerfEvent::INSTRUCTIONS) && cycles > 0;
+        if (hasIpc) {
+            out << std::setw(8) << (double)counts.get(PerfEvent::INSTRUCTIONS) / cycles;
+        } else {
+            out << std::setw(8) << "-";
+        }
+        out << "\n";
+    };
+
+    row("solve", stats.perf);
+    for (int p = 0; p < (int)SolvePhase::COUNT; p++) {
+        row(solvePhaseName(static_cast<SolvePhase>(p)), stats.perfByPhase[p]);
+    }
+    out << "  (User-space events of the solving thread; missing columns were unavailable)\n\n";
+}
+
+// Allocation count, bytes and peak live heap per phase and per component, with counts per
+// puzzle
+void writeAllocations(std::ostream& out, const AggregateStatistics& stats)
+{
+    out << "--------------------------------------------------------------------------------\n";
+    out << "                          HEAP ALLOCATIONS                                      \n";
+    out << "--------------------------------------------------------------------------------\n\n";
+
+    int puzzles = std::max(1, stats.totalPuzzles);
+    auto header = [&](const char* label) {
+        out << std::left << std::setw(18) << label << std::right << std::setw(14) << "allocs" << std::setw(14)
+            << "allocs/puzzle" << std::setw(16) << "bytes" << std::setw(14) << "frees" << std::setw(14)
+            << "peak KiB" << "\n";
+    };
+    auto row = [&](const std::string& name, const AllocationStats& counts) {
+        out << std::left << std::setw(18) << name << std::right << std::setw(14) << counts.allocations
+            << std::setw(14) << (double)counts.allocations / puzzles << std::setw(16) << counts.bytes
+            << std::setw(14) << counts.frees << std::setw(14) << counts.peakLiveBytes / 1024.0 << "\n";
+    };
+
+    header("Phase");
+    row("total", stats.allocations.total());
+    for (int p = 0; p < AllocationCounters::phaseCount; p++) {
+        row(AllocationCounters::phaseName(static_cast<AllocPhase>(p)), stats.allocations.byPhase[p]);
+    }
+    out << "\n";
+    header("Component");
+    for (int c = 0; c < AllocationCounters::componentCount; c++) {
+        row(AllocationCounters::componentName(static_cast<AllocComponent>(c)), stats.allocations.byComponent[c]);
+    }
+    out << "  (Peaks are the largest live heap of a single puzzle or of the run's own work)\n\n";
+}
+
 // Write aggregate statistics to a text file (append mode)
 void writeStatisticsToFile(const std::string& filename, const AggregateStatistics& stats,
                            const std::string& configDescription,
@@ -192,6 +373,11 @@ void writeStatisticsToFile(const std::string& filename, const AggregateStatistic
 
     outFile << "Total Probes Used:               " << stats.totalProbesUsed << " / "
             << stats.totalProbeBudget << " (budget)\n";
+    if (stats.totalProbesDiscarded > 0) {
+        outFile << "Discarded by Rollbacks:          " << stats.totalProbesDiscarded << "\n";
+        outFile << "Total Probes Charged:            " << stats.totalProbesUsed + stats.totalProbesDiscarded
+                << " / " << stats.totalProbeBudget << " (budget)\n";
+    }
     outFile << "Average Probes per Puzzle:       " << stats.avgProbesUsed << "\n";
     outFile << "Probe Budget Utilization:        " << stats.avgProbeBudgetUtilization << "%\n";
     outFile << "  (Percentage of allocated probe budget actually used)\n\n";
@@ -223,7 +409,62 @@ void writeStatisticsToFile(const std::string& filename, const AggregateStatistic
     outFile << "--------------------------------------------------------------------------------\n\n";
 
     outFile << "Total Backtracks:                " << stats.totalBacktracks << "\n";
-    outFile << "Average Backtracks per Puzzle:   " << stats.avgBacktracks << "\n\n";
+    outFile << "Average Backtracks per Puzzle:   " << stats.avgBacktracks << "\n";
+    outFile << "Known Dead Ends Skipped:         " << stats.totalTranspositionHits << " of "
+            << stats.totalTranspositionLookups << " nodes looked up ("
+            << (stats.totalTranspositionLookups > 0
+                    ? (double)stats.totalTranspositionHits / stats.totalTranspositionLookups * 100.0 : 0.0)
+            << "%)\n\n";
+
+    if (!stats.inferenceRules.empty()) {
+        outFile << "--------------------------------------------------------------------------------\n";
+        outFile << "                      INFERENCE RULE METRICS                                    \n";
+        outFile << "--------------------------------------------------------------------------------\n\n";
+
+        outFile << std::left << std::setw(14) << "Rule" << std::right << std::setw(12) << "Runs" << std::setw(12)
+                << "Yield %" << std::setw(12) << "Agreed" << std::setw(12) << "Skipped" << std::setw(12) << "ms"
+                << "\n";
+        for (const InferenceRuleStats& rule : stats.inferenceRules) {
+            outFile << std::left << std::setw(14) << rule.name << std::right << std::setw(12) << rule.calls
+                    << std::setw(12) << (rule.calls > 0 ? (double)rule.yields / rule.calls * 100.0 : 0.0)
+                    << std::setw(12) << rule.agreed << std::setw(12) << rule.skipped << std::setw(12) << rule.millis
+                    << "\n";
+        }
+        outFile << "  (Skipped: evaluations settled before the rule's turn)\n\n";
+    }
+
+    outFile << "--------------------------------------------------------------------------------\n";
+    outFile << "                         LATENCY METRICS (ms)                                   \n";
+    outFile << "--------------------------------------------------------------------------------\n\n";
+
+    outFile << std::left << std::setw(20) << "Phase" << std::right << std::setw(10) << "p50" << std::setw(10) << "p90"
+            << std::setw(10) << "p99" << std::setw(10) << "max" << std::setw(10) << "mean" << "\n";
+    for (auto [name, histogram] : stats.latency.phases()) {
+        outFile << std::left << std::setw(20) << name << std::right << std::setw(10) << histogram->percentile(50)
+                << std::setw(10) << histogram->percentile(90) << std::setw(10) << histogram->percentile(99)
+                << std::setw(10) << histogram->max() << std::setw(10) << histogram->mean() << "\n";
+    }
+    outFile << "  (Solve time split by phase; masking happens before the solve and is not part of it)\n\n";
+
+    outFile << std::left << std::setw(20) << "Grid Size" << std::right << std::setw(10) << "p50" << std::setw(10) << "p90"
+            << std::setw(10) << "p99" << std::setw(10) << "max" << std::setw(10) << "puzzles" << "\n";
+    for (const auto& [gridSize, latency] : stats.latencyByGridSize) {
+        std::string label = std::to_string(gridSize) + " x " + std::to_string(gridSize);
+        outFile << std::left << std::setw(20) << label << std::right << std::setw(10) << latency.solve.percentile(50)
+                << std::setw(10) << latency.solve.percentile(90) << std::setw(10) << latency.solve.percentile(99)
+                << std::setw(10) << latency.solve.max() << std::setw(10) << latency.solve.count() << "\n";
+    }
+    outFile << "\n";
+
+    if (InstrumentationCounters::enabled) {
+        writeInstrumentation(outFile, stats.instrumentation);
+    }
+    if (stats.perf.captured()) {
+        writePerfCounters(outFile, stats);
+    }
+    if (AllocationTracker::installed()) {
+        writeAllocations(outFile, stats);
+    }
 
     outFile << "--------------------------------------------------------------------------------\n";
     outFile << "                         GENERAL INFORMATION                                    \n";
@@ -240,8 +481,306 @@ void writeStatisticsToFile(const std::string& filename, const AggregateStatistic
     std::cout << "\n✓ Statistics written to: " << filename << "\n";
 }
 
+// One point of a sweep grid
+struct SweepConfig
+{
+    double maskingPercent = 0.0;
+    double probeBudgetPercent = 0.0;
+    ProbeStrategy strategy = ProbeStrategy::LOCAL_HEURISTIC;
+};
+
+// "0.1,0.3,0.5" lists values; "0.1:0.5:0.1" is an inclusive start:end:step range
+std::vector<double> parseSweepValues(const std::string& spec)
+{
+    std::vector<double> values;
+    if (spec.find(':') != std::string::npos) {
+        std::stringstream parts(spec);
+        std::string start, end, step;
+        std::getline(parts, start, ':');
+        std::getline(parts, end, ':');
+        std::getline(parts, step, ':');
+
+        double from = std::stod(start), to = std::stod(end), by = std::stod(step);
+        for (int i = 0; by > 0 && from + i * by <= to + by * 1e-6; i++) {
+            values.push_back(from + i * by);
+        }
+        return values;
+    }
+
+    std::stringstream parts(spec);
+    std::string value;
+    while (std::getline(parts, value, ',')) {
+        if (!value.empty()) values.push_back(std::stod(value));
+    }
+    return values;
+}
+
+std::string strategyName(ProbeStrategy strategy)
+{
+    return strategy == ProbeStrategy::MONTE_CARLO ? "montecarlo" : "heuristic";
+}
+
+std::vector<ProbeStrategy> parseSweepStrategies(const std::string& spec)
+{
+    std::vector<ProbeStrategy> strategies;
+    std::stringstream parts(spec);
+    std::string name;
+    while (std::getline(parts, name, ',')) {
+        if (name == "montecarlo") {
+            strategies.push_back(ProbeStrategy::MONTE_CARLO);
+        } else if (name == "heuristic") {
+            strategies.push_back(ProbeStrategy::LOCAL_HEURISTIC);
+        }
+    }
+    return strategies;
+}
+
+// Sweep mode: every (masking, budget, strategy) point over the same corpus in one process.
+// Boards and solutions are loaded once, each masking level is applied once with a fixed
+// seed (so every budget and strategy sees identical boards), and all (config, puzzle)
+// jobs are spread over worker threads.
+// Usage: ./experiments.out sweep <maskings> <budgets> [strategies] [numPuzzles] [outputFile] [threads] [seed]
+//        [--results=file.jsonl|file.csv] writes every (config, puzzle) record as well
+//        [--perf] adds hardware counters to those records
+//        [--trace=dir] [--trace-ring=events] writes a decision trace per (config, puzzle)
+//        [--metrics=file.prom] [--metrics-interval=seconds] keeps OpenMetrics text up to date
+//        [--params=file] solves with the constants in file, e.g. from tune.out
+//        [--mask-seed=n] stands in for [seed] when it is not given
+int runSweep(int argc, char* argv[], const OutputOptions& output, const SolverParameters& parameters)
+{
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " sweep <maskings> <budgets> [heuristic,montecarlo] "
+                  << "[numPuzzles] [outputFile] [threads] [seed]\n";
+        return 1;
+    }
+
+    std::vector<double> maskings = parseSweepValues(argv[2]);
+    std::vector<double> budgets = parseSweepValues(argv[3]);
+    std::vector<ProbeStrategy> strategies = parseSweepStrategies(argc >= 5 ? argv[4] : "heuristic");
+    int numPuzzles = argc >= 6 ? std::stoi(argv[5]) : 100;
+    std::string outputFileName = argc >= 7 ? argv[6] : "sweep_results.txt";
+    int numThreads = argc >= 8 ? std::stoi(argv[7]) : 0;
+    unsigned int seed = argc >= 9 ? std::stoul(argv[8]) : output.maskSeedGiven ? output.maskSeed : 12345u;
+
+    if (numThreads <= 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (maskings.empty() || budgets.empty() || strategies.empty()) {
+        std::cerr << "Error: empty sweep grid.\n";
+        return 1;
+    }
+
+    auto corpus = PuzzleManager::loadCorpus("puzzles.txt", numPuzzles);
+    auto solutionsPos = PuzzleSolver::loadSolutions("solutions.txt");
+
+    std::vector<std::vector<Graph>> maskedCorpus(maskings.size());
+    for (size_t m = 0; m < maskings.size(); m++) {
+        PuzzleManager::maskCorpus(corpus, maskedCorpus[m], maskings[m], seed);
+    }
+
+    std::vector<SweepConfig> configs;
+    std::vector<size_t> configMasking;
+    for (size_t m = 0; m < maskings.size(); m++) {
+        for (double budget : budgets) {
+            for (ProbeStrategy strategy : strategies) {
+                configs.push_back({maskings[m], budget, strategy});
+                configMasking.push_back(m);
+            }
+        }
+    }
+
+    size_t puzzleCount = corpus.size();
+    size_t totalJobs = configs.size() * puzzleCount;
+    std::vector<PuzzleStatistics> results(totalJobs);
+    std::vector<double> solveSeconds(totalJobs, 0.0);
+
+    std::cout << "Sweep: " << maskings.size() << " masking x " << budgets.size() << " budget x "
+              << strategies.size() << " strategy points over " << puzzleCount << " puzzles ("
+              << totalJobs << " solves on " << numThreads << " threads)\n";
+
+    if (output.perfCounters) {
+        PerfCounterGroup probe;
+        if (!probe.available()) {
+            std::cout << "Hardware counters unavailable (" << probe.unavailableReason() << "), continuing without them\n";
+        }
+    }
+
+    // The file is rewritten in the background while the workers run, and once more at the end
+    std::unique_ptr<SolveMetrics> metrics;
+    std::unique_ptr<MetricsTextfile> metricsFile;
+    if (!output.metricsPath.empty()) {
+        metrics.reset(new SolveMetrics());
+        metrics->setQueueDepth(totalJobs, 0);
+        metricsFile.reset(new MetricsTextfile(metrics->getRegistry(), output.metricsPath,
+                                              output.metricsIntervalSeconds));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> nextJob{0};
+    std::atomic<int> runningJobs{0};
+    auto worker = [&]() {
+        // Counters are per thread, so every worker opens its own
+        std::unique_ptr<PerfCounterGroup> perf;
+        if (output.perfCounters) {
+            perf.reset(new PerfCounterGroup());
+        }
+
+        for (size_t job = nextJob++; job < totalJobs; job = nextJob++) {
+            size_t c = job / puzzleCount;
+            size_t p = job % puzzleCount;
+            const SweepConfig& config = configs[c];
+
+            // Each job solves its own copy of the masked board; the original is shared
+            Graph board = maskedCorpus[configMasking[c]][p];
+            PuzzleSolver solver(board);
+            solver.setParameters(parameters);
+            solver.setPerfCounters(perf.get());
+            if (config.strategy == ProbeStrategy::MONTE_CARLO) {
+                solver.setProbeStrategy(config.strategy, 256, 1);
+            }
+            std::unique_ptr<DecisionTrace> trace;
+            if (!output.traceDir.empty()) {
+                trace.reset(new DecisionTrace(output.traceRingEvents));
+                trace->setPuzzleNumber(p + 1);
+                solver.setDecisionTrace(trace.get());
+            }
+
+            runningJobs++;
+            auto jobStart = std::chrono::steady_clock::now();
+            bool solved = solver.solvePuzzle(board.getSize(), config.probeBudgetPercent);
+            solveSeconds[job] = std::chrono::duration<double>(std::chrono::steady_clock::now() - jobStart).count();
+
+            int puzzleNumber = p + 1;
+            if (trace) {
+                std::ostringstream name;
+                name << "m" << config.maskingPercent << "_b" << config.probeBudgetPercent << "_"
+                     << strategyName(config.strategy) << "_puzzle_" << puzzleNumber;
+                saveTrace(*trace, output.traceDir, name.str());
+            }
+            std::vector<std::pair<int, int>> correctPositions;
+            auto it = solutionsPos.find(puzzleNumber);
+            if (it != solutionsPos.end()) {
+                correctPositions = it->second;
+            }
+            results[job] = solver.collectStatistics(puzzleNumber, solved, correctPositions);
+            runningJobs--;
+
+            if (metrics) {
+                ResultContext context;
+                context.maskingPercent = config.maskingPercent;
+                context.probeBudgetPercent = config.probeBudgetPercent;
+                context.strategy = strategyName(config.strategy);
+                context.maskSeed = seed;
+                metrics->record(results[job], context);
+                metrics->setQueueDepth(totalJobs - std::min(nextJob.load(), totalJobs), runningJobs);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < numThreads; t++) {
+        workers.emplace_back(worker);
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    metricsFile.reset();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::ostringstream table;
+    table << std::fixed << std::setprecision(2);
+    table << std::left << std::setw(9) << "masking" << std::setw(9) << "budget" << std::setw(12) << "strategy"
+          << std::right << std::setw(8) << "solved" << std::setw(10) << "success%" << std::setw(10) << "correct%"
+          << std::setw(10) << "probes" << std::setw(8) << "util%" << std::setw(10) << "infer"
+          << std::setw(12) << "backtracks" << std::setw(10) << "ms/solve" << std::setw(10) << "p50ms"
+          << std::setw(10) << "p90ms" << std::setw(10) << "p99ms" << std::setw(10) << "maxms" << "\n";
+
+    std::vector<AggregateStatistics> aggregates;
+
+    for (size_t c = 0; c < configs.size(); c++) {
+        std::vector<PuzzleStatistics> slice(results.begin() + c * puzzleCount,
+                                            results.begin() + (c + 1) * puzzleCount);
+        aggregates.push_back(calculateAggregateStats(slice));
+        const AggregateStatistics& agg = aggregates.back();
+
+        double seconds = 0.0;
+        for (size_t p = 0; p < puzzleCount; p++) {
+            seconds += solveSeconds[c * puzzleCount + p];
+        }
+
+        const SweepConfig& config = configs[c];
+        table << std::left << std::setw(9) << config.maskingPercent << std::setw(9) << config.probeBudgetPercent
+              << std::setw(12) << strategyName(config.strategy)
+              << std::right << std::setw(8) << agg.solvedPuzzles << std::setw(10) << agg.successRate
+              << std::setw(10) << agg.avgCorrectnessAll << std::setw(10) << agg.avgProbesUsed
+              << std::setw(8) << agg.avgProbeBudgetUtilization << std::setw(10) << agg.avgInferences
+              << std::setw(12) << agg.avgBacktracks
+              << std::setw(10) << (puzzleCount > 0 ? seconds / puzzleCount * 1000.0 : 0.0)
+              << std::setw(10) << agg.latency.solve.percentile(50) << std::setw(10) << agg.latency.solve.percentile(90)
+              << std::setw(10) << agg.latency.solve.percentile(99) << std::setw(10) << agg.latency.solve.max() << "\n";
+    }
+
+    std::cout << "\n" << table.str() << "\n";
+    std::cout << "Sweep finished in " << std::fixed << std::setprecision(2) << elapsed << " s\n";
+
+    std::ofstream outFile(outputFileName);
+    if (!outFile.is_open()) {
+        std::cerr << "Error: Could not open file " << outputFileName << " for writing.\n";
+        return 1;
+    }
+    outFile << "# Sweep over " << puzzleCount << " puzzles, masking seed " << seed << "\n";
+    outFile << table.str();
+    std::cout << "\n✓ Sweep results written to: " << outputFileName << "\n";
+
+    if (!output.resultsPath.empty()) {
+        ResultSink sink(output.resultsPath);
+        for (size_t job = 0; job < totalJobs; job++) {
+            const SweepConfig& config = configs[job / puzzleCount];
+            ResultContext context;
+            context.maskingPercent = config.maskingPercent;
+            context.probeBudgetPercent = config.probeBudgetPercent;
+            context.strategy = strategyName(config.strategy);
+            context.maskSeed = seed;
+            sink.write(results[job], context);
+        }
+        for (size_t c = 0; c < configs.size(); c++) {
+            ResultContext context;
+            context.maskingPercent = configs[c].maskingPercent;
+            context.probeBudgetPercent = configs[c].probeBudgetPercent;
+            context.strategy = strategyName(configs[c].strategy);
+            context.maskSeed = seed;
+            sink.writeLatency(aggregates[c].latency, context, 0);
+            for (const auto& [gridSize, latency] : aggregates[c].latencyByGridSize) {
+                sink.writeLatency(latency, context, gridSize);
+            }
+        }
+        std::cout << "✓ Per-puzzle records written to: " << output.resultsPath << "\n";
+    }
+    if (!output.traceDir.empty()) {
+        std::cout << "✓ Decision traces written to: " << output.traceDir << "/\n";
+    }
+    if (metrics) {
+        std::cout << "✓ Metrics written to: " << output.metricsPath << "\n";
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[])
 {
+    std::ios::sync_with_stdio(false);
+    OutputOptions output = extractOutputOptions(argc, argv);
+
+    SolverParameters parameters;
+    std::string parametersError;
+    if (!output.parametersPath.empty() && !parameters.load(output.parametersPath, parametersError)) {
+        std::cerr << "Error: " << parametersError << "\n";
+        return 1;
+    }
+
+    if (argc >= 2 && std::string(argv[1]) == "sweep") {
+        return runSweep(argc, argv, output, parameters);
+    }
+
     // Configuration parameters (can be passed as command line args)
     int numPuzzles = 100;
     double maskingPercentage = 0.3;      // 30% by default
@@ -250,9 +789,18 @@ int main(int argc, char* argv[])
     std::string solutionsFileName = "solutions.txt";
     std::string outputFileName = "all_experiments.txt";  // Append to same file
     std::string configDescription = "";
+    ProbeStrategy probeStrategy = ProbeStrategy::LOCAL_HEURISTIC;
+    double probeLatencyMs = 0.0;
+    bool speculative = false;            // false = wait for every probe
+    int concurrency = 0;                 // 0 = solve puzzles one after another
+    double poolReserve = 0.0;            // 0 = every puzzle keeps its own budget
 
     // Allow command line arguments for customization
-    // Usage: ./experiments.out [numPuzzles] [maskingPercent] [probeBudgetPercent] [outputFile]
+    // Usage: ./experiments.out [numPuzzles] [maskingPercent] [probeBudgetPercent] [outputFile] [heuristic|montecarlo] [probeLatencyMs] [speculative 0|1] [concurrency] [poolReserve]
+    //        [--results=file.jsonl|file.csv] [--verbosity=0|1|2] [--perf]
+    //        [--trace=dir] [--trace-ring=events] (replay with ./replay.out dir/puzzle_<n>.qtrace)
+    //        [--metrics=file.prom] [--metrics-interval=seconds] [--params=file]
+    //        [--mask-seed=n] masks puzzle i with n + i - 1 (default: a random seed, printed and recorded)
     if (argc >= 2) {
         numPuzzles = std::stoi(argv[1]);
     }
@@ -265,11 +813,29 @@ int main(int argc, char* argv[])
     if (argc >= 5) {
         outputFileName = argv[4];
     }
+    if (argc >= 6 && std::string(argv[5]) == "montecarlo") {
+        probeStrategy = ProbeStrategy::MONTE_CARLO;
+    }
+    if (argc >= 7) {
+        probeLatencyMs = std::stod(argv[6]);
+    }
+    if (argc >= 8) {
+        speculative = std::stoi(argv[7]) > 0;
+    }
+    if (argc >= 9) {
+        concurrency = std::stoi(argv[8]);
+    }
+    if (argc >= 10) {
+        poolReserve = std::stod(argv[9]);
+    }
 
     // Generate description if not provided
     if (configDescription.empty()) {
         configDescription = "Masking: " + std::to_string((int)(maskingPercentage * 100)) + "%, " +
-                          "Probe Budget: " + std::to_string((int)(probeBudgetPercent * 100)) + "%";
+                          "Probe Budget: " + std::to_string((int)(probeBudgetPercent * 100)) + "%" +
+                          (probeStrategy == ProbeStrategy::MONTE_CARLO ? ", Probe Selection: Monte Carlo" : "") +
+                          (poolReserve > 0 ? ", Pooled Budget Reserve: " + std::to_string((int)(poolReserve * 100)) + "%" : "") +
+                          (output.parametersPath.empty() ? "" : ", Parameters: " + output.parametersPath);
     }
 
     std::cout << "================================================================================\n";
@@ -278,11 +844,21 @@ int main(int argc, char* argv[])
     std::cout << "Configuration: " << configDescription << "\n";
     std::cout << "Loading " << numPuzzles << " puzzles from " << puzzleFileName << "...\n";
     std::cout << "Masking: " << (maskingPercentage * 100) << "%, Probe Budget: " << (probeBudgetPercent * 100) << "%\n";
+    if (probeLatencyMs > 0) {
+        std::cout << "Simulated probe latency: " << probeLatencyMs << " ms per request\n";
+    }
+
+    // Work outside any single puzzle (loading, solver setup, result records) is charged to
+    // the run; each puzzle's masking, solve and statistics go to its own record
+    AllocationCounters runAllocations;
+    AllocationTracker::Scope run(runAllocations, AllocPhase::OTHER, AllocComponent::OTHER);
 
-    // Load puzzles with specified masking percentage
+    // Load puzzles with specified masking percentage; the seed goes into every record, so
+    // compare.out only pairs puzzles that two runs masked alike
     std::vector<Graph> graphs;
-    PuzzleManager::loadFromFile(puzzleFileName, numPuzzles, graphs, maskingPercentage);
-    std::cout << "✓ Loaded " << graphs.size() << " puzzles\n";
+    PuzzleManager::maskCorpus(PuzzleManager::loadCorpus(puzzleFileName, numPuzzles), graphs,
+                              maskingPercentage, output.maskSeed);
+    std::cout << "✓ Loaded " << graphs.size() << " puzzles (masking seed " << output.maskSeed << ")\n";
 
     // Load solutions
     auto solutionsPos = PuzzleSolver::loadSolutions(solutionsFileName);
@@ -294,16 +870,119 @@ int main(int argc, char* argv[])
     // Storage for all puzzle statistics
     std::vector<PuzzleStatistics> allStatistics;
 
+    auto probeLatency = std::chrono::microseconds((long long)(probeLatencyMs * 1000));
+
+    // With a reserve, every puzzle keeps only part of its budget and the rest is shared
+    ProbeBudgetPool budgetPool(poolReserve);
+
+    std::vector<std::unique_ptr<PuzzleSolver>> solvers;
+    {
+        AllocationTracker::Scope setup(AllocPhase::LOADING, AllocComponent::SOLVER);
+        for (auto &g : graphs) {
+            solvers.emplace_back(new PuzzleSolver(g));
+            solvers.back()->setParameters(parameters);
+            solvers.back()->setProbeStrategy(probeStrategy);
+            if (poolReserve > 0) {
+                solvers.back()->setProbeBudgetPool(&budgetPool);
+                budgetPool.expect(solvers.back()->fairProbeShare(probeBudgetPercent));
+            }
+        }
+    }
+
+    // Hardware counters are opened for this thread, which runs every solve in both modes.
+    // Concurrent solves share the group; each counts only its own slices between suspensions
+    std::unique_ptr<PerfCounterGroup> perfGroup;
+    if (output.perfCounters) {
+        perfGroup.reset(new PerfCounterGroup());
+        if (perfGroup->available()) {
+            for (auto& solver : solvers) {
+                solver->setPerfCounters(perfGroup.get());
+            }
+        } else {
+            std::cout << "Hardware counters unavailable (" << perfGroup->unavailableReason()
+                      << "), continuing without them\n";
+        }
+    }
+
+    // Decision traces are kept until the puzzle's result is reported, then written out
+    std::vector<std::unique_ptr<DecisionTrace>> traces(solvers.size());
+    if (!output.traceDir.empty()) {
+        for (size_t i = 0; i < solvers.size(); i++) {
+            traces[i].reset(new DecisionTrace(output.traceRingEvents));
+            traces[i]->setPuzzleNumber(i + 1);
+            solvers[i]->setDecisionTrace(traces[i].get());
+        }
+    }
+
+    ResultContext context;
+    context.maskingPercent = maskingPercentage;
+    context.probeBudgetPercent = probeBudgetPercent;
+    context.strategy = strategyName(probeStrategy);
+    context.maskSeed = output.maskSeed;
+
+    std::unique_ptr<SolveMetrics> metrics;
+    std::unique_ptr<MetricsTextfile> metricsFile;
+    if (!output.metricsPath.empty()) {
+        metrics.reset(new SolveMetrics());
+        metrics->setQueueDepth(graphs.size(), 0);
+        metricsFile.reset(new MetricsTextfile(metrics->getRegistry(), output.metricsPath,
+                                              output.metricsIntervalSeconds));
+    }
+
+    // In concurrent mode every puzzle is a coroutine on one scheduler, and all simulated
+    // oracles share a single delivery thread
+    DelayedDelivery sharedDelivery;
+    std::vector<std::unique_ptr<SimulatedProbeOracle>> oracles;
+    std::vector<char> solvedFlags(graphs.size(), 0);
+
+    if (concurrency > 0) {
+        // Interleaved solves hand the thread back in whatever order they finish, so the
+        // run's context is put back once all of them are done
+        AllocationTracker::Scope scheduling(AllocPhase::OTHER, AllocComponent::OTHER);
+        SolveScheduler scheduler(concurrency);
+        for (size_t i = 0; i < graphs.size(); i++) {
+            oracles.emplace_back(new SimulatedProbeOracle(graphs[i].getOriginal(), probeLatency, &sharedDelivery));
+            solvers[i]->setProbeOracle(oracles.back().get());
+            scheduler.spawn(solveConcurrently(*solvers[i], graphs[i].getSize(), probeBudgetPercent,
+                                              scheduler, solvedFlags[i], metrics.get(), context));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        scheduler.run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "Solved " << scheduler.completedCount() << " puzzles concurrently in "
+                  << std::fixed << std::setprecision(2) << seconds << " s (peak in flight: "
+                  << scheduler.peakConcurrency() << ", suspensions: " << scheduler.suspensionCount() << ")\n";
+    }
+
+    std::unique_ptr<ResultSink> sink;
+    if (!output.resultsPath.empty()) {
+        sink.reset(new ResultSink(output.resultsPath));
+    }
+
     int puzzleNumber = 1;
-    for (auto &g : graphs)
+    for (size_t i = 0; i < graphs.size(); i++)
     {
-        std::cout << "Puzzle " << std::setw(3) << puzzleNumber << "/" << numPuzzles << " ... ";
-        std::cout.flush();
+        PuzzleSolver& solver = *solvers[i];
+
+        if (output.verbosity != Verbosity::QUIET) {
+            std::cout << "Puzzle " << std::setw(3) << puzzleNumber << "/" << numPuzzles << " ... ";
+            std::cout.flush();
+        }
 
-        PuzzleSolver solver(g);
-        bool solved = solver.solvePuzzle(g.getSize(), probeBudgetPercent);
+        bool solved = solvedFlags[i];
+        if (concurrency <= 0) {
+            solver.setProbeLatency(probeLatency);
+            solver.setSpeculativeProbing(speculative);
+            if (metrics) {
+                metrics->setQueueDepth(graphs.size() - i - 1, 1);
+            }
+            solved = solver.solvePuzzle(graphs[i].getSize(), probeBudgetPercent);
+        }
 
         // Collect statistics
+        AllocationTracker::Scope reporting(AllocPhase::REPORTING, AllocComponent::OTHER);
         std::vector<std::pair<int, int>> correctPositions;
         if (solutionsPos.find(puzzleNumber) != solutionsPos.end()) {
             correctPositions = solutionsPos[puzzleNumber];
@@ -311,26 +990,69 @@ int main(int argc, char* argv[])
 
         PuzzleStatistics stats = solver.collectStatistics(puzzleNumber, solved, correctPositions);
         allStatistics.push_back(stats);
+        if (metrics && concurrency <= 0) {
+            metrics->record(stats, context);
+            metrics->setQueueDepth(graphs.size() - i - 1, 0);
+        }
+        if (sink) {
+            sink->write(stats, context);
+        }
+        if (traces[i]) {
+            saveTrace(*traces[i], output.traceDir, "puzzle_" + std::to_string(puzzleNumber));
+            solver.setDecisionTrace(nullptr);
+            traces[i].reset();
+        }
 
-        if (solved) {
-            std::cout << "SOLVED";
-        } else {
-            std::cout << "FAILED";
+        if (output.verbosity != Verbosity::QUIET) {
+            if (solved) {
+                std::cout << "SOLVED";
+            } else {
+                std::cout << "FAILED";
+            }
+
+            std::cout << " (Q:" << stats.queensPlaced << "/" << stats.expectedQueens
+                      << " P:" << stats.probesUsed << "/" << stats.probeBudget
+                      << " I:" << stats.inferences
+                      << " C:" << std::fixed << std::setprecision(0) << (stats.correctnessScore * 100) << "%)\n";
         }
 
-        std::cout << " (Q:" << stats.queensPlaced << "/" << stats.expectedQueens
-                  << " P:" << stats.probesUsed << "/" << stats.probeBudget
-                  << " I:" << stats.inferences
-                  << " C:" << std::fixed << std::setprecision(0) << (stats.correctnessScore * 100) << "%)\n";
+        if (output.verbosity == Verbosity::BOARDS) {
+            std::cout << "Final Masked:\n";
+            graphs[i].printGraph(Graph::MASKED);
+            std::cout << "Current:\n";
+            graphs[i].printGraph(Graph::CURRENT_SYMBOLS);
+        }
 
         puzzleNumber++;
     }
 
+    if (!output.traceDir.empty()) {
+        std::cout << "✓ Decision traces written to: " << output.traceDir << "/\n";
+    }
+    if (metrics) {
+        metricsFile.reset();
+        std::cout << "✓ Metrics written to: " << output.metricsPath << "\n";
+    }
+
+    if (poolReserve > 0) {
+        std::cout << "Budget pool: " << budgetPool.grantedCount() << " probes granted from the reserve, "
+                  << budgetPool.returnedCount() << " returned unspent, " << budgetPool.deniedCount()
+                  << " probes refused, " << budgetPool.reserveRemaining() << " left over\n";
+    }
+
     std::cout << "--------------------------------------------------------------------------------\n";
     std::cout << "All puzzles processed. Calculating aggregate statistics...\n";
 
     // Calculate aggregate statistics
     AggregateStatistics aggStats = calculateAggregateStats(allStatistics);
+    aggStats.allocations.merge(runAllocations);
+
+    if (sink) {
+        sink->writeLatency(aggStats.latency, context, 0);
+        for (const auto& [gridSize, latency] : aggStats.latencyByGridSize) {
+            sink->writeLatency(latency, context, gridSize);
+        }
+    }
 
     // Write to file (append mode with test identifiers)
     writeStatisticsToFile(outputFileName, aggStats, configDescription,
@@ -347,9 +1069,14 @@ int main(int argc, char* argv[])
     std::cout << "Failed Puzzle Correctness:   " << aggStats.failedPuzzleCorrectness << "%\n";
     std::cout << "Probe Budget Utilization:    " << aggStats.avgProbeBudgetUtilization << "%\n";
     std::cout << "Probe-to-Inference Ratio:    1:" << aggStats.probeInferenceRatio << "\n";
-    std::cout << "Cells Revealed:              " << aggStats.avgRevealPercentage << "% of masked\n\n";
+    std::cout << "Cells Revealed:              " << aggStats.avgRevealPercentage << "% of masked\n";
+    std::cout << "Solve Latency (ms):          p50 " << aggStats.latency.solve.percentile(50)
+              << ", p90 " << aggStats.latency.solve.percentile(90)
+              << ", p99 " << aggStats.latency.solve.percentile(99)
+              << ", max " << aggStats.latency.solve.max() << "\n\n";
 
     // Cleanup
+    solvers.clear();
     graphs.clear();
 
     std::cout << "Experiment complete!\n";
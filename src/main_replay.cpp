@@ -0,0 +1,323 @@
+#include "../include/DecisionTrace.h"
+#include "../include/PuzzleSolver.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Summarizes a decision trace written by experiments.out --trace=<dir>: where the time,
+// placements and backtracks went per search depth, and which source (given cell, probe,
+// inference rule, weak guess) the colours of failed placements came from. --verify solves
+// the recorded starting board again and checks every decision matches.
+// Usage: ./replay.out <trace.qtrace> [--verify] [--events]
+// Exit status: 0 ok, 1 the replay diverged from the trace, 2 bad input.
+
+namespace {
+    struct DepthSummary
+    {
+        double millis = 0.0;
+        long long places = 0;
+        long long undos = 0;
+        long long prunes = 0;
+        long long probes = 0;
+        long long inferences = 0;
+    };
+
+    // Where the colour a queen was placed on came from
+    enum Source { GIVEN, PROBED, INFERRED, GUESSED, SOURCE_COUNT };
+
+    struct SourceSummary
+    {
+        long long inferences = 0;   // rules only: inferences the rule agreed with
+        long long sole = 0;         // ... and that no other rule backed
+        long long places = 0;
+        long long undos = 0;
+        double subtreeMillis = 0.0; // from each placement to its undo, or the end of the trace
+    };
+
+    const char* ruleNames[traceRuleCount] = {"neighbours", "uniformity", "domains", "contiguity", "pattern"};
+    const char* sourceNames[SOURCE_COUNT] = {"given", "probe", "inference", "weak guess"};
+    const char* pruneNames[] = {"empty row", "unknown colour", "colour taken", "attacked", "known dead end"};
+
+    struct Placement
+    {
+        Source source = GIVEN;
+        int rules = 0;
+        double placedAt = 0.0;
+    };
+
+    struct CellOrigin
+    {
+        Source source = GIVEN;
+        int rules = 0;
+    };
+
+    void printEvent(size_t index, const TraceEvent& event, double atMillis)
+    {
+        std::cout << std::setw(8) << index << std::setw(12) << std::fixed << std::setprecision(4) << atMillis
+                  << "  " << std::left << std::setw(7) << TraceEvent::kindName(event.kind()) << std::right
+                  << " row " << std::setw(3) << event.rowIndex() << " col " << std::setw(3) << event.colIndex()
+                  << " value " << std::setw(3) << event.valueIndex() << " flags " << event.flags() << "\n";
+    }
+
+    void summarize(const DecisionTrace& trace, bool listEvents)
+    {
+        const TraceHeader& header = trace.getHeader();
+        std::vector<TraceEvent> events = trace.orderedEvents();
+        int n = header.gridSize;
+
+        std::vector<DepthSummary> depths(n + 1);
+        SourceSummary sources[SOURCE_COUNT];
+        SourceSummary rules[traceRuleCount];
+        long long pruneReasons[tracePruneCount] = {};
+        std::vector<std::vector<CellOrigin>> origin(n, std::vector<CellOrigin>(n));
+        for (int r = 0; r < n; r++) {
+            for (int c = 0; c < n; c++) {
+                if (header.masked[r][c] == -1) origin[r][c].source = GUESSED;
+            }
+        }
+        std::vector<Placement> placed(n);
+        std::vector<bool> occupied(n, false);
+
+        auto closePlacement = [&](int row, double now, bool undone) {
+            if (row < 0 || row >= n || !occupied[row]) return;
+            occupied[row] = false;
+            const Placement& p = placed[row];
+            double subtree = now - p.placedAt;
+            sources[p.source].subtreeMillis += subtree;
+            sources[p.source].undos += undone;
+            for (int b = 0; b < traceRuleCount; b++) {
+                if (p.rules & (1 << b)) {
+                    rules[b].subtreeMillis += subtree;
+                    rules[b].undos += undone;
+                }
+            }
+        };
+
+        // Time before an event is charged to the depth the search was at until then
+        int depth = 0;
+        double now = 0.0;
+        bool solved = false;
+        for (size_t i = 0; i < events.size(); i++) {
+            const TraceEvent& event = events[i];
+            double delta = event.deltaNanos / 1e6;
+            now += delta;
+            depths[std::min(depth, n)].millis += delta;
+            if (listEvents) printEvent(i, event, now);
+
+            int row = event.rowIndex(), col = event.colIndex();
+            bool onBoard = row >= 0 && row < n && col >= 0 && col < n;
+            switch (event.kind()) {
+                case TraceEventKind::PROBE:
+                    depths[std::min(depth, n)].probes++;
+                    if (onBoard) origin[row][col] = {PROBED, 0};
+                    break;
+                case TraceEventKind::INFER: {
+                    depths[std::min(depth, n)].inferences++;
+                    int mask = event.flags();
+                    if (onBoard) origin[row][col] = {INFERRED, mask};
+                    for (int b = 0; b < traceRuleCount; b++) {
+                        if (mask & (1 << b)) {
+                            rules[b].inferences++;
+                            if (mask == (1 << b)) rules[b].sole++;
+                        }
+                    }
+                    break;
+                }
+                case TraceEventKind::PLACE:
+                    if (!onBoard) break;
+                    depths[row].places++;
+                    placed[row] = {origin[row][col].source, origin[row][col].rules, now};
+                    occupied[row] = true;
+                    sources[placed[row].source].places++;
+                    for (int b = 0; b < traceRuleCount; b++) {
+                        if (placed[row].rules & (1 << b)) rules[b].places++;
+                    }
+                    depth = row + 1;
+                    break;
+                case TraceEventKind::UNDO:
+                    if (row < 0 || row >= n) break;
+                    depths[row].undos++;
+                    closePlacement(row, now, true);
+                    depth = row;
+                    break;
+                case TraceEventKind::PRUNE:
+                    if (row < 0 || row >= n) break;
+                    depths[row].prunes++;
+                    pruneReasons[std::min(event.flags(), tracePruneCount - 1)]++;
+                    depth = row;
+                    break;
+                case TraceEventKind::REVERT:
+                    if (!onBoard) break;
+                    if (event.flags() & TRACE_REVERT_QUEEN) {
+                        if (event.valueIndex() == -1) closePlacement(row, now, false);
+                    } else if (event.valueIndex() == -1) {
+                        origin[row][col] = {GUESSED, 0};
+                    }
+                    break;
+                case TraceEventKind::END:
+                    solved = event.value == 1;
+                    break;
+                default:
+                    break;
+            }
+        }
+        for (int row = 0; row < n; row++) {
+            closePlacement(row, now, false);
+        }
+
+        std::cout << std::fixed;
+        std::cout << "Puzzle " << header.puzzleNumber << ", " << n << "x" << n << ", probe budget "
+                  << header.probeBudget << " (" << std::setprecision(0) << header.probeBudgetPercent * 100 << "%), "
+                  << (header.strategy == (int)ProbeStrategy::MONTE_CARLO ? "monte carlo" : "heuristic") << " probes"
+                  << (header.speculative ? ", speculative" : "") << (header.pooledBudget ? ", pooled budget" : "")
+                  << (header.concurrent ? ", concurrent" : "") << "\n";
+        std::cout << events.size() << " events over " << std::setprecision(3) << now << " ms, "
+                  << (solved ? "solved" : "not solved") << "\n";
+        if (header.droppedEvents > 0) {
+            std::cout << "Ring buffer: the first " << header.droppedEvents
+                      << " events were overwritten, totals cover the rest only\n";
+        }
+        SolverParameters defaults;
+        for (int i = 0; i < SolverParameters::fieldCount; i++) {
+            if (header.parameters.get(i) != defaults.get(i)) {
+                std::cout << "Parameter " << SolverParameters::fields[i].name << " = " << std::setprecision(4)
+                          << header.parameters.get(i) << " (default " << defaults.get(i) << ")\n";
+            }
+        }
+        if (header.concurrent) {
+            std::cout << "Concurrent solve: times include other solves that ran while this one waited\n";
+        }
+
+        std::cout << "\n" << std::setw(6) << "depth" << std::setw(12) << "ms" << std::setw(8) << "time%"
+                  << std::setw(10) << "places" << std::setw(12) << "backtracks" << std::setw(10) << "prunes"
+                  << std::setw(10) << "probes" << std::setw(12) << "inferences" << "\n";
+        for (int d = 0; d <= n; d++) {
+            const DepthSummary& s = depths[d];
+            if (s.millis == 0.0 && s.places + s.undos + s.prunes + s.probes + s.inferences == 0) continue;
+            std::cout << std::setw(6) << d << std::setw(12) << std::setprecision(3) << s.millis << std::setw(8)
+                      << std::setprecision(1) << (now > 0 ? s.millis / now * 100.0 : 0.0) << std::setw(10)
+                      << s.places << std::setw(12) << s.undos << std::setw(10) << s.prunes << std::setw(10)
+                      << s.probes << std::setw(12) << s.inferences << "\n";
+        }
+
+        std::cout << "\n" << std::left << std::setw(22) << "colour source" << std::right << std::setw(12)
+                  << "inferences" << std::setw(8) << "sole" << std::setw(10) << "places" << std::setw(12)
+                  << "backtracks" << std::setw(14) << "subtree ms" << "\n";
+        auto sourceRow = [&](const std::string& name, const SourceSummary& s, bool isRule) {
+            std::cout << std::left << std::setw(22) << name << std::right;
+            if (isRule) {
+                std::cout << std::setw(12) << s.inferences << std::setw(8) << s.sole;
+            } else {
+                std::cout << std::setw(12) << "-" << std::setw(8) << "-";
+            }
+            std::cout << std::setw(10) << s.places << std::setw(12) << s.undos << std::setw(14)
+                      << std::setprecision(3) << s.subtreeMillis << "\n";
+        };
+        for (int s = 0; s < SOURCE_COUNT; s++) {
+            sourceRow(sourceNames[s], sources[s], false);
+        }
+        for (int b = 0; b < traceRuleCount; b++) {
+            sourceRow(std::string("  rule ") + ruleNames[b], rules[b], true);
+        }
+        std::cout << "  (An inference backed by several rules counts for each of them)\n";
+
+        std::cout << "\nPrunes:";
+        for (int r = 0; r < tracePruneCount; r++) {
+            std::cout << (r ? ", " : " ") << pruneNames[r] << " " << pruneReasons[r];
+        }
+        std::cout << "\n";
+    }
+
+    // Solves the recorded starting board again with the recorded settings, tracing the
+    // replay, and compares decisions (not times). Returns false on the first difference.
+    bool verify(const DecisionTrace& recorded)
+    {
+        const TraceHeader& header = recorded.getHeader();
+        if (header.speculative || header.pooledBudget) {
+            std::cout << "Note: " << (header.speculative ? "speculative probing" : "a pooled budget")
+                      << " depends on timing or on other puzzles, the replay may diverge\n";
+        }
+
+        Graph board(std::make_shared<const PuzzleGrid>(header.original), header.masked);
+        PuzzleSolver solver(board);
+        solver.setProbeStrategy(static_cast<ProbeStrategy>(header.strategy), header.beliefSamples,
+                                header.beliefThreads, header.beliefSeed);
+        solver.setSpeculativeProbing(header.speculative);
+        solver.setParameters(header.parameters);
+        DecisionTrace replay;
+        solver.setDecisionTrace(&replay);
+
+        auto start = std::chrono::steady_clock::now();
+        solver.solvePuzzle(header.gridSize, header.probeBudgetPercent);
+        double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // A ring trace only kept the end of the run, so it is lined up with the replay's end
+        std::vector<TraceEvent> expected = recorded.orderedEvents();
+        std::vector<TraceEvent> actual = replay.orderedEvents();
+        auto skipTime = [](std::vector<TraceEvent>& events) {
+            events.erase(std::remove_if(events.begin(), events.end(),
+                                        [](const TraceEvent& e) { return e.kind() == TraceEventKind::TIME; }),
+                         events.end());
+        };
+        skipTime(expected);
+        skipTime(actual);
+        size_t offset = 0;
+        if (header.droppedEvents > 0 && actual.size() >= expected.size()) {
+            offset = actual.size() - expected.size();
+        }
+
+        std::cout << "\nReplay: " << actual.size() << " events in " << std::fixed << std::setprecision(3)
+                  << millis << " ms\n";
+        size_t compared = std::min(expected.size(), actual.size() - std::min(offset, actual.size()));
+        for (size_t i = 0; i < compared; i++) {
+            if (!expected[i].sameDecision(actual[offset + i])) {
+                std::cout << "DIVERGED at event " << i << ":\n  recorded";
+                printEvent(i, expected[i], 0.0);
+                std::cout << "  replayed";
+                printEvent(offset + i, actual[offset + i], 0.0);
+                return false;
+            }
+        }
+        if (header.droppedEvents == 0 && expected.size() != actual.size()) {
+            std::cout << "DIVERGED: recorded " << expected.size() << " events, replay " << actual.size() << "\n";
+            return false;
+        }
+        std::cout << "Replay matches the trace (" << compared << " decisions)\n";
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string path;
+    bool verifyReplay = false;
+    bool listEvents = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--verify") == 0) verifyReplay = true;
+        else if (std::strcmp(argv[i], "--events") == 0) listEvents = true;
+        else if (path.empty()) path = argv[i];
+        else std::cerr << "Ignoring unknown option " << argv[i] << "\n";
+    }
+    if (path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <trace.qtrace> [--verify] [--events]\n";
+        return 2;
+    }
+
+    DecisionTrace trace;
+    std::string error;
+    if (!trace.load(path, error)) {
+        std::cerr << "Error: " << error << "\n";
+        return 2;
+    }
+
+    summarize(trace, listEvents);
+    if (verifyReplay && !verify(trace)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "../include/SolveServer.h"
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// Keeps solver threads running and answers boards as they arrive, so a single puzzle costs a
+// solve rather than a process start. Boards use the puzzles.txt format, so
+//     ./server.out < puzzles.txt
+// solves a whole file, and with --socket=<path> any number of clients can connect, e.g.
+//     ./server.out --socket=/tmp/queens.sock &
+//     socat - UNIX-CONNECT:/tmp/queens.sock < board.txt
+// Each board gets one JSON line back: {"id", "size", "solved", "queens" (column per row, -1
+// for none), "probes", "probe_budget", "inferences", "backtracks", "queue_ms", "setup_ms",
+// "solve_ms", "total_ms"}, or {"id", "error"}. Sending STATS returns the server's counters.
+// Usage: ./server.out [--socket=path] [--workers=N] [--queue=N] [--masking=0.3] [--budget=0.5]
+//                     [--strategy=heuristic|montecarlo] [--seed=N]
+
+int main(int argc, char* argv[])
+{
+    // A client that disconnects early must not take the server down with it
+    std::signal(SIGPIPE, SIG_IGN);
+
+    ServerOptions options;
+    std::string socketPath;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--socket=", 9) == 0) {
+            socketPath = argv[i] + 9;
+        } else if (std::strncmp(argv[i], "--workers=", 10) == 0) {
+            options.workers = std::atoi(argv[i] + 10);
+        } else if (std::strncmp(argv[i], "--queue=", 8) == 0) {
+            options.queueLimit = std::atoi(argv[i] + 8);
+        } else if (std::strncmp(argv[i], "--masking=", 10) == 0) {
+            options.maskingPercent = std::atof(argv[i] + 10);
+        } else if (std::strncmp(argv[i], "--budget=", 9) == 0) {
+            options.probeBudgetPercent = std::atof(argv[i] + 9);
+        } else if (std::strcmp(argv[i], "--strategy=montecarlo") == 0) {
+            options.strategy = ProbeStrategy::MONTE_CARLO;
+        } else if (std::strcmp(argv[i], "--strategy=heuristic") == 0) {
+            options.strategy = ProbeStrategy::LOCAL_HEURISTIC;
+        } else if (std::strncmp(argv[i], "--seed=", 7) == 0) {
+            options.seed = std::strtoul(argv[i] + 7, nullptr, 10);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--socket=path] [--workers=N] [--queue=N] [--masking=0.3] "
+                      << "[--budget=0.5] [--strategy=heuristic|montecarlo] [--seed=N]\n";
+            return 2;
+        }
+    }
+
+    SolveServer server(options);
+    // Responses go to stdout, so the banner goes to stderr
+    std::cerr << "Solve server: " << server.workerCount() << " workers, masking "
+              << options.maskingPercent * 100 << "%, probe budget " << options.probeBudgetPercent * 100 << "%, "
+              << (socketPath.empty() ? std::string("reading stdin") : "listening on " + socketPath) << "\n";
+
+    if (socketPath.empty()) {
+        server.serve(0, 1);
+        return 0;
+    }
+    return server.listenUnix(socketPath) ? 0 : 1;
+}
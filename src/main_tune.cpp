@@ -0,0 +1,325 @@
+#include "../include/PuzzleManager.h"
+#include "../include/PuzzleSolver.h"
+#include "../include/SolverParameters.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Tunes the solver's constants (see SolverParameters.h) by successive halving. Candidates
+// are drawn around the starting configuration and across each field's range, and all of
+// them solve the same few masked boards. The best third go on to three times as many
+// boards, until one is left. A share of the corpus is held out of the rounds; the winner
+// and the starting configuration are scored on it, and the better of the two there is
+// written out for --params=<file>.
+//
+// The cost of a configuration is lower for better results:
+//   fail * (1 - solve rate) + probes * mean(probes used / masked cells)
+//       + backtracks * mean(log(1 + backtracks))
+// Every board is masked once with a fixed seed, and the (candidate, board) solves are
+// spread over worker threads. Solves are cut off after a number of search nodes rather than
+// a time, so a run's choices do not depend on the machine or how busy it is.
+//
+// Usage: ./tune.out [numPuzzles] [maskingPercent] [probeBudgetPercent] [outputFile] [candidates] [threads] [seed]
+//        [--start=file] starts from saved parameters instead of the defaults
+//        [--objective=fail,probes,backtracks] weights of the cost terms (default 10,1,0.1)
+//        [--node-limit=nodes] search nodes per solve (default 200000); a solve that runs out has failed
+//        [--holdout=share] share of the puzzles kept out of tuning to score the result (default 0.25)
+
+namespace {
+    const int eta = 3;   // one candidate in eta survives each round
+
+    struct Objective
+    {
+        double fail = 10.0;
+        double probes = 1.0;
+        double backtracks = 0.1;
+    };
+
+    struct Outcome
+    {
+        bool evaluated = false;
+        bool solved = false;
+        double probeShare = 0.0;   // probes used / masked cells
+        long long backtracks = 0;
+    };
+
+    struct Candidate
+    {
+        SolverParameters parameters;
+        std::vector<Outcome> outcomes;   // by position in the shuffled corpus
+        double cost = 0.0;
+    };
+
+    struct Totals
+    {
+        int solved = 0;
+        double probeShare = 0.0;
+        double backtracks = 0.0;
+    };
+
+    // Puzzles are positions [begin, end) in the shuffled corpus
+    Totals totals(const Candidate& candidate, size_t begin, size_t end)
+    {
+        Totals sum;
+        for (size_t p = begin; p < end; p++) {
+            const Outcome& outcome = candidate.outcomes[p];
+            sum.solved += outcome.solved;
+            sum.probeShare += outcome.probeShare;
+            sum.backtracks += outcome.backtracks;
+        }
+        return sum;
+    }
+
+    double cost(const Candidate& candidate, size_t begin, size_t end, const Objective& objective)
+    {
+        double failed = 0.0, probes = 0.0, backtracks = 0.0;
+        for (size_t p = begin; p < end; p++) {
+            const Outcome& outcome = candidate.outcomes[p];
+            failed += !outcome.solved;
+            probes += outcome.probeShare;
+            backtracks += std::log1p((double)outcome.backtracks);
+        }
+        return (objective.fail * failed + objective.probes * probes + objective.backtracks * backtracks) / (end - begin);
+    }
+
+    // Local candidates move every field by about a tenth of its range; the others
+    // are uniform over the ranges
+    SolverParameters sample(const SolverParameters& start, bool local, std::mt19937& rng)
+    {
+        SolverParameters drawn = start;
+        for (int i = 0; i < SolverParameters::fieldCount; i++) {
+            const SolverParameters::Field& field = SolverParameters::fields[i];
+            double span = field.max - field.min;
+            if (local) {
+                std::normal_distribution<double> step(0.0, 0.1 * span);
+                drawn.set(i, start.get(i) + step(rng));
+            } else {
+                std::uniform_real_distribution<double> anywhere(field.min, field.max);
+                drawn.set(i, anywhere(rng));
+            }
+        }
+        return drawn;
+    }
+
+    // Solves every board in [begin, end) that the given candidates have not solved yet
+    void evaluate(std::vector<Candidate>& candidates, const std::vector<size_t>& which, size_t begin, size_t end,
+                  const std::vector<Graph>& boards, const std::vector<size_t>& order, double probeBudgetPercent,
+                  uint32_t nodeLimit, int numThreads)
+    {
+        std::vector<std::pair<size_t, size_t>> jobs;
+        for (size_t c : which) {
+            for (size_t p = begin; p < end; p++) {
+                if (!candidates[c].outcomes[p].evaluated) jobs.push_back({c, p});
+            }
+        }
+
+        std::atomic<size_t> nextJob{0};
+        auto worker = [&]() {
+            for (size_t job = nextJob++; job < jobs.size(); job = nextJob++) {
+                auto [c, p] = jobs[job];
+                Graph board = boards[order[p]];
+                PuzzleSolver solver(board);
+                solver.setParameters(candidates[c].parameters);
+                solver.setNodeLimit(nodeLimit);
+                bool solved = solver.solvePuzzle(board.getSize(), probeBudgetPercent);
+
+                PuzzleStatistics stats = solver.collectStatistics(order[p] + 1, solved, {});
+                Outcome& outcome = candidates[c].outcomes[p];
+                outcome.solved = solved && !stats.timedOut;
+                outcome.probeShare = stats.initialMaskedCells > 0
+                                         ? (double)stats.probesUsed / stats.initialMaskedCells : 0.0;
+                outcome.backtracks = stats.backtracks;
+                outcome.evaluated = true;
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (int t = 1; t < numThreads; t++) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void printResult(const char* label, const Candidate& candidate, size_t begin, size_t end,
+                     const Objective& objective)
+    {
+        Totals sum = totals(candidate, begin, end);
+        size_t puzzles = end - begin;
+        std::cout << std::left << std::setw(10) << label << std::right << std::fixed << std::setprecision(4)
+                  << "cost " << cost(candidate, begin, end, objective) << ", solved " << sum.solved << "/" << puzzles
+                  << std::setprecision(3) << ", probes " << 100.0 * sum.probeShare / puzzles
+                  << "% of masked, backtracks " << std::setprecision(1) << sum.backtracks / puzzles << "\n";
+    }
+
+    bool parseObjective(const char* spec, Objective& objective)
+    {
+        std::stringstream parts(spec);
+        std::string value;
+        double* weights[] = {&objective.fail, &objective.probes, &objective.backtracks};
+        for (double* weight : weights) {
+            if (!std::getline(parts, value, ',')) return false;
+            *weight = std::stod(value);
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::ios::sync_with_stdio(false);
+
+    std::string startPath;
+    Objective objective;
+    long long nodeLimit = 200000;
+    double holdoutShare = 0.25;
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--start=", 8) == 0) {
+            startPath = argv[i] + 8;
+        } else if (std::strncmp(argv[i], "--objective=", 12) == 0) {
+            if (!parseObjective(argv[i] + 12, objective)) {
+                std::cerr << "Error: --objective needs three weights, e.g. --objective=10,1,0.1\n";
+                return 1;
+            }
+        } else if (std::strncmp(argv[i], "--node-limit=", 13) == 0) {
+            nodeLimit = std::clamp(std::atoll(argv[i] + 13), 1LL, (long long)UINT32_MAX);
+        } else if (std::strncmp(argv[i], "--holdout=", 10) == 0) {
+            holdoutShare = std::clamp(std::atof(argv[i] + 10), 0.0, 0.9);
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+
+    int numPuzzles = argc >= 2 ? std::stoi(argv[1]) : 100;
+    double maskingPercentage = argc >= 3 ? std::stod(argv[2]) : 0.3;
+    double probeBudgetPercent = argc >= 4 ? std::stod(argv[3]) : 0.5;
+    std::string outputFileName = argc >= 5 ? argv[4] : "tuned_params.txt";
+    int candidateCount = argc >= 6 ? std::max(2, std::stoi(argv[5])) : 48;
+    int numThreads = argc >= 7 ? std::stoi(argv[6]) : 0;
+    unsigned int seed = argc >= 8 ? std::stoul(argv[7]) : 12345u;
+    if (numThreads <= 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    SolverParameters start;
+    if (!startPath.empty()) {
+        std::string error;
+        if (!start.load(startPath, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+    }
+
+    auto corpus = PuzzleManager::loadCorpus("puzzles.txt", numPuzzles);
+    if (corpus.size() < 2) {
+        std::cerr << "Error: tuning needs at least two puzzles, one of them held out\n";
+        return 1;
+    }
+    std::vector<Graph> boards;
+    PuzzleManager::maskCorpus(corpus, boards, maskingPercentage, seed);
+    size_t puzzleCount = boards.size();
+    size_t heldOut = std::clamp<size_t>((size_t)std::lround(puzzleCount * holdoutShare), 1, puzzleCount - 1);
+    size_t tuneCount = puzzleCount - heldOut;
+
+    // Early rounds see a few boards, so they are taken in a shuffled order to mix the sizes.
+    // The last heldOut positions are never used to choose between candidates
+    std::vector<size_t> order(puzzleCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937 rng(seed);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    // Candidate 0 is the starting point; two in three of the rest are drawn near it
+    std::vector<Candidate> candidates(candidateCount);
+    for (int c = 0; c < candidateCount; c++) {
+        candidates[c].parameters = c == 0 ? start : sample(start, c % 3 != 0, rng);
+        candidates[c].outcomes.resize(puzzleCount);
+    }
+
+    // Enough rounds to get down to one candidate, the last on about all the tuning puzzles
+    int rounds = 0;
+    for (int left = candidateCount; left > 1; left = std::max(1, left / eta)) rounds++;
+    size_t puzzles = tuneCount;
+    for (int r = 1; r < rounds; r++) puzzles = std::max<size_t>(1, puzzles / eta);
+    puzzles = std::min(tuneCount, std::max<size_t>(puzzles, 3));
+
+    std::cout << "Tuning " << SolverParameters::fieldCount << " parameters: " << candidateCount
+              << " candidates over " << tuneCount << " puzzles, " << heldOut << " held out (masking "
+              << maskingPercentage * 100 << "%, budget " << probeBudgetPercent * 100 << "%, " << nodeLimit
+              << " nodes per solve, " << numThreads << " threads)\n";
+
+    auto tuneStart = std::chrono::steady_clock::now();
+    std::vector<size_t> survivors(candidateCount);
+    std::iota(survivors.begin(), survivors.end(), 0);
+    for (int round = 1; survivors.size() > 1; round++) {
+        evaluate(candidates, survivors, 0, puzzles, boards, order, probeBudgetPercent, nodeLimit, numThreads);
+        for (size_t c : survivors) {
+            candidates[c].cost = cost(candidates[c], 0, puzzles, objective);
+        }
+        std::stable_sort(survivors.begin(), survivors.end(),
+                         [&](size_t a, size_t b) { return candidates[a].cost < candidates[b].cost; });
+
+        std::cout << "Round " << round << ": " << survivors.size() << " candidates on " << puzzles
+                  << " puzzles, best cost " << std::fixed << std::setprecision(4)
+                  << candidates[survivors.front()].cost << ", median "
+                  << candidates[survivors[survivors.size() / 2]].cost << "\n";
+
+        survivors.resize(std::max<size_t>(1, survivors.size() / eta));
+        puzzles = std::min(tuneCount, puzzles * eta);
+    }
+
+    // The winner was picked on the tuning puzzles, so it is judged against the starting
+    // point on the held-out ones; its cost there is the one reported and saved
+    size_t winner = survivors.front();
+    evaluate(candidates, {0, winner}, 0, puzzleCount, boards, order, probeBudgetPercent, nodeLimit, numThreads);
+    candidates[0].cost = cost(candidates[0], tuneCount, puzzleCount, objective);
+    candidates[winner].cost = cost(candidates[winner], tuneCount, puzzleCount, objective);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - tuneStart).count();
+    const char* startLabel = startPath.empty() ? "defaults" : "start";
+
+    std::cout << "\nTuning puzzles (" << tuneCount << "), after " << std::setprecision(1) << seconds << " s:\n";
+    printResult(startLabel, candidates[0], 0, tuneCount, objective);
+    printResult("tuned", candidates[winner], 0, tuneCount, objective);
+    std::cout << "Held-out puzzles (" << heldOut << "):\n";
+    printResult(startLabel, candidates[0], tuneCount, puzzleCount, objective);
+    printResult("tuned", candidates[winner], tuneCount, puzzleCount, objective);
+    const Candidate& best = candidates[winner].cost < candidates[0].cost ? candidates[winner] : candidates[0];
+    if (&best == &candidates[0]) {
+        std::cout << "The winner did not beat the starting point on the held-out puzzles; writing the starting point unchanged\n";
+    } else {
+        for (int i = 0; i < SolverParameters::fieldCount; i++) {
+            if (best.parameters.get(i) != start.get(i)) {
+                std::cout << "  " << std::left << std::setw(26) << SolverParameters::fields[i].name << std::right
+                          << std::setprecision(4) << std::setw(10) << start.get(i) << " -> " << best.parameters.get(i)
+                          << "\n";
+            }
+        }
+    }
+
+    std::ostringstream comment;
+    comment << std::setprecision(6) << "tune.out: " << puzzleCount << " puzzles, " << heldOut << " held out, masking "
+            << maskingPercentage << ", budget " << probeBudgetPercent << ", seed " << seed << ", " << nodeLimit
+            << " nodes per solve, objective " << objective.fail << "," << objective.probes << ","
+            << objective.backtracks << "\n"
+            << "held-out cost " << best.cost << " (starting point " << candidates[0].cost << ")";
+    if (!best.parameters.save(outputFileName, comment.str())) {
+        std::cerr << "Error: Could not write " << outputFileName << "\n";
+        return 1;
+    }
+    std::cout << "Wrote " << outputFileName << " (use with --params=" << outputFileName << ")\n";
+    return 0;
+}
@@ -0,0 +1,234 @@
+#include "../include/queens.h"
+#include "../include/PuzzleSolver.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Everything a handle needs lives in the handle. Exceptions never cross the C boundary:
+// each entry point turns them into QUEENS_ERR_INTERNAL with the message kept for
+// queens_last_error.
+struct queens_solver
+{
+    std::mutex mutex;
+    std::shared_ptr<const PuzzleGrid> board;
+    bool premasked = false;
+    double maskingFraction = 0.0;
+    unsigned int maskingSeed = 12345u;
+    double probeBudgetFraction = 0.5;
+    ProbeStrategy strategy = ProbeStrategy::LOCAL_HEURISTIC;
+    unsigned int strategySeed = 5489u;
+    double deadlineMillis = 0.0;
+
+    // The last solve; the solver refers to the graph, so they are replaced together
+    std::unique_ptr<Graph> graph;
+    std::unique_ptr<PuzzleSolver> solver;
+    PuzzleStatistics stats;
+    bool hasResult = false;
+
+    std::string error;
+
+    int fail(int status, const std::string& message)
+    {
+        error = message;
+        return status;
+    }
+};
+
+namespace {
+    template <typename Body>
+    int guarded(queens_solver* handle, Body body)
+    {
+        if (!handle) return QUEENS_ERR_ARGUMENT;
+        std::lock_guard<std::mutex> lock(handle->mutex);
+        handle->error.clear();
+        try {
+            return body(*handle);
+        } catch (const std::exception& e) {
+            return handle->fail(QUEENS_ERR_INTERNAL, e.what());
+        } catch (...) {
+            return handle->fail(QUEENS_ERR_INTERNAL, "unknown error");
+        }
+    }
+
+    bool isFraction(double value)
+    {
+        return value >= 0.0 && value <= 1.0;
+    }
+}
+
+int queens_abi_version(void)
+{
+    return QUEENS_ABI_VERSION;
+}
+
+queens_solver* queens_create(void)
+{
+    try {
+        return new queens_solver();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void queens_destroy(queens_solver* solver)
+{
+    delete solver;
+}
+
+int queens_load_board(queens_solver* solver, const int* colours, int n)
+{
+    return guarded(solver, [&](queens_solver& handle) {
+        if (!colours || n < 1) {
+            return handle.fail(QUEENS_ERR_ARGUMENT, "board must be a non-empty n*n array");
+        }
+        auto board = std::make_shared<PuzzleGrid>(n, std::vector<int>(n));
+        bool premasked = false;
+        for (int row = 0; row < n; row++) {
+            for (int col = 0; col < n; col++) {
+                int colour = colours[row * n + col];
+                if (colour != -1 && (colour < 1 || colour > n)) {
+                    return handle.fail(QUEENS_ERR_ARGUMENT, "colour " + std::to_string(colour) + " at row " +
+                                       std::to_string(row) + ", column " + std::to_string(col) +
+                                       " is outside 1.." + std::to_string(n) + " (or -1)");
+                }
+                (*board)[row][col] = colour;
+                premasked = premasked || colour == -1;
+            }
+        }
+        handle.board = std::move(board);
+        handle.premasked = premasked;
+        handle.solver.reset();
+        handle.graph.reset();
+        handle.hasResult = false;
+        return (int)QUEENS_OK;
+    });
+}
+
+int queens_set_masking(queens_solver* solver, double fraction, unsigned int seed)
+{
+    return guarded(solver, [&](queens_solver& handle) {
+        if (!isFraction(fraction)) return handle.fail(QUEENS_ERR_ARGUMENT, "masking must be within 0..1");
+        handle.maskingFraction = fraction;
+        handle.maskingSeed = seed;
+        return (int)QUEENS_OK;
+    });
+}
+
+int queens_set_probe_budget(queens_solver* solver, double fraction)
+{
+    return guarded(solver, [&](queens_solver& handle) {
+        if (!isFraction(fraction)) return handle.fail(QUEENS_ERR_ARGUMENT, "probe budget must be within 0..1");
+        handle.probeBudgetFraction = fraction;
+        return (int)QUEENS_OK;
+    });
+}
+
+int queens_set_strategy(queens_solver* solver, queens_strategy strategy, unsigned int seed)
+{
+    return guarded(solver, [&](queens_solver& handle) {
+        if (strategy != QUEENS_STRATEGY_HEURISTIC && strategy != QUEENS_STRATEGY_MONTE_CARLO) {
+            return handle.fail(QUEENS_ERR_ARGUMENT, "unknown strategy");
+        }
+        handle.strategy = strategy == QUEENS_STRATEGY_MONTE_CARLO ? ProbeStrategy::MONTE_CARLO
+                                                                  : ProbeStrategy::LOCAL_HEURISTIC;
+        handle.strategySeed = seed;
+        return (int)QUEENS_OK;
+    });
+}
+
+int queens_set_deadline_ms(queens_solver* solver, double milliseconds)
+{
+    return guarded(solver, [&](queens_solver& handle) {
+        handle.deadlineMillis = std::max(0.0, milliseconds);
+        return (int)QUEENS_OK;
+    });
+}
+
+int queens_solve(queens_solver* solver)
+{
+    return guarded(solver, [&](queens_solver& handle) {
+        if (!handle.board) return handle.fail(QUEENS_ERR_NO_BOARD, "no board loaded");
+
+        // Solver before graph: the solver holds a reference to it
+        handle.solver.reset();
+        handle.hasResult = false;
+        if (handle.premasked) {
+            handle.graph.reset(new Graph(handle.board, *handle.board));
+        } else {
+            handle.graph.reset(new Graph(handle.board, handle.maskingFraction, handle.maskingSeed));
+        }
+        handle.solver.reset(new PuzzleSolver(*handle.graph));
+        // One sampling thread: the caller decides how many solves run in parallel
+        handle.solver->setProbeStrategy(handle.strategy, 256, 1, handle.strategySeed);
+        if (handle.deadlineMillis > 0.0) {
+            auto limit = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double, std::milli>(handle.deadlineMillis));
+            handle.solver->setDeadline(std::chrono::steady_clock::now() + limit);
+        }
+
+        // Without the full colours there is nothing to answer a probe with
+        int n = handle.graph->getSize();
+        bool solved = handle.solver->solvePuzzle(n, handle.premasked ? 0.0 : handle.probeBudgetFraction);
+        handle.stats = handle.solver->collectStatistics(0, solved, {});
+        handle.hasResult = true;
+        return solved ? 1 : 0;
+    });
+}
+
+int queens_get_queens(queens_solver* solver, int* columns, int n)
+{
+    return guarded(solver, [&](queens_solver& handle) {
+        if (!handle.hasResult) return handle.fail(QUEENS_ERR_NO_RESULT, "nothing solved yet");
+        if (!columns || n < 0) return handle.fail(QUEENS_ERR_ARGUMENT, "columns must hold n entries");
+        int size = handle.graph->getSize();
+        int placed = 0;
+        for (int row = 0; row < size; row++) {
+            int col = handle.graph->queenColumn(row);
+            if (col >= 0) placed++;
+            if (row < n) columns[row] = col;
+        }
+        return placed;
+    });
+}
+
+int queens_get_stats(queens_solver* solver, queens_stats* stats, size_t size)
+{
+    return guarded(solver, [&](queens_solver& handle) {
+        if (!handle.hasResult) return handle.fail(QUEENS_ERR_NO_RESULT, "nothing solved yet");
+        if (!stats) return handle.fail(QUEENS_ERR_ARGUMENT, "stats must not be null");
+
+        const PuzzleStatistics& s = handle.stats;
+        queens_stats out;
+        out.solved = s.solved;
+        out.timed_out = s.timedOut;
+        out.grid_size = s.gridSize;
+        out.queens_placed = s.queensPlaced;
+        out.probes_used = s.probesUsed;
+        out.probe_budget = s.probeBudget;
+        out.inferences = s.inferences;
+        out.backtracks = s.backtracks;
+        out.initial_masked_cells = s.initialMaskedCells;
+        out.cells_revealed = s.cellsRevealed;
+        out.solve_ms = s.solveMillis;
+        out.masking_ms = s.maskingMillis;
+        out.inference_ms = s.inferenceMillis;
+        out.probe_selection_ms = s.probeSelectionMillis;
+        out.probe_wait_ms = s.probeWaitMillis;
+        out.search_ms = s.searchMillis;
+
+        // An older caller's struct is a prefix of this one
+        std::memcpy(stats, &out, std::min(size, sizeof(out)));
+        return (int)QUEENS_OK;
+    });
+}
+
+const char* queens_last_error(queens_solver* solver)
+{
+    if (!solver) return "null handle";
+    std::lock_guard<std::mutex> lock(solver->mutex);
+    return solver->error.c_str();
+}